@@ -0,0 +1,283 @@
+//
+//  charge_control_bench.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+// Drives the charge controller against the fake charger (cc_fake_*): checks
+// its state transitions, then times cc_step. Not part of the app target;
+// build and run from the repository root:
+//
+//   cc -O2 -IBrewCap Benchmarks/charge_control_bench.c BrewCap/charge_control.c
+//      BrewCap/charge_schedule.c BrewCap/thermal_model.c
+//      BrewCap/unplug_model.c -lm
+//   ./a.out
+//
+// Exits non-zero if any check fails.
+
+#include "charge_control.h"
+#include <stdio.h>
+#include <time.h>
+
+static int g_failures;
+
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+      g_failures++;                                                            \
+    }                                                                          \
+  } while (0)
+
+static pdev_sample_t sample(int64_t t_ms, int level, int plugged, int temp_cc) {
+  pdev_sample_t s = {0};
+  s.t_ms = t_ms;
+  s.level = level;
+  s.plugged = (uint8_t)plugged;
+  s.temp_cc = temp_cc;
+  s.valid = 1;
+  return s;
+}
+
+// A battery on AC that charges at 2 A unless the fake really holds the
+// charger off
+static pdev_sample_t battery(int64_t t_ms, double level, const cc_fake_t *f) {
+  pdev_sample_t s = sample(t_ms, (int)level, 1, 3000);
+  s.charging = !cc_fake_inhibited(f) && level < 100;
+  s.amperage_ma = s.charging ? 2000 : 0;
+  return s;
+}
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Charging -> Holding -> Thermal -> Charging, auto-off, Travel, Fault
+static void check_states(void) {
+  cc_fake_t *f = cc_fake_create();
+  cc_actuator_t a;
+  cc_fake_actuator(f, 1, &a);
+  cc_config_t c = {.armed = 1,
+                   .sailing = 1,
+                   .limit = 80,
+                   .auto_pause_low = 1,
+                   .low_level = 20,
+                   .thermal_inhibit_cc = 4500,
+                   .thermal_resume_cc = 4200};
+  cc_t *cc = cc_create(&c, a);
+  cc_output_t o;
+  pdev_sample_t s;
+
+  s = sample(0, 70, 1, 3000);
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_CHARGING && !o.inhibited && cc_fake_writes(f) == 0);
+  s = sample(1000, 80, 1, 3000);
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_HOLDING && o.verifying && cc_fake_inhibited(f));
+  s = sample(2000, 81, 1, 3000);
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_HOLDING && o.inhibited && o.notices == CC_NOTE_PAUSED);
+  s = sample(3000, 81, 1, 4600);
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_INHIBITED_THERMAL && cc_fake_writes(f) == 1);
+  s = sample(4000, 79, 1, 4300); // between resume and inhibit
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_INHIBITED_THERMAL);
+  s = sample(5000, 79, 1, 4100);
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_CHARGING && !cc_fake_inhibited(f));
+
+  s = sample(7000, 19, 0, 3000);
+  cc_step(cc, &s, &o);
+  CHECK(o.notices & CC_NOTE_SAILING_AUTO_OFF);
+  s = sample(8000, 90, 1, 3000);
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_CHARGING); // Sailing Mode is off now
+
+  c.travel_until_ms = 20000;
+  cc_configure(cc, &c);
+  cc_step(cc, NULL, &o);
+  CHECK(o.state == CC_TRAVEL);
+  s = sample(21000, 90, 1, 3000);
+  cc_step(cc, &s, &o);
+  CHECK((o.notices & CC_NOTE_TRAVEL_EXPIRED) && o.state == CC_HOLDING);
+
+  // Failing writes: Fault, no writes while resting, then recovery
+  s = sample(22000, 70, 1, 3000);
+  cc_fake_fail(f, 100);
+  for (int i = 0; i < CC_FAULT_AFTER; i++) {
+    s.t_ms += 1000;
+    cc_step(cc, &s, &o);
+  }
+  CHECK(o.state == CC_FAULT && (o.notices & CC_NOTE_FAULT));
+  int64_t writes = cc_fake_writes(f);
+  s.t_ms += 1000;
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_FAULT && cc_fake_writes(f) == writes);
+  cc_fake_fail(f, 0);
+  s.t_ms += CC_FAULT_RETRY_MS;
+  cc_step(cc, &s, &o);
+  CHECK(o.state == CC_CHARGING && (o.notices & CC_NOTE_RECOVERED));
+
+  pdev_sample_t invalid = {0};
+  cc_step(cc, &invalid, &o);
+  CHECK(o.state == CC_CHARGING);
+  cc_free(cc);
+  cc_fake_destroy(f);
+}
+
+// A mechanism that takes the write but leaves the current flowing is
+// refuted, the next is tried, and the records carry over to a new controller
+static void check_verification(void) {
+  cc_fake_t *f = cc_fake_create();
+  cc_actuator_t a;
+  cc_fake_actuator(f, 4, &a);
+  cc_fake_ignore(f, 0);
+  cc_fake_reject(f, 1);
+  cc_config_t c = {
+      .armed = 1, .sailing = 1, .limit = 80, .band_below = 3, .low_level = 20};
+  cc_t *cc = cc_create(&c, a);
+  cc_output_t o;
+  double level = 79;
+  int64_t t = 0;
+  uint32_t seen = 0;
+  for (int i = 0; i < 30; i++) {
+    t += 10000;
+    pdev_sample_t s = battery(t, level, f);
+    cc_step(cc, &s, &o);
+    seen |= o.notices;
+    level += cc_fake_inhibited(f) ? -10.0 / 360 : 10.0 / 120;
+  }
+  cc_mechanism_t m[CC_MAX_MECHANISMS];
+  int n = cc_mechanisms(cc, m, CC_MAX_MECHANISMS);
+  CHECK(n == 4 && o.inhibited && cc_state(cc) == CC_HOLDING);
+  CHECK((seen & CC_NOTE_INEFFECTIVE) && (seen & CC_NOTE_PAUSED));
+  CHECK(m[0].refuted == 1 && m[2].confirmed == 1);
+
+  cc_fake_t *f2 = cc_fake_create();
+  cc_fake_ignore(f2, 0);
+  cc_fake_reject(f2, 1);
+  cc_fake_actuator(f2, 4, &a);
+  cc_t *cc2 = cc_create(&c, a);
+  cc_set_mechanisms(cc2, m, n);
+  level = 79;
+  seen = 0;
+  for (int i = 0; i < 20; i++) {
+    t += 10000;
+    pdev_sample_t s = battery(t, level, f2);
+    cc_step(cc2, &s, &o);
+    seen |= o.notices;
+    level += cc_fake_inhibited(f2) ? -10.0 / 360 : 10.0 / 120;
+  }
+  CHECK(o.inhibited && !(seen & CC_NOTE_INEFFECTIVE));
+  CHECK(cc_fake_writes(f2) <= 2); // straight to the mechanism that works
+  cc_free(cc2);
+  cc_fake_destroy(f2);
+  cc_free(cc);
+  cc_fake_destroy(f);
+}
+
+// A mechanism marked unavailable is skipped without a write, though it would
+// have been tried first
+static void check_unavailable(void) {
+  cc_fake_t *f = cc_fake_create();
+  cc_actuator_t a;
+  cc_fake_actuator(f, 2, &a);
+  cc_fake_ignore(f, 0);
+  cc_config_t c = {
+      .armed = 1, .sailing = 1, .limit = 80, .band_below = 3, .low_level = 20};
+  cc_t *cc = cc_create(&c, a);
+  cc_set_unavailable(cc, 1u << 0);
+  cc_output_t o;
+  uint32_t seen = 0;
+  double level = 79;
+  for (int64_t t = 10000; t <= 200000; t += 10000) {
+    pdev_sample_t s = battery(t, level, f);
+    cc_step(cc, &s, &o);
+    seen |= o.notices;
+    level += cc_fake_inhibited(f) ? -10.0 / 360 : 10.0 / 120;
+  }
+  CHECK(o.inhibited && o.mechanism == 1 && !(seen & CC_NOTE_INEFFECTIVE));
+  CHECK(cc_fake_writes(f) == 1);
+  cc_free(cc);
+  cc_fake_destroy(f);
+}
+
+// Holding at the limit for a day: the sailing band and dwell set how often
+// the charger is written
+static void bench_hysteresis(int band_below, int64_t dwell_ms) {
+  cc_fake_t *f = cc_fake_create();
+  cc_actuator_t a;
+  cc_fake_actuator(f, 1, &a);
+  cc_config_t c = {.armed = 1,
+                   .sailing = 1,
+                   .limit = 80,
+                   .low_level = 20,
+                   .band_below = (uint8_t)band_below,
+                   .min_dwell_ms = dwell_ms};
+  cc_t *cc = cc_create(&c, a);
+  cc_output_t o;
+  double level = 70;
+  for (int64_t t = 0; t < 24 * 3600000LL; t += 10000) {
+    pdev_sample_t s = sample(t, (int)level, 1, 3000);
+    cc_step(cc, &s, &o);
+    level += cc_fake_inhibited(f) ? -10.0 / 180 : 10.0 / 120;
+  }
+  cc_stats_t st;
+  cc_stats(cc, &st);
+  double hours = (double)st.span_ms / 3600000.0;
+  printf("band -%d%%, dwell %3llds   %5.1f transitions/h  %5.1f writes/h\n",
+         band_below, (long long)(dwell_ms / 1000), st.transitions / hours,
+         st.writes / hours);
+  if (band_below > 0)
+    CHECK(st.writes / hours < 10);
+  cc_free(cc);
+  cc_fake_destroy(f);
+}
+
+static void bench_step(void) {
+  cc_fake_t *f = cc_fake_create();
+  cc_actuator_t a;
+  cc_fake_actuator(f, 1, &a);
+  cc_config_t c = {.armed = 1,
+                   .sailing = 1,
+                   .limit = 80,
+                   .low_level = 20,
+                   .band_below = 3,
+                   .thermal_inhibit_cc = 4500,
+                   .thermal_resume_cc = 4200};
+  cc_t *cc = cc_create(&c, a);
+  cc_output_t o;
+  const int n = 10000000;
+  double t0 = now_seconds();
+  for (int i = 0; i < n; i++) {
+    pdev_sample_t s = sample(i * 1000LL, 75 + i % 10, 1, 3000 + i % 2000);
+    cc_step(cc, &s, &o);
+  }
+  double dt = now_seconds() - t0;
+  cc_stats_t st;
+  cc_stats(cc, &st);
+  printf("cc_step: %.1f ns/step over %d steps, %lld transitions\n",
+         dt / n * 1e9, n, (long long)st.transitions);
+  cc_free(cc);
+  cc_fake_destroy(f);
+}
+
+int main(void) {
+  check_states();
+  check_verification();
+  check_unavailable();
+  bench_hysteresis(0, 0);
+  bench_hysteresis(3, 0);
+  bench_hysteresis(3, 300000);
+  bench_step();
+  if (g_failures) {
+    fprintf(stderr, "%d checks failed\n", g_failures);
+    return 1;
+  }
+  puts("all checks passed");
+  return 0;
+}
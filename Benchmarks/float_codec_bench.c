@@ -0,0 +1,137 @@
+//
+//  float_codec_bench.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+// Size and speed of the XOR float codec on synthetic battery traces. Not
+// part of the app target; build and run from the repository root:
+//
+//   cc -O2 -IBrewCap Benchmarks/float_codec_bench.c BrewCap/float_codec.c -lm
+//   ./a.out [samples]
+//
+// Every decode is checked bit for bit against the input (the check is inside
+// the timed loop, as a reader would touch each value); a mismatch exits
+// non-zero.
+
+#include "float_codec.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RUNS 5 // best of
+
+typedef struct {
+  const char *name;
+  double (*value)(long i);
+} trace_t;
+
+// One sample a second, as the telemetry store records them
+static double temperature(long i) {
+  return round((30.0 + 3.0 * sin(i / 3600.0)) * 10.0) / 10.0;
+}
+
+static double watts(long i) {
+  double w = 8.0 + 4.0 * sin(i / 600.0) + ((i * 31) % 17) / 10.0;
+  return (float)(round(w * 100.0) / 100.0); // power_w is a float
+}
+
+static double voltage(long i) {
+  return 12.6 - i * 1e-5 + 0.002 * ((i * 7919) % 5);
+}
+
+static double constant(long i) {
+  (void)i;
+  return 4.25;
+}
+
+static const trace_t k_traces[] = {
+    {"temperature", temperature},
+    {"watts", watts},
+    {"voltage", voltage},
+    {"constant", constant},
+};
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int run(const trace_t *t, long n) {
+  double *values = malloc((size_t)n * sizeof(double));
+  if (values == NULL)
+    return -1;
+  for (long i = 0; i < n; i++)
+    values[i] = t->value(i);
+
+  fxor_encoder_t enc;
+  fxor_encoder_init(&enc);
+  double encode_s = 1e9, decode_s = 1e9;
+  for (int r = 0; r < RUNS; r++) {
+    fxor_encoder_reset(&enc);
+    double t0 = now_seconds();
+    for (long i = 0; i < n; i++) {
+      if (fxor_append(&enc, values[i]) != 0) {
+        fprintf(stderr, "bench: %s: encoder out of memory\n", t->name);
+        fxor_encoder_free(&enc);
+        free(values);
+        return -1;
+      }
+    }
+    double dt = now_seconds() - t0;
+    if (dt < encode_s)
+      encode_s = dt;
+  }
+
+  int rc = 0;
+  for (int r = 0; r < RUNS && rc == 0; r++) {
+    fxor_decoder_t dec;
+    fxor_decoder_init(&dec, enc.buf, fxor_bytes(&enc), enc.count);
+    long got = 0;
+    double v;
+    double t0 = now_seconds();
+    while (fxor_next(&dec, &v) == 0) {
+      if (got >= n || memcmp(&v, &values[got], sizeof(v)) != 0) {
+        fprintf(stderr, "bench: %s: mismatch at sample %ld\n", t->name, got);
+        rc = -1;
+        break;
+      }
+      got++;
+    }
+    double dt = now_seconds() - t0;
+    if (rc == 0 && got != n) {
+      fprintf(stderr, "bench: %s: decoded %ld of %ld\n", t->name, got, n);
+      rc = -1;
+    }
+    if (dt < decode_s)
+      decode_s = dt;
+  }
+
+  if (rc == 0)
+    printf("%-12s %6.2f B/sample  %6.1f%% of raw  encode %6.1f M/s  "
+           "decode %6.1f M/s\n",
+           t->name, (double)fxor_bytes(&enc) / n,
+           100.0 * fxor_bytes(&enc) / ((double)n * sizeof(double)),
+           n / encode_s / 1e6, n / decode_s / 1e6);
+  fxor_encoder_free(&enc);
+  free(values);
+  return rc;
+}
+
+int main(int argc, char **argv) {
+  long n = argc > 1 ? atol(argv[1]) : 1000000;
+  if (n <= 0) {
+    fprintf(stderr, "usage: %s [samples]\n", argv[0]);
+    return 2;
+  }
+  printf("%ld samples per trace, best of %d\n", n, RUNS);
+  int rc = 0;
+  for (size_t i = 0; i < sizeof(k_traces) / sizeof(k_traces[0]); i++)
+    if (run(&k_traces[i], n) != 0)
+      rc = 1;
+  return rc;
+}
@@ -19,8 +19,7 @@ class AppDelegate: NSObject, NSApplicationDelegate {
     // Feature 27: Global Hotkey
     private var globalHotkeyMonitor: Any?
 
-    // Feature 47: Pulse timer
-    private var pulseTimer: Timer?
+    // Feature 47: Pulse (a scheduler task, only registered while low)
     private var pulsePhase: Bool = false
 
     func applicationDidFinishLaunching(_ notification: Notification) {
@@ -37,6 +36,7 @@ class AppDelegate: NSObject, NSApplicationDelegate {
             .sink { [weak self] _ in
                 self?.updateMenuBarIcon()
                 self?.refreshMenuInfo()
+                self?.updatePulseTask()
             }
             .store(in: &cancellables)
 
@@ -46,6 +46,7 @@ class AppDelegate: NSObject, NSApplicationDelegate {
             .sink { [weak self] _ in
                 self?.updateMenuBarIcon()
                 self?.refreshMenuInfo()
+                self?.updatePulseTask()
             }
             .store(in: &cancellables)
 
@@ -74,7 +75,7 @@ class AppDelegate: NSObject, NSApplicationDelegate {
             .store(in: &cancellables)
 
         // Feature 47: Low battery pulse
-        startPulseMonitor()
+        updatePulseTask()
 
         // Feature 27: Register global hotkey ⌘⇧B
         registerGlobalHotkey()
@@ -98,13 +99,19 @@ class AppDelegate: NSObject, NSApplicationDelegate {
 
     // MARK: - Feature 47: Low Battery Pulse
 
-    private func startPulseMonitor() {
-        pulseTimer = Timer.scheduledTimer(withTimeInterval: 1.5, repeats: true) { [weak self] _ in
-            guard let self = self else { return }
-            if self.batteryManager.batteryLevel <= self.batteryManager.lowBatteryThreshold && !self.batteryManager.isPluggedIn {
-                self.pulsePhase.toggle()
-                self.updateMenuBarIcon()
+    /// The pulse only needs a 1.5 s cadence while the battery is low and
+    /// unplugged; the rest of the time it costs no wakeups at all.
+    private func updatePulseTask() {
+        let low = batteryManager.batteryLevel <= batteryManager.lowBatteryThreshold && !batteryManager.isPluggedIn
+        if low && !TaskScheduler.shared.isScheduled("pulse") {
+            TaskScheduler.shared.schedule("pulse", every: 1.5, tolerance: 0.1) { [weak self] in
+                self?.pulsePhase.toggle()
+                self?.updateMenuBarIcon()
             }
+        } else if !low && TaskScheduler.shared.isScheduled("pulse") {
+            TaskScheduler.shared.cancel("pulse")
+            pulsePhase = false
+            updateMenuBarIcon()
         }
     }
 
@@ -176,6 +183,9 @@ class AppDelegate: NSObject, NSApplicationDelegate {
         if batteryManager.sailingModeEnabled {
             tooltip += "\nSailing Mode: ✓ (Limit: \(Int(batteryManager.chargeLimit))%)"
         }
+        if batteryManager.chargeState != CC_CHARGING {
+            tooltip += "\nCharge Control: \(String(cString: cc_state_name(batteryManager.chargeState)))"
+        }
         button.toolTip = tooltip
 
         // Feature 48: Notification badge dot
@@ -544,10 +554,13 @@ class AppDelegate: NSObject, NSApplicationDelegate {
     }
 
     @objc func quitApp() {
-        if batteryManager.chargingInhibited {
+        // Holding covers an inhibit that was written but not yet verified
+        let state = batteryManager.chargeState
+        if batteryManager.chargingInhibited || state == CC_HOLDING || state == CC_INHIBITED_THERMAL {
             _ = SMCClient.enableCharging()
         }
-        batteryManager.logEvent("BrewCap quit")
+        batteryManager.saveLearnedState()
+        batteryManager.logEvent(EV_QUIT)
         NSApplication.shared.terminate(nil)
     }
 }
@@ -32,49 +32,113 @@ class BatteryManager: ObservableObject {
     @Published var serialNumber: String = "—"     // Feature 11
     @Published var manufactureDate: String = "—"  // Feature 12
 
+    // Every battery-backed power device (internal, UPS, accessories)
+    @Published var powerDevices: [PowerDevice] = []
+    private var deviceSet: OpaquePointer?
+
+    // Unprivileged SMC reads: platform power rails and die temperatures
+    private var smcCatalog: OpaquePointer?
+    @Published var sensorTemperatures: [(key: String, celsius: Double)] = []
+
     // MARK: - Sailing Mode
 
     @Published var chargeLimit: Double {
         didSet {
-            UserDefaults.standard.set(chargeLimit, forKey: "chargeLimit")
-            if sailingModeEnabled && isPluggedIn { applyChargingControl() }
+            Self.defaults.set(chargeLimit, forKey: "chargeLimit")
+            updateChargeControl()
         }
     }
 
     @Published var sailingModeEnabled: Bool = false {
         didSet {
-            UserDefaults.standard.set(sailingModeEnabled, forKey: "sailingModeEnabled")
+            Self.defaults.set(sailingModeEnabled, forKey: "sailingModeEnabled")
             if sailingModeEnabled { handleSailingModeOn() } else { handleSailingModeOff() }
         }
     }
 
+    /// Sailing hysteresis: hold from limit + above, resume below limit - below
+    @Published var sailingBandAbove: Int {
+        didSet {
+            Self.defaults.set(sailingBandAbove, forKey: "sailingBandAbove")
+            updateChargeControl()
+        }
+    }
+    @Published var sailingBandBelow: Int {
+        didSet {
+            Self.defaults.set(sailingBandBelow, forKey: "sailingBandBelow")
+            updateChargeControl()
+        }
+    }
+    /// Minutes between two charger writes
+    @Published var sailingMinDwell: Double {
+        didSet {
+            Self.defaults.set(sailingMinDwell, forKey: "sailingMinDwell")
+            updateChargeControl()
+        }
+    }
+    /// Top up to 100% shortly before the charger is usually unplugged, as
+    /// learned from charge session history
+    @Published var predictUnplug: Bool {
+        didSet {
+            Self.defaults.set(predictUnplug, forKey: "predictUnplug")
+            updateChargeControl()
+        }
+    }
+    @Published var likelyUnplug: Date? // when an unplug becomes more likely than not
+
+    /// How far ahead heat protection looks; 0 reacts to the measured temperature only
+    @Published var thermalForecastMinutes: Int {
+        didSet {
+            Self.defaults.set(thermalForecastMinutes, forKey: "thermalForecastMinutes")
+            updateChargeControl()
+        }
+    }
+    @Published var temperatureForecast: Double? // °C, thermalForecastMinutes ahead
+
     @Published var chargingInhibited: Bool = false
     @Published var setupNeeded: Bool = false
+    @Published var chargeState: cc_state_t = CC_CHARGING
+
+    // Charging policy runs in the C state machine on its own queue, so a
+    // decision (and the SMC write behind it) never waits on the UI
+    private var chargeControl: OpaquePointer?
+    private let controlQueue = DispatchQueue(label: "BrewCap.chargeControl", qos: .userInitiated)
+
+    /// What the controller has learned, copied out on controlQueue after each
+    /// step and handed to main, so readers never wait behind an actuator write
+    private struct ChargeControlSnapshot {
+        var rates = cs_rates_t()
+        var stats = cc_stats_t()
+        var mechanisms: [cc_mechanism_t] = []
+        var unplug = upm_model_t()
+        var takenMs: Int64 = 0 // every sample the model has seen is older
+    }
+    private var controlSnapshot = ChargeControlSnapshot() // main thread only
 
     // MARK: - Alerts (Features 13–18)
 
     @Published var tempAlertThreshold: Double {
-        didSet { UserDefaults.standard.set(tempAlertThreshold, forKey: "tempAlertThreshold") }
+        didSet { Self.defaults.set(tempAlertThreshold, forKey: "tempAlertThreshold") }
     }
     private var hasNotifiedTempAlert = false
 
     @Published var lowBatteryThreshold: Int {
-        didSet { UserDefaults.standard.set(lowBatteryThreshold, forKey: "lowBatteryThreshold") }
+        didSet { Self.defaults.set(lowBatteryThreshold, forKey: "lowBatteryThreshold") }
     }
     private var hasNotifiedLowBattery = false
 
     @Published var fullChargeNotification: Bool {
-        didSet { UserDefaults.standard.set(fullChargeNotification, forKey: "fullChargeNotification") }
+        didSet { Self.defaults.set(fullChargeNotification, forKey: "fullChargeNotification") }
     }
     private var hasNotifiedFullCharge = false
     private var hasNotifiedCriticalTemp = false
 
     @Published var soundEffectsEnabled: Bool {
-        didSet { UserDefaults.standard.set(soundEffectsEnabled, forKey: "soundEffectsEnabled") }
+        didSet { Self.defaults.set(soundEffectsEnabled, forKey: "soundEffectsEnabled") }
     }
 
     @Published var doNotDisturb: Bool {
-        didSet { UserDefaults.standard.set(doNotDisturb, forKey: "doNotDisturb") }
+        didSet { Self.defaults.set(doNotDisturb, forKey: "doNotDisturb") }
     }
 
     // MARK: - Session Tracking (19–20)
@@ -83,14 +147,28 @@ class BatteryManager: ObservableObject {
     @Published var sessionStartLevel: Int = 0
     @Published var sessionDuration: String = "—"
     @Published var sessionDelta: Int = 0
-    @Published var chargeHistory: [ChargeSession] = []
-    private var sessionTimer: Timer?
+    @Published var chargeHistory: [ChargeSession] = [] // most recent first, UI window only
+    private var sessionLog: OpaquePointer?
+
+    // Per-tick samples in the columnar telemetry store, plus 1m/1h/1d rollups
+    private var telemetry: OpaquePointer?
+    private var rollups: OpaquePointer?
+    private static let visibleSessions = 20
+
+    /// How long telemetry may sit unsynced: 0 = every sample, 1 = balanced, 2 = battery saver
+    @Published var historyDurability: Int {
+        didSet {
+            Self.defaults.set(historyDurability, forKey: "historyDurability")
+            ts_set_durability(telemetry, Self.walPolicy(historyDurability))
+            startHistorySyncTimer()
+        }
+    }
 
     // MARK: - Feature 29: Configurable Monitoring
 
     @Published var monitoringInterval: Double {
         didSet {
-            UserDefaults.standard.set(monitoringInterval, forKey: "monitoringInterval")
+            Self.defaults.set(monitoringInterval, forKey: "monitoringInterval")
             startMonitoring()
         }
     }
@@ -98,7 +176,7 @@ class BatteryManager: ObservableObject {
     // MARK: - Feature 23: Menu Bar Percentage
 
     @Published var showPercentageInMenuBar: Bool {
-        didSet { UserDefaults.standard.set(showPercentageInMenuBar, forKey: "showPercentageInMenuBar") }
+        didSet { Self.defaults.set(showPercentageInMenuBar, forKey: "showPercentageInMenuBar") }
     }
 
     // MARK: - Feature 31: Power Draw (watts)
@@ -124,29 +202,61 @@ class BatteryManager: ObservableObject {
 
     // MARK: - Feature 36: Battery Age
 
+    /// Years of typical use with the same estimated wear
     @Published var batteryAgeYears: Double = 0.0
+    @Published var agingEstimate = age_estimate_t()
+
+    // Calendar and cycle wear, integrated per tick on its own queue and kept
+    // across launches (aging_model.h)
+    private var agingModel = age_model_t()
+    private var agingSavedMs: Int64 = 0
+    private let agingQueue = DispatchQueue(label: "BrewCap.aging", qos: .utility)
 
     // MARK: - Feature 37: Travel Mode
 
     @Published var travelModeEnabled: Bool = false {
         didSet {
-            UserDefaults.standard.set(travelModeEnabled, forKey: "travelModeEnabled")
+            Self.defaults.set(travelModeEnabled, forKey: "travelModeEnabled")
             if travelModeEnabled {
                 savedChargeLimit = chargeLimit
                 chargeLimit = 100
-                travelModeExpiry = Date().addingTimeInterval(travelModeDuration * 3600)
-                logEvent("Travel Mode enabled — limit raised to 100% for \(Int(travelModeDuration))h")
+                travelModeExpiry = Self.now().addingTimeInterval(travelModeDuration * 3600)
+                logEvent(EV_TRAVEL_ON, Int(travelModeDuration))
             } else {
                 if let saved = savedChargeLimit { chargeLimit = saved }
                 travelModeExpiry = nil
-                logEvent("Travel Mode disabled — limit restored to \(Int(chargeLimit))%")
+                logEvent(EV_TRAVEL_OFF, Int(chargeLimit))
             }
+            updateChargeControl()
         }
     }
     @Published var travelModeDuration: Double = 8.0 // hours
     @Published var travelModeExpiry: Date?
     private var savedChargeLimit: Double?
 
+    // MARK: - Full By: at 100% for a departure time
+
+    /// Holds at the limit and starts charging to 100% as late as the
+    /// measured charge rate allows, finishing by fullByDate
+    @Published var fullByEnabled: Bool {
+        didSet {
+            Self.defaults.set(fullByEnabled, forKey: "fullByEnabled")
+            if !fullByEnabled { fullByStart = nil }
+            updateChargeControl()
+        }
+    }
+    @Published var fullByDate: Date {
+        didSet {
+            Self.defaults.set(fullByDate, forKey: "fullByDate")
+            updateChargeControl()
+        }
+    }
+    /// Repeat at the same time a week later once a deadline has passed
+    @Published var fullByWeekly: Bool {
+        didSet { Self.defaults.set(fullByWeekly, forKey: "fullByWeekly") }
+    }
+    @Published var fullByStart: Date? // when charging to 100% begins
+
     // MARK: - Feature 39: Charge Speed
 
     @Published var chargeSpeed: String = "—"
@@ -154,13 +264,16 @@ class BatteryManager: ObservableObject {
     // MARK: - Feature 40: Auto-pause below 20%
 
     @Published var autoPauseLowBattery: Bool {
-        didSet { UserDefaults.standard.set(autoPauseLowBattery, forKey: "autoPauseLowBattery") }
+        didSet {
+            Self.defaults.set(autoPauseLowBattery, forKey: "autoPauseLowBattery")
+            updateChargeControl()
+        }
     }
 
     // MARK: - Feature 41: Charge Complete Chime
 
     @Published var chargeChimeEnabled: Bool {
-        didSet { UserDefaults.standard.set(chargeChimeEnabled, forKey: "chargeChimeEnabled") }
+        didSet { Self.defaults.set(chargeChimeEnabled, forKey: "chargeChimeEnabled") }
     }
     private var hasPlayedChargeChime = false
 
@@ -171,7 +284,7 @@ class BatteryManager: ObservableObject {
     // MARK: - Feature 43: Menu Bar Display Mode
 
     @Published var menuBarDisplayMode: Int {
-        didSet { UserDefaults.standard.set(menuBarDisplayMode, forKey: "menuBarDisplayMode") }
+        didSet { Self.defaults.set(menuBarDisplayMode, forKey: "menuBarDisplayMode") }
     }
 
     // MARK: - Feature 48: Notification Badge
@@ -180,79 +293,101 @@ class BatteryManager: ObservableObject {
 
     // MARK: - Feature 52: Battery Event Log
 
-    @Published var eventLog: [BatteryEvent] = []
+    @Published var eventLog: [BatteryEvent] = [] // newest first, UI window only
+    private var events: OpaquePointer?
+    private static let eventCapacity: UInt32 = 4000
+    private static let visibleEvents = 100
 
-    // MARK: - Feature 54: Daily Battery Snapshots
+    // MARK: - Feature 28: Sleep Gaps
 
-    private var snapshotTimer: Timer?
+    @Published var sleepGaps: [SleepGap] = []
+    private var sleepState: SleepGap.State?
 
     // MARK: - Feature 57: Reduce Motion
 
     @Published var reduceMotion: Bool {
-        didSet { UserDefaults.standard.set(reduceMotion, forKey: "reduceMotion") }
+        didSet { Self.defaults.set(reduceMotion, forKey: "reduceMotion") }
     }
 
     // MARK: - Private
 
-    private var timer: Timer?
     private var hasNotifiedForCurrentCharge = false
 
+    // Plug/unplug events from the C power-source module
+    private var powerSource: OpaquePointer?
+    private var pendingTransition: (online: Bool, date: Date)?
+
     // MARK: - Init
 
     init() {
-        let saved = UserDefaults.standard.double(forKey: "chargeLimit")
+        let saved = Self.defaults.double(forKey: "chargeLimit")
         self.chargeLimit = saved > 0 ? saved : 80.0
 
-        let savedTemp = UserDefaults.standard.double(forKey: "tempAlertThreshold")
+        let savedTemp = Self.defaults.double(forKey: "tempAlertThreshold")
         self.tempAlertThreshold = savedTemp > 0 ? savedTemp : 40.0
 
-        let savedLow = UserDefaults.standard.integer(forKey: "lowBatteryThreshold")
+        let savedLow = Self.defaults.integer(forKey: "lowBatteryThreshold")
         self.lowBatteryThreshold = savedLow > 0 ? savedLow : 20
 
-        self.fullChargeNotification = UserDefaults.standard.bool(forKey: "fullChargeNotification")
-        self.soundEffectsEnabled = UserDefaults.standard.object(forKey: "soundEffectsEnabled") as? Bool ?? true
-        self.doNotDisturb = UserDefaults.standard.bool(forKey: "doNotDisturb")
+        self.fullChargeNotification = Self.defaults.bool(forKey: "fullChargeNotification")
+        self.soundEffectsEnabled = Self.defaults.object(forKey: "soundEffectsEnabled") as? Bool ?? true
+        self.doNotDisturb = Self.defaults.bool(forKey: "doNotDisturb")
 
-        let savedInterval = UserDefaults.standard.double(forKey: "monitoringInterval")
+        let savedInterval = Self.defaults.double(forKey: "monitoringInterval")
         self.monitoringInterval = savedInterval > 0 ? savedInterval : 10.0
 
-        self.showPercentageInMenuBar = UserDefaults.standard.object(forKey: "showPercentageInMenuBar") as? Bool ?? false
+        self.showPercentageInMenuBar = Self.defaults.object(forKey: "showPercentageInMenuBar") as? Bool ?? false
 
         // Feature 40
-        self.autoPauseLowBattery = UserDefaults.standard.object(forKey: "autoPauseLowBattery") as? Bool ?? true
+        self.autoPauseLowBattery = Self.defaults.object(forKey: "autoPauseLowBattery") as? Bool ?? true
 
         // Feature 41
-        self.chargeChimeEnabled = UserDefaults.standard.object(forKey: "chargeChimeEnabled") as? Bool ?? false
+        self.chargeChimeEnabled = Self.defaults.object(forKey: "chargeChimeEnabled") as? Bool ?? false
 
         // Feature 43
-        self.menuBarDisplayMode = UserDefaults.standard.integer(forKey: "menuBarDisplayMode") // 0=%, 1=time, 2=watts
+        self.menuBarDisplayMode = Self.defaults.integer(forKey: "menuBarDisplayMode") // 0=%, 1=time, 2=watts
 
         // Feature 57
-        self.reduceMotion = UserDefaults.standard.bool(forKey: "reduceMotion")
-
-        // Load charge history
-        if let data = UserDefaults.standard.data(forKey: "chargeHistory"),
-           let history = try? JSONDecoder().decode([ChargeSession].self, from: data) {
-            self.chargeHistory = history
-        }
+        self.reduceMotion = Self.defaults.bool(forKey: "reduceMotion")
+
+        self.historyDurability = Self.defaults.object(forKey: "historyDurability") as? Int ?? 1
+        self.sailingBandAbove = Self.defaults.object(forKey: "sailingBandAbove") as? Int ?? 0
+        self.sailingBandBelow = Self.defaults.object(forKey: "sailingBandBelow") as? Int ?? 3
+        self.sailingMinDwell = Self.defaults.object(forKey: "sailingMinDwell") as? Double ?? 5
+        self.predictUnplug = Self.defaults.bool(forKey: "predictUnplug")
+        self.thermalForecastMinutes = Self.defaults.object(forKey: "thermalForecastMinutes") as? Int ?? 10
+        self.fullByEnabled = Self.defaults.bool(forKey: "fullByEnabled")
+        self.fullByWeekly = Self.defaults.bool(forKey: "fullByWeekly")
+        self.fullByDate = Self.defaults.object(forKey: "fullByDate") as? Date
+            ?? Self.nextMorning(hour: 7, minute: 30)
+
+        // Load charge history from the append-only session log
+        self.sessionLog = slog_open(Self.storageURL("sessions.log").path)
+        importLegacyChargeHistory()
+        self.chargeHistory = loadRecentSessions()
 
         // Feature 33: Load capacity snapshots
-        if let data = UserDefaults.standard.data(forKey: "capacitySnapshots"),
+        if let data = Self.defaults.data(forKey: "capacitySnapshots"),
            let snaps = try? JSONDecoder().decode([CapacitySnapshot].self, from: data) {
             self.capacitySnapshots = snaps
         }
 
-        // Feature 52: Load event log
-        if let data = UserDefaults.standard.data(forKey: "eventLog"),
-           let log = try? JSONDecoder().decode([BatteryEvent].self, from: data) {
-            self.eventLog = Array(log.prefix(100))
+        // Feature 28: Load sleep gaps
+        if let data = Self.defaults.data(forKey: "sleepGaps"),
+           let gaps = try? JSONDecoder().decode([SleepGap].self, from: data) {
+            self.sleepGaps = gaps
         }
 
+        // Feature 52: Load event log
+        self.events = elog_open(Self.storageURL("events.log").path, Self.eventCapacity)
+        importLegacyEventLog()
+        self.eventLog = loadRecentEvents()
+
         // Feature 37: Check travel mode expiry
-        self.travelModeEnabled = UserDefaults.standard.bool(forKey: "travelModeEnabled")
+        self.travelModeEnabled = Self.defaults.bool(forKey: "travelModeEnabled")
         if travelModeEnabled {
-            if let expiry = UserDefaults.standard.object(forKey: "travelModeExpiry") as? Date {
-                if Date() > expiry {
+            if let expiry = Self.defaults.object(forKey: "travelModeExpiry") as? Date {
+                if Self.now() > expiry {
                     self.travelModeEnabled = false
                 } else {
                     self.travelModeExpiry = expiry
@@ -260,47 +395,88 @@ class BatteryManager: ObservableObject {
             }
         }
 
-        let savedSailing = UserDefaults.standard.bool(forKey: "sailingModeEnabled")
+        let savedSailing = Self.defaults.bool(forKey: "sailingModeEnabled")
 
+        if let sim = Self.simulator {
+            var backend = pdev_backend_t()
+            bsim_backend(sim, &backend)
+            deviceSet = pdev_open(&backend)
+        } else {
+            deviceSet = pdev_open(nil)
+        }
+        loadAgingModel()
+        telemetry = Self.openTelemetryStore()
+        ts_set_durability(telemetry, Self.walPolicy(historyDurability))
+        startHistorySyncTimer()
+        rollups = Self.openRollups()
+        openSensorCatalog()
         refresh()
         startMonitoring()
+        startPowerSourceEvents()
         requestNotificationPermission()
         registerSleepWakeNotifications()
         startSnapshotTimer() // Feature 54
+        startRetentionTimer()
 
         self.sailingModeEnabled = savedSailing
+        startChargeControl()
 
-        if sailingModeEnabled {
-            DispatchQueue.global(qos: .utility).async { [weak self] in
-                let inhibited = SMCClient.isChargingInhibited()
-                DispatchQueue.main.async { self?.chargingInhibited = inhibited }
-            }
-        }
-
-        logEvent("BrewCap launched")
+        logEvent(EV_LAUNCHED)
     }
 
     deinit {
-        timer?.invalidate()
-        sessionTimer?.invalidate()
-        snapshotTimer?.invalidate()
+        TaskScheduler.shared.cancel("monitor")
+        TaskScheduler.shared.cancel("snapshot")
+        TaskScheduler.shared.cancel("retention")
+        TaskScheduler.shared.cancel("historySync")
+        TaskScheduler.shared.cancel("fullBy")
+        if let cc = chargeControl {
+            controlQueue.async { cc_free(cc) }
+        }
+        psrc_close(powerSource)
+        pdev_close(deviceSet)
+        slog_close(sessionLog)
+        elog_close(events)
+        ts_close(telemetry)
+        rollup_close(rollups)
+        if smcCatalog != nil {
+            smc_catalog_free(smcCatalog)
+            smc_close()
+        }
     }
 
     // MARK: - Monitoring
 
     func startMonitoring() {
-        timer?.invalidate()
-        timer = Timer.scheduledTimer(withTimeInterval: monitoringInterval, repeats: true) { [weak self] _ in
+        TaskScheduler.shared.schedule("monitor", every: monitoringInterval) { [weak self] in
             self?.refresh()
         }
     }
 
     func refresh() {
+        if let sim = Self.simulator {
+            bsim_sync(sim, Int64(Date().timeIntervalSince1970 * 1000))
+        }
         let info = Self.readFullBatteryInfo()
+        let frame = sweepSensors()
+        // Feature 31: Power draw. On AC the battery rail idles while the
+        // system still draws from the adapter, so prefer the SMC total.
+        let watts: Double
+        if let frame = frame, frame.valid & UInt32(SMC_HAS_SYSTEM) != 0 {
+            watts = Double(frame.system_w)
+        } else {
+            watts = abs(Double(info.amperage)) * info.voltage / 1000.0
+        }
+        let sample = Self.telemetrySample(info, watts: watts)
+        let devices = pollPowerDevices(internal: sample)
+        recordTelemetry(sample)
+        stepAgingModel(sample, info)
+        stepChargeControl(sample, adapterWatts: info.isPluggedIn ? info.adapterWatts : 0)
         DispatchQueue.main.async { [weak self] in
             guard let self = self else { return }
 
             let wasPluggedIn = self.isPluggedIn
+            self.powerDevices = devices
 
             self.batteryLevel = info.level
             self.isCharging = info.isCharging
@@ -320,7 +496,10 @@ class BatteryManager: ObservableObject {
             self.timeRemaining = info.timeRemaining
 
             // Feature 31: Power draw
-            self.powerDrawWatts = abs(Double(info.amperage)) * info.voltage / 1000.0
+            self.powerDrawWatts = watts
+            if let frame = frame {
+                self.sensorTemperatures = Self.temperatures(in: frame)
+            }
 
             // Feature 32: Estimated time to full
             self.updateTimeToFull()
@@ -331,42 +510,32 @@ class BatteryManager: ObservableObject {
             // Feature 35: Drain rate tracking
             self.updateDrainRate()
 
-            // Feature 36: Battery age
-            if info.cycleCount > 0 {
-                self.batteryAgeYears = Double(info.cycleCount) / 300.0 // ~300 cycles/year avg
-            }
-
             // Feature 39: Charge speed
             self.updateChargeSpeed()
 
             // Feature 42: Replacement date
             self.updateReplacementDate()
 
-            // Session tracking
+            // Session tracking — use the event timestamp when the power-source
+            // notification saw the transition, the poll time otherwise. The
+            // notifications are the real adapter's, not the simulator's.
+            var transitionDate = Self.now()
+            if Self.simulator == nil, let pending = self.pendingTransition, pending.online == self.isPluggedIn {
+                transitionDate = pending.date
+            }
+            if self.isPluggedIn != wasPluggedIn { self.pendingTransition = nil }
+
             if self.isPluggedIn && !wasPluggedIn {
-                self.startSession()
-                self.logEvent("Charger connected — \(self.batteryLevel)%")
+                self.startSession(at: transitionDate)
+                self.logEvent(EV_CHARGER_CONNECTED, self.batteryLevel)
             } else if !self.isPluggedIn && wasPluggedIn {
-                self.endSession()
-                self.logEvent("Charger disconnected — \(self.batteryLevel)%")
+                self.endSession(at: transitionDate)
+                self.logEvent(EV_CHARGER_DISCONNECTED, self.batteryLevel)
+                self.saveChargeRates()
+                self.saveUnplugModel()
             }
             self.updateSessionDuration()
 
-            // Feature 37: Travel mode auto-revert
-            if self.travelModeEnabled, let expiry = self.travelModeExpiry, Date() > expiry {
-                self.travelModeEnabled = false
-            }
-
-            // Feature 40: Auto-pause Sailing below 20%
-            if self.autoPauseLowBattery && self.sailingModeEnabled && self.batteryLevel < 20 && !self.isPluggedIn {
-                self.sailingModeEnabled = false
-                self.logEvent("Sailing Mode auto-disabled — battery below 20%")
-                self.sendNotification(
-                    title: "⚠️ BrewCap — Sailing Mode Paused",
-                    body: "Battery below 20%. Sailing Mode disabled to preserve charge."
-                )
-            }
-
             // Feature 41: Charge chime
             if self.chargeChimeEnabled && self.isPluggedIn {
                 let target = Int(self.chargeLimit)
@@ -377,10 +546,9 @@ class BatteryManager: ObservableObject {
             }
             if self.batteryLevel < Int(self.chargeLimit) - 5 { self.hasPlayedChargeChime = false }
 
-            // Sailing mode
-            if self.sailingModeEnabled {
-                self.handleSailingCheck()
-            } else {
+            // Sailing mode holds the limit in the charge controller; without
+            // it, just tell the user once
+            if !self.sailingModeEnabled {
                 self.checkOneShotNotification()
             }
 
@@ -439,9 +607,10 @@ class BatteryManager: ObservableObject {
             drainSamples.removeAll()
             return
         }
-        drainSamples.append((date: Date(), level: batteryLevel))
+        let now = Self.now()
+        drainSamples.append((date: now, level: batteryLevel))
         // Keep last 30 minutes of samples
-        let cutoff = Date().addingTimeInterval(-1800)
+        let cutoff = now.addingTimeInterval(-1800)
         drainSamples.removeAll { $0.date < cutoff }
 
         if drainSamples.count >= 2 {
@@ -458,7 +627,7 @@ class BatteryManager: ObservableObject {
 
     func setChargePreset(_ preset: Int) {
         chargeLimit = Double(preset)
-        logEvent("Charge limit preset set to \(preset)%")
+        logEvent(EV_PRESET_SET, preset)
     }
 
     // MARK: - Feature 39: Charge Speed
@@ -479,6 +648,14 @@ class BatteryManager: ObservableObject {
     // MARK: - Feature 42: Estimated Replacement
 
     private func updateReplacementDate() {
+        let f = DateFormatter()
+        f.dateFormat = "MMM yyyy"
+        // The aging model once it has a day of samples to project from
+        if agingEstimate.days_to_eol >= 0 {
+            let targetDate = Date().addingTimeInterval(agingEstimate.days_to_eol * 86400)
+            estimatedReplacementDate = "~\(f.string(from: targetDate))"
+            return
+        }
         guard capacitySnapshots.count >= 2, designCapacity > 0 else {
             estimatedReplacementDate = "—"
             return
@@ -496,53 +673,141 @@ class BatteryManager: ObservableObject {
         if remaining > 0 && fadePerDay > 0 {
             let daysLeft = Int(remaining / fadePerDay)
             let targetDate = Calendar.current.date(byAdding: .day, value: daysLeft, to: Date())!
-            let f = DateFormatter()
-            f.dateFormat = "MMM yyyy"
             estimatedReplacementDate = "~\(f.string(from: targetDate))"
         } else {
             estimatedReplacementDate = "—"
         }
     }
 
+    // MARK: - Aging Model
+
+    private func loadAgingModel() {
+        var saved = age_model_t()
+        if let data = Self.defaults.data(forKey: "agingModel"),
+           data.count == MemoryLayout<age_model_t>.size {
+            withUnsafeMutableBytes(of: &saved) { _ = data.copyBytes(to: $0) }
+        }
+        guard saved.version == AGE_MODEL_VERSION else {
+            age_init(&agingModel)
+            return
+        }
+        agingModel = saved
+        var estimate = age_estimate_t()
+        age_estimate(&agingModel, &estimate)
+        agingEstimate = estimate
+        batteryAgeYears = estimate.equivalent_years
+    }
+
+    /// One tick of wear. The model is seeded once from the capacity the
+    /// firmware reports, then runs on samples alone; it is saved hourly.
+    private func stepAgingModel(_ sample: pdev_sample_t, _ info: BatteryInfo) {
+        var sample = sample
+        let measuredLoss: Double? = info.designCapacity > 0 && info.maxCapacity > 0
+            ? 100.0 - Double(info.maxCapacity) / Double(info.designCapacity) * 100.0 : nil
+        let cycles = Int32(clamping: info.cycleCount)
+        let utcOffset = Int32(TimeZone.current.secondsFromGMT())
+        agingQueue.async { [weak self] in
+            guard let self = self else { return }
+            self.agingModel.utc_offset_s = utcOffset
+            if self.agingModel.seeded == 0, let loss = measuredLoss {
+                age_seed(&self.agingModel, loss, cycles)
+            }
+            age_sample(&self.agingModel, &sample)
+            var estimate = age_estimate_t()
+            age_estimate(&self.agingModel, &estimate)
+            if sample.t_ms - self.agingSavedMs >= 3_600_000 {
+                self.agingSavedMs = sample.t_ms
+                self.saveAgingModel()
+            }
+            DispatchQueue.main.async {
+                self.agingEstimate = estimate
+                self.batteryAgeYears = estimate.equivalent_years
+            }
+        }
+    }
+
+    /// agingQueue only
+    private func saveAgingModel() {
+        Self.defaults.set(withUnsafeBytes(of: &agingModel) { Data($0) }, forKey: "agingModel")
+    }
+
+    /// Rainflow cycles and their estimated wear per depth bin (5% each,
+    /// by lower edge) over the last `days` local days
+    func cycleDepths(days: Int) -> [(depth: Int, cycles: Double, wear: Double)] {
+        let bins = Int(RFC_BINS)
+        var cycles = [Double](repeating: 0, count: bins)
+        var wear = [Double](repeating: 0, count: bins)
+        let now = Int64(Self.now().timeIntervalSince1970 * 1000)
+        agingQueue.sync {
+            _ = age_depths(&agingModel, now, Int32(days), &cycles, &wear)
+        }
+        return (0..<bins).map { (depth: Int(rfc_bin_low(Int32($0))), cycles: cycles[$0], wear: wear[$0]) }
+    }
+
     // MARK: - Session Tracking (19)
 
-    private func startSession() {
-        sessionStartTime = Date()
+    private func startSession(at date: Date = BatteryManager.now()) {
+        sessionStartTime = date
         sessionStartLevel = batteryLevel
         sessionDelta = 0
         sessionDuration = "0m"
     }
 
-    private func endSession() {
+    private func endSession(at date: Date = BatteryManager.now()) {
         guard let start = sessionStartTime else { return }
-        let duration = Date().timeIntervalSince(start)
+        let duration = date.timeIntervalSince(start)
         let session = ChargeSession(
             startTime: start,
-            endTime: Date(),
+            endTime: date,
             startLevel: sessionStartLevel,
             endLevel: batteryLevel,
             durationMinutes: Int(duration / 60),
             adapterWatts: adapterWatts
         )
+        var record = session.record
+        slog_append(sessionLog, &record)
         chargeHistory.insert(session, at: 0)
-        if chargeHistory.count > 20 { chargeHistory = Array(chargeHistory.prefix(20)) }
-        saveChargeHistory()
+        if chargeHistory.count > Self.visibleSessions {
+            chargeHistory = Array(chargeHistory.prefix(Self.visibleSessions))
+        }
         sessionStartTime = nil
     }
 
     private func updateSessionDuration() {
         guard let start = sessionStartTime else { return }
-        let elapsed = Int(Date().timeIntervalSince(start))
+        let elapsed = Int(Self.now().timeIntervalSince(start))
         let hrs = elapsed / 3600
         let mins = (elapsed % 3600) / 60
         sessionDuration = hrs > 0 ? "\(hrs)h \(mins)m" : "\(mins)m"
         sessionDelta = batteryLevel - sessionStartLevel
     }
 
-    private func saveChargeHistory() {
-        if let data = try? JSONEncoder().encode(chargeHistory) {
-            UserDefaults.standard.set(data, forKey: "chargeHistory")
+    /// Newest sessions first; only the tail of the log is touched
+    private func loadRecentSessions() -> [ChargeSession] {
+        let count = slog_count(sessionLog)
+        var sessions: [ChargeSession] = []
+        var index = count
+        while index > 0 && sessions.count < Self.visibleSessions {
+            index -= 1
+            var record = slog_record_t()
+            if slog_read(sessionLog, index, &record) == 0 {
+                sessions.append(ChargeSession(record: record))
+            }
         }
+        return sessions
+    }
+
+    /// One-time migration of the JSON blob older versions kept in UserDefaults
+    /// The blob is removed only once every session is in the log; until
+    /// then it is kept and tried again at the next launch
+    private func importLegacyChargeHistory() {
+        guard let data = Self.defaults.data(forKey: "chargeHistory"),
+              let log = sessionLog,
+              let legacy = try? JSONDecoder().decode([ChargeSession].self, from: data) else { return }
+        // The blob is newest-first; the log is oldest-first
+        let records = legacy.reversed().map { $0.record }
+        guard slog_append_many(log, records, records.count) == 0 else { return }
+        Self.defaults.removeObject(forKey: "chargeHistory")
     }
 
     // MARK: - Alerts (13–16)
@@ -550,7 +815,7 @@ class BatteryManager: ObservableObject {
     private func checkTemperatureAlert() {
         if temperature >= tempAlertThreshold && !hasNotifiedTempAlert {
             hasNotifiedTempAlert = true
-            logEvent("Temperature alert: \(String(format: "%.1f°C", temperature))")
+            logEvent(EV_TEMP_ALERT, Int(temperature * 100))
             sendNotification(
                 title: "🌡 BrewCap — High Temperature",
                 body: "Battery temperature is \(String(format: "%.1f°C", temperature)). Threshold: \(Int(tempAlertThreshold))°C."
@@ -562,7 +827,7 @@ class BatteryManager: ObservableObject {
     private func checkLowBatteryWarning() {
         if batteryLevel <= lowBatteryThreshold && !isPluggedIn && !hasNotifiedLowBattery {
             hasNotifiedLowBattery = true
-            logEvent("Low battery warning: \(batteryLevel)%")
+            logEvent(EV_LOW_BATTERY, batteryLevel)
             sendNotification(
                 title: "🪫 BrewCap — Low Battery",
                 body: "Battery at \(batteryLevel)%. Consider plugging in your charger."
@@ -575,7 +840,7 @@ class BatteryManager: ObservableObject {
         guard fullChargeNotification else { return }
         if batteryLevel >= 100 && isPluggedIn && !hasNotifiedFullCharge {
             hasNotifiedFullCharge = true
-            logEvent("Battery fully charged")
+            logEvent(EV_FULLY_CHARGED)
             sendNotification(
                 title: "🔋 BrewCap — Fully Charged",
                 body: "Battery is at 100%. You can unplug your charger."
@@ -587,7 +852,7 @@ class BatteryManager: ObservableObject {
     private func checkCriticalTemperature() {
         if temperature >= 45 && !hasNotifiedCriticalTemp {
             hasNotifiedCriticalTemp = true
-            logEvent("CRITICAL temperature: \(String(format: "%.1f°C", temperature))")
+            logEvent(EV_CRITICAL_TEMP, Int(temperature * 100))
             sendNotification(
                 title: "🔥 BrewCap — CRITICAL TEMPERATURE",
                 body: "Battery at \(String(format: "%.1f°C", temperature))! This may damage your battery. Close intensive apps."
@@ -596,9 +861,38 @@ class BatteryManager: ObservableObject {
         if temperature < 42 { hasNotifiedCriticalTemp = false }
     }
 
+    // MARK: - Power Source Events
+
+    /// Subscribes to plug/unplug notifications so session boundaries are
+    /// stamped when they happen instead of at the next monitoring tick.
+    private func startPowerSourceEvents() {
+        let ctx = Unmanaged.passUnretained(self).toOpaque()
+        powerSource = psrc_open_system({ event, ctx in
+            guard let event = event?.pointee, let ctx = ctx else { return }
+            let manager = Unmanaged<BatteryManager>.fromOpaque(ctx).takeUnretainedValue()
+            let date = Date(timeIntervalSince1970: event.timestamp)
+            let online = event.online != 0
+            DispatchQueue.main.async { manager.handlePowerSourceChange(online: online, at: date) }
+        }, ctx)
+    }
+
+    private func handlePowerSourceChange(online: Bool, at date: Date) {
+        guard online != isPluggedIn else { return }
+        // Keep an earlier claim (e.g. from handleWake) for the same transition
+        if pendingTransition?.online != online { pendingTransition = (online, date) }
+        pdev_rescan(deviceSet) // a UPS or dock battery may have come or gone
+        refresh()
+    }
+
     // MARK: - Feature 28: Sleep/Wake
 
     private func registerSleepWakeNotifications() {
+        NSWorkspace.shared.notificationCenter.addObserver(
+            self,
+            selector: #selector(handleSleep),
+            name: NSWorkspace.willSleepNotification,
+            object: nil
+        )
         NSWorkspace.shared.notificationCenter.addObserver(
             self,
             selector: #selector(handleWake),
@@ -607,15 +901,52 @@ class BatteryManager: ObservableObject {
         )
     }
 
+    @objc private func handleSleep() {
+        sleepState = SleepGap.State(date: Date(), info: Self.readFullBatteryInfo())
+        rollup_flush(rollups) // the battery may run flat before we wake
+        ts_sync(telemetry)
+    }
+
     @objc private func handleWake() {
+        let wakeDate = Date()
+
+        // A plug/unplug that happened while asleep: the adapter state is valid
+        // immediately, so claim the transition before the wake refresh sees it.
+        // Unplugging is stamped at sleep (lid closed, then carried away);
+        // plugging in at wake, since nothing charges before we can tell.
+        if let before = sleepState {
+            let online = Self.readFullBatteryInfo().isPluggedIn
+            if online != before.isPluggedIn {
+                pendingTransition = (online, online ? wakeDate : before.date)
+            }
+        }
+
+        // Battery counters settle a couple of seconds after wake
         DispatchQueue.main.asyncAfter(deadline: .now() + 2) { [weak self] in
-            self?.refresh()
-            if self?.sailingModeEnabled == true {
-                self?.applyChargingControl()
+            guard let self = self else { return }
+            if let before = self.sleepState {
+                self.recordSleepGap(from: before, to: SleepGap.State(date: wakeDate, info: Self.readFullBatteryInfo()))
             }
+            self.sleepState = nil
+            self.refresh()
         }
     }
 
+    /// Collapses a sleep interval into one record and keeps it out of the
+    /// rolling drain estimate, which assumes evenly spaced awake samples.
+    private func recordSleepGap(from start: SleepGap.State, to end: SleepGap.State) {
+        guard end.date.timeIntervalSince(start.date) > 60 else { return }
+        let gap = SleepGap(start: start, end: end)
+        sleepGaps.insert(gap, at: 0)
+        if sleepGaps.count > 100 { sleepGaps = Array(sleepGaps.prefix(100)) }
+        if let data = try? JSONEncoder().encode(sleepGaps) {
+            Self.defaults.set(data, forKey: "sleepGaps")
+        }
+
+        drainSamples.removeAll()
+        logEvent(EV_WOKE, Int(gap.duration), start.level << 8 | end.level, Int(gap.energyWh * 1000))
+    }
+
     // MARK: - Feature 30: Reset All Settings
 
     func resetAllSettings() {
@@ -623,8 +954,12 @@ class BatteryManager: ObservableObject {
                      "lowBatteryThreshold", "fullChargeNotification", "soundEffectsEnabled",
                      "doNotDisturb", "monitoringInterval", "showPercentageInMenuBar", "chargeHistory",
                      "autoPauseLowBattery", "chargeChimeEnabled", "menuBarDisplayMode",
-                     "reduceMotion", "travelModeEnabled", "capacitySnapshots", "eventLog"]
-        keys.forEach { UserDefaults.standard.removeObject(forKey: $0) }
+                     "reduceMotion", "travelModeEnabled", "capacitySnapshots", "eventLog", "sleepGaps",
+                     "historyDurability", "sailingBandAbove", "sailingBandBelow", "sailingMinDwell",
+                     "thermalForecastMinutes", "fullByEnabled", "fullByDate", "fullByWeekly",
+                     "predictUnplug", "agingModel", "unplugModel", "unplugModelThrough",
+                     "chargeRates", "chargeMechanismRecords"]
+        keys.forEach { Self.defaults.removeObject(forKey: $0) }
 
         chargeLimit = 80.0
         sailingModeEnabled = false
@@ -636,37 +971,75 @@ class BatteryManager: ObservableObject {
         monitoringInterval = 10.0
         showPercentageInMenuBar = false
         chargeHistory = []
+        slog_clear(sessionLog)
         autoPauseLowBattery = true
         chargeChimeEnabled = false
         menuBarDisplayMode = 0
         reduceMotion = false
+        historyDurability = 1
+        sailingBandAbove = 0
+        sailingBandBelow = 3
+        sailingMinDwell = 5
+        predictUnplug = false
+        thermalForecastMinutes = 10
+        fullByEnabled = false
+        fullByWeekly = false
+        fullByDate = Self.nextMorning(hour: 7, minute: 30)
         travelModeEnabled = false
         capacitySnapshots = []
         eventLog = []
-        logEvent("All settings reset")
+        elog_clear(events)
+        sleepGaps = []
+        resetLearnedState()
+        logEvent(EV_SETTINGS_RESET)
+    }
+
+    /// The models start over with the history they were learned from; each
+    /// is cleared on the queue that owns it
+    private func resetLearnedState() {
+        agingQueue.async { [weak self] in
+            guard let self = self else { return }
+            age_init(&self.agingModel)
+            self.agingSavedMs = 0
+            var estimate = age_estimate_t()
+            age_estimate(&self.agingModel, &estimate)
+            DispatchQueue.main.async {
+                self.agingEstimate = estimate
+                self.batteryAgeYears = estimate.equivalent_years
+            }
+        }
+        guard let cc = chargeControl else { return }
+        controlQueue.async { [weak self] in
+            var model = upm_model_t()
+            upm_init(&model)
+            cc_set_unplug_model(cc, &model)
+            var rates = cs_rates_t()
+            cs_init(&rates)
+            cc_set_rates(cc, &rates)
+            let records = [cc_mechanism_t](repeating: cc_mechanism_t(), count: Int(CC_MAX_MECHANISMS))
+            cc_set_mechanisms(cc, records, Int32(records.count))
+            let snapshot = Self.controlSnapshot(cc)
+            DispatchQueue.main.async { self?.controlSnapshot = snapshot }
+        }
     }
 
     // MARK: - Sailing Mode
 
     private func handleSailingModeOn() {
-        if !SMCClient.isSetupComplete {
+        if !SMCClient.isSetupComplete || SMCClient.needsSetupUpdate {
             setupNeeded = true
-            return
         }
-        applyChargingControl()
+        guard SMCClient.isSetupComplete else { return }
+        updateChargeControl()
     }
 
     private func handleSailingModeOff() {
-        chargingInhibited = false
-        DispatchQueue.global(qos: .userInitiated).async { [weak self] in
-            _ = SMCClient.enableCharging()
-            DispatchQueue.main.async { self?.chargingInhibited = false }
-        }
+        updateChargeControl()
     }
 
     func completeSetup() {
         setupNeeded = false
-        applyChargingControl()
+        updateChargeControl()
     }
 
     func runSetup(completion: @escaping (Bool) -> Void) {
@@ -675,47 +1048,319 @@ class BatteryManager: ObservableObject {
             DispatchQueue.main.async {
                 if success {
                     self.setupNeeded = false
-                    self.applyChargingControl()
+                    if let cc = self.chargeControl {
+                        let unavailable = SMCClient.unavailableMethods
+                        self.controlQueue.async { cc_set_unavailable(cc, unavailable) }
+                    }
+                    self.updateChargeControl()
                 }
                 completion(success)
             }
         }
     }
 
-    private func handleSailingCheck() {
-        let limit = Int(chargeLimit)
-        let aboveLimit = batteryLevel >= limit && isPluggedIn
-
-        if aboveLimit && !chargingInhibited {
-            applyChargingControl()
-        } else if !aboveLimit && chargingInhibited {
-            DispatchQueue.global(qos: .userInitiated).async { [weak self] in
-                let ok = SMCClient.enableCharging()
-                DispatchQueue.main.async { if ok { self?.chargingInhibited = false } }
+    // MARK: - Charge Control
+
+    private func chargeControlConfig() -> cc_config_t {
+        var config = cc_config_t()
+        config.armed = SMCClient.isSetupComplete ? 1 : 0
+        config.sailing = sailingModeEnabled ? 1 : 0
+        config.limit = UInt8(clamping: Int(chargeLimit))
+        config.auto_pause_low = autoPauseLowBattery ? 1 : 0 // Feature 40
+        config.low_level = 20
+        config.band_above = UInt8(clamping: sailingBandAbove)
+        config.band_below = UInt8(clamping: sailingBandBelow)
+        config.min_dwell_ms = Int64(sailingMinDwell * 60_000)
+        // Same thresholds as the critical temperature alert
+        config.thermal_inhibit_cc = 4500
+        config.thermal_resume_cc = 4200
+        config.forecast_ms = Int64(thermalForecastMinutes) * 60_000
+        if travelModeEnabled, let expiry = travelModeExpiry { // Feature 37
+            config.travel_until_ms = Int64(expiry.timeIntervalSince1970 * 1000)
+        }
+        if fullByEnabled {
+            config.full_by_ms = Int64(fullByDate.timeIntervalSince1970 * 1000)
+            config.full_target = 100
+        }
+        // Top up once an unplug is an even bet within the time a top-up takes
+        config.predict_unplug = predictUnplug ? 50 : 0
+        config.utc_offset_s = Int32(TimeZone.current.secondsFromGMT())
+        return config
+    }
+
+    private func startChargeControl() {
+        var config = chargeControlConfig()
+        // Mechanisms are smc_charge_method_t values; the controller ranks
+        // them by how often each was seen to stop the current
+        let actuator = cc_actuator_t(ctx: nil, mechanisms: Int32(SMC_CHARGE_METHODS.rawValue),
+                                     set_charging: { _, mechanism, enabled in
+            let method = smc_charge_method_t(rawValue: UInt32(mechanism))
+            return SMCClient.setCharging(enabled != 0, method: method) ? 0 : -1
+        })
+        chargeControl = cc_create(&config, actuator)
+        guard let cc = chargeControl else { return }
+        // A setup from an older version lets sudo run only some of them
+        cc_set_unavailable(cc, SMCClient.unavailableMethods)
+        if SMCClient.needsSetupUpdate { setupNeeded = true }
+        if let saved = Self.defaults.array(forKey: "chargeMechanismRecords") as? [[Int]] {
+            let records = saved.prefix(Int(CC_MAX_MECHANISMS)).map {
+                cc_mechanism_t(confirmed: UInt32($0.first ?? 0), refuted: UInt32($0.last ?? 0))
+            }
+            cc_set_mechanisms(cc, records, Int32(records.count))
+        }
+        // The unplug pattern is saved with the time it was taken; only the
+        // sessions logged after that are learned again, from the log's tail
+        // As with the aging model, a blob of another layout is dropped even
+        // at the same size
+        var through: Int64 = 0
+        var model = upm_model_t()
+        if let data = Self.defaults.data(forKey: "unplugModel"),
+           data.count == MemoryLayout<upm_model_t>.size {
+            withUnsafeMutableBytes(of: &model) { _ = data.copyBytes(to: $0) }
+        }
+        if model.version == UPM_MODEL_VERSION {
+            cc_set_unplug_model(cc, &model)
+            through = Int64(Self.defaults.integer(forKey: "unplugModelThrough"))
+        }
+        var sessions: [(start: Int64, end: Int64)] = []
+        var index = slog_count(sessionLog)
+        while index > 0 {
+            index -= 1
+            var record = slog_record_t()
+            guard slog_read(sessionLog, index, &record) == 0 else { continue }
+            if record.end_ms <= through { break }
+            sessions.append((max(record.start_ms, through), record.end_ms))
+        }
+        sessions.reverse()
+        var rates = cs_rates_t()
+        if let data = Self.defaults.data(forKey: "chargeRates"),
+           data.count == MemoryLayout<cs_rates_t>.size {
+            withUnsafeMutableBytes(of: &rates) { _ = data.copyBytes(to: $0) }
+        }
+        if rates.version == CS_RATES_VERSION {
+            cc_set_rates(cc, &rates)
+        }
+        // Nothing else has the controller yet, so the restores above may run
+        // here; from now on it belongs to controlQueue
+        let restoreInhibit = sailingModeEnabled && SMCClient.isSetupComplete
+        controlQueue.async { [weak self] in
+            for session in sessions { cc_learn_session(cc, session.start, session.end) }
+            guard restoreInhibit else {
+                let snapshot = Self.controlSnapshot(cc)
+                DispatchQueue.main.async { self?.controlSnapshot = snapshot }
+                return
             }
+            // A previous run may have left charging off
+            let inhibited = SMCClient.isChargingInhibited()
+            cc_assume(cc, inhibited ? 1 : 0)
+            var out = cc_output_t()
+            cc_step(cc, nil, &out)
+            let snapshot = Self.controlSnapshot(cc)
+            DispatchQueue.main.async { self?.publishChargeControl(out, snapshot) }
         }
     }
 
-    private func applyChargingControl() {
-        guard SMCClient.isSetupComplete else { return }
-        let limit = Int(chargeLimit)
-        let aboveLimit = batteryLevel >= limit && isPluggedIn
-
-        if aboveLimit {
-            DispatchQueue.global(qos: .userInitiated).async { [weak self] in
-                let ok = SMCClient.disableCharging()
-                DispatchQueue.main.async {
-                    self?.chargingInhibited = ok
-                    if ok {
-                        self?.logEvent("Charging paused at \(self?.batteryLevel ?? 0)%")
-                        self?.sendNotification(
-                            title: "☕ BrewCap — Charging Paused",
-                            body: "Battery at \(self?.batteryLevel ?? 0)%. Limit is \(limit)%."
-                        )
-                    }
+    /// Hands the current settings to the controller and re-evaluates at once
+    private func updateChargeControl() {
+        guard let cc = chargeControl else { return }
+        var config = chargeControlConfig()
+        controlQueue.async { [weak self] in
+            cc_configure(cc, &config)
+            var out = cc_output_t()
+            cc_step(cc, nil, &out)
+            let snapshot = Self.controlSnapshot(cc)
+            DispatchQueue.main.async { self?.publishChargeControl(out, snapshot) }
+        }
+    }
+
+    private func stepChargeControl(_ sample: pdev_sample_t, adapterWatts: Int) {
+        guard let cc = chargeControl else { return }
+        var sample = sample
+        controlQueue.async { [weak self] in
+            cc_set_adapter(cc, Int32(clamping: adapterWatts))
+            var out = cc_output_t()
+            cc_step(cc, &sample, &out)
+            let snapshot = Self.controlSnapshot(cc)
+            DispatchQueue.main.async { self?.publishChargeControl(out, snapshot) }
+        }
+    }
+
+    /// controlQueue only
+    private static func controlSnapshot(_ cc: OpaquePointer) -> ChargeControlSnapshot {
+        var snapshot = ChargeControlSnapshot()
+        cc_rates(cc, &snapshot.rates)
+        cc_stats(cc, &snapshot.stats)
+        var records = [cc_mechanism_t](repeating: cc_mechanism_t(), count: Int(CC_MAX_MECHANISMS))
+        let count = cc_mechanisms(cc, &records, Int32(records.count))
+        snapshot.mechanisms = Array(records.prefix(Int(max(count, 0))))
+        cc_unplug_model(cc, &snapshot.unplug)
+        snapshot.takenMs = Int64(Self.now().timeIntervalSince1970 * 1000)
+        return snapshot
+    }
+
+    private func publishChargeControl(_ out: cc_output_t, _ snapshot: ChargeControlSnapshot) {
+        controlSnapshot = snapshot
+        applyChargeControl(out)
+    }
+
+    /// How often each charging mechanism was seen to stop the current, and
+    /// how often the current kept flowing through it
+    func chargeMechanismRecords() -> [(name: String, confirmed: Int, refuted: Int)] {
+        controlSnapshot.mechanisms.enumerated().map {
+            (SMCClient.chargeMethodName($0.offset), Int($0.element.confirmed), Int($0.element.refuted))
+        }
+    }
+
+    /// Keeps the charge rates learned this session (per adapter) for Full By
+    private func saveChargeRates() {
+        guard chargeControl != nil else { return }
+        var rates = controlSnapshot.rates
+        Self.defaults.set(withUnsafeBytes(of: &rates) { Data($0) }, forKey: "chargeRates")
+    }
+
+    /// Keeps the unplug pattern across launches. The snapshot may lag the
+    /// last step; a session it missed ends after takenMs and is learned again
+    /// from the log at the next launch.
+    private func saveUnplugModel() {
+        guard chargeControl != nil, controlSnapshot.takenMs > 0 else { return }
+        var model = controlSnapshot.unplug
+        Self.defaults.set(withUnsafeBytes(of: &model) { Data($0) }, forKey: "unplugModel")
+        Self.defaults.set(Int(controlSnapshot.takenMs), forKey: "unplugModelThrough")
+    }
+
+    /// Saves what the models learned this run, for quitting. The aging model
+    /// is otherwise saved hourly; waiting on its queue here costs at most
+    /// one sample's work.
+    func saveLearnedState() {
+        agingQueue.sync { saveAgingModel() }
+        guard controlSnapshot.takenMs > 0 else { return } // nothing published yet
+        saveChargeRates()
+        saveChargeMechanisms()
+        saveUnplugModel()
+    }
+
+    /// Minutes from level to 100% on the connected (or last) adapter
+    func minutesToFull() -> Int? {
+        guard chargeControl != nil else { return nil }
+        var rates = controlSnapshot.rates
+        let watts = Int32(clamping: isPluggedIn ? adapterWatts : 0)
+        return Int(cs_time_to(&rates, watts, Int32(batteryLevel), 100) / 60_000)
+    }
+
+    /// The fire time for Full By's single timer; refresh() then hands the
+    /// controller a sample taken at the start time. start is on the sample
+    /// clock; the timer runs on the wall clock.
+    private func armFullByTimer(_ start: Date?) {
+        guard let start = start, start > Self.now() else {
+            TaskScheduler.shared.cancel("fullBy")
+            return
+        }
+        TaskScheduler.shared.schedule("fullBy", at: Self.wallDate(start),
+                                      tolerance: 30 / (Self.simulatorSpeed ?? 1)) { [weak self] in
+            self?.refresh()
+        }
+    }
+
+    static func nextMorning(hour: Int, minute: Int) -> Date {
+        let components = DateComponents(hour: hour, minute: minute)
+        return Calendar.current.nextDate(after: Date(), matching: components, matchingPolicy: .nextTime)
+            ?? Date().addingTimeInterval(86400)
+    }
+
+    /// Keeps what the controller learned about the mechanisms across launches
+    private func saveChargeMechanisms() {
+        let saved = chargeMechanismRecords().map { [$0.confirmed, $0.refuted] }
+        Self.defaults.set(saved, forKey: "chargeMechanismRecords")
+    }
+
+    /// Charger writes and state changes per hour of sampling, or nil before
+    /// the controller has seen a few minutes of samples
+    func chargeControlRates() -> (transitions: Double, writes: Double, deferred: Int)? {
+        guard chargeControl != nil else { return nil }
+        let stats = controlSnapshot.stats
+        let hours = Double(stats.span_ms) / 3_600_000
+        guard hours > 0.05 else { return nil }
+        return (Double(stats.transitions) / hours, Double(stats.writes) / hours, Int(stats.deferred))
+    }
+
+    private func applyChargeControl(_ out: cc_output_t) {
+        if chargingInhibited != (out.inhibited != 0) { chargingInhibited = out.inhibited != 0 }
+        if chargeState != out.state { chargeState = out.state }
+        let forecast = out.forecast_cc != 0 ? Double(out.forecast_cc) / 100 : nil
+        if temperatureForecast != forecast { temperatureForecast = forecast }
+        let start = out.full_from_ms > 0 ? Date(timeIntervalSince1970: Double(out.full_from_ms) / 1000) : nil
+        // The start drifts by a few seconds as the level moves; re-arm on real changes
+        let unplug = out.unplug_at_ms > 0 ? Date(timeIntervalSince1970: Double(out.unplug_at_ms) / 1000) : nil
+        if likelyUnplug != unplug { likelyUnplug = unplug }
+        let moved = start.map { s in fullByStart.map { abs(s.timeIntervalSince($0)) >= 60 } ?? true }
+            ?? (fullByStart != nil)
+        if moved {
+            fullByStart = start
+            armFullByTimer(start)
+        }
+        let notices = out.notices
+        guard notices != 0 else { return }
+        let verdicts = UInt32(CC_NOTE_PAUSED) | UInt32(CC_NOTE_THERMAL) | UInt32(CC_NOTE_INEFFECTIVE)
+        if notices & verdicts != 0 {
+            saveChargeMechanisms()
+        }
+
+        if notices & UInt32(CC_NOTE_TRAVEL_EXPIRED) != 0 {
+            travelModeEnabled = false
+        }
+        if notices & UInt32(CC_NOTE_SAILING_AUTO_OFF) != 0 {
+            sailingModeEnabled = false
+            logEvent(EV_SAILING_AUTO_OFF)
+            sendNotification(
+                title: "⚠️ BrewCap — Sailing Mode Paused",
+                body: "Battery below 20%. Sailing Mode disabled to preserve charge."
+            )
+        }
+        if notices & UInt32(CC_NOTE_PAUSED) != 0 {
+            saveChargeRates() // the end of a charge run
+            logEvent(EV_CHARGING_PAUSED, batteryLevel)
+            sendNotification(
+                title: "☕ BrewCap — Charging Paused",
+                body: "Battery at \(batteryLevel)%. Limit is \(Int(chargeLimit))%."
+            )
+        }
+        if notices & UInt32(CC_NOTE_THERMAL) != 0 {
+            // Below the limit, the pause came from the forecast
+            let why = temperature < 45
+                ? "Forecast to pass 45°C within \(thermalForecastMinutes) min"
+                : "Battery at \(String(format: "%.1f°C", temperature))"
+            logEvent(EV_THERMAL_HOLD, Int(temperature * 100))
+            sendNotification(
+                title: "🔥 BrewCap — Charging Paused for Heat",
+                body: "\(why). Charging resumes once it cools."
+            )
+        }
+        if notices & UInt32(CC_NOTE_FAULT) != 0 {
+            logEvent(EV_CHARGE_CONTROL_FAULT)
+            sendNotification(
+                title: "⚠️ BrewCap — Charging Control Unavailable",
+                body: "BrewCap could not change the charging state. It will keep retrying."
+            )
+        }
+        if notices & UInt32(CC_NOTE_RECOVERED) != 0 {
+            logEvent(EV_CHARGE_CONTROL_RECOVERED)
+        }
+        if notices & UInt32(CC_NOTE_SCHEDULE_DONE) != 0 {
+            logEvent(EV_FULL_BY_DONE, batteryLevel)
+            if fullByWeekly {
+                var next = fullByDate
+                while next <= Self.now() {
+                    next = Calendar.current.date(byAdding: .weekOfYear, value: 1, to: next)
+                        ?? next.addingTimeInterval(7 * 86400)
                 }
+                fullByDate = next
+            } else {
+                fullByEnabled = false
             }
         }
+        if notices & UInt32(CC_NOTE_INEFFECTIVE) != 0 {
+            logEvent(EV_CHARGE_MECHANISM_INEFFECTIVE, Int(out.mechanism))
+        }
     }
 
     private func checkOneShotNotification() {
@@ -732,25 +1377,72 @@ class BatteryManager: ObservableObject {
 
     // MARK: - Feature 52: Event Log
 
+    /// Records an event by code; the text is rendered only when displayed
+    func logEvent(_ code: elog_code_t, _ a0: Int = 0, _ a1: Int = 0, _ a2: Int = 0) {
+        let now = Self.now()
+        elog_append(events, now.timeIntervalSince1970, Int32(code.rawValue),
+                    Int32(clamping: a0), Int32(clamping: a1), Int32(clamping: a2))
+        let record = elog_record_t(t_s: UInt32(now.timeIntervalSince1970), code: UInt16(code.rawValue),
+                                   seq: 0, args: (Int32(clamping: a0), Int32(clamping: a1), Int32(clamping: a2)))
+        eventLog.insert(BatteryEvent(record: record, text: nil), at: 0)
+        if eventLog.count > Self.visibleEvents { eventLog = Array(eventLog.prefix(Self.visibleEvents)) }
+    }
+
+    /// Free-form text, interned once in the log's string table
     func logEvent(_ message: String) {
-        let event = BatteryEvent(date: Date(), message: message)
-        eventLog.insert(event, at: 0)
-        if eventLog.count > 100 { eventLog = Array(eventLog.prefix(100)) }
-        saveEventLog()
+        let id = elog_intern(events, message)
+        guard id >= 0 else { return }
+        logEvent(EV_TEXT, Int(id))
+        if !eventLog.isEmpty { eventLog[0].text = message }
+    }
+
+    private func loadRecentEvents() -> [BatteryEvent] {
+        let count = min(elog_count(events), Self.visibleEvents)
+        return (0..<count).compactMap { i in
+            var record = elog_record_t()
+            guard elog_get(events, i, &record) == 0 else { return nil }
+            return BatteryEvent(record: record, text: eventText(record))
+        }
+    }
+
+    private func eventText(_ record: elog_record_t) -> String? {
+        guard record.code == UInt16(EV_TEXT.rawValue) else { return nil }
+        var buf = [CChar](repeating: 0, count: 256)
+        guard elog_string(events, record.args.0, &buf, buf.count) == 0 else { return nil }
+        return String(cString: buf)
     }
 
-    private func saveEventLog() {
-        if let data = try? JSONEncoder().encode(eventLog) {
-            UserDefaults.standard.set(data, forKey: "eventLog")
+    /// One-time migration of the JSON event array older versions kept in UserDefaults
+    /// The blob is removed only once every event is in the log. An import
+    /// that stops part way keeps the events not yet appended, so the retry at
+    /// the next launch does not repeat the others.
+    private func importLegacyEventLog() {
+        guard let data = Self.defaults.data(forKey: "eventLog"),
+              let log = events,
+              let legacy = try? JSONDecoder().decode([LegacyEvent].self, from: data) else { return }
+        // The blob is newest-first; the log is appended oldest-first
+        var appended = 0
+        for event in legacy.reversed() {
+            let id = elog_intern(log, event.message)
+            guard id >= 0,
+                  elog_append(log, event.date.timeIntervalSince1970, Int32(EV_TEXT.rawValue), id, 0, 0) == 0
+            else { break }
+            appended += 1
+        }
+        if appended == legacy.count {
+            Self.defaults.removeObject(forKey: "eventLog")
+        } else if appended > 0, let rest = try? JSONEncoder().encode(Array(legacy.dropLast(appended))) {
+            Self.defaults.set(rest, forKey: "eventLog")
         }
     }
 
     // MARK: - Feature 33/54: Capacity Snapshots
 
     private func startSnapshotTimer() {
-        // Take a snapshot every 12 hours
+        // Take a snapshot every 12 hours; an hour of slack lets it ride along
+        // with a monitoring wakeup
         takeCapacitySnapshotIfNeeded()
-        snapshotTimer = Timer.scheduledTimer(withTimeInterval: 43200, repeats: true) { [weak self] _ in
+        TaskScheduler.shared.schedule("snapshot", every: 43200, tolerance: 3600) { [weak self] in
             self?.takeCapacitySnapshotIfNeeded()
         }
     }
@@ -763,22 +1455,95 @@ class BatteryManager: ObservableObject {
         }
         let snap = CapacitySnapshot(date: Date(), maxCapacity: maxCapacity, designCapacity: designCapacity, cycleCount: cycleCount)
         capacitySnapshots.append(snap)
-        if capacitySnapshots.count > 365 { capacitySnapshots = Array(capacitySnapshots.suffix(365)) }
+        capacitySnapshots = Self.thinSnapshots(capacitySnapshots, now: snap.date)
         if let data = try? JSONEncoder().encode(capacitySnapshots) {
-            UserDefaults.standard.set(data, forKey: "capacitySnapshots")
+            Self.defaults.set(data, forKey: "capacitySnapshots")
+        }
+    }
+
+    /// Daily snapshots for the last year, then one per week, so the capacity
+    /// trend keeps its full history without growing by 365 entries a year
+    private static func thinSnapshots(_ snaps: [CapacitySnapshot], now: Date) -> [CapacitySnapshot] {
+        let yearAgo = now.addingTimeInterval(-365 * 86400)
+        var kept: [CapacitySnapshot] = []
+        var lastWeek = Int.min
+        for snap in snaps {
+            if snap.date >= yearAgo {
+                kept.append(snap)
+                continue
+            }
+            let week = Int(snap.date.timeIntervalSince1970 / (7 * 86400))
+            if week != lastWeek {
+                kept.append(snap)
+                lastWeek = week
+            }
+        }
+        return kept
+    }
+
+    // MARK: - History Retention
+
+    /// Keeps the telemetry, rollup and event stores within their age limits.
+    /// Each pass is capped at about 512 KB of I/O; a backlog (e.g. after a
+    /// long time without running) is worked off over several passes.
+    private func startRetentionTimer() {
+        TaskScheduler.shared.schedule("retention", every: 300, tolerance: 60) { [weak self] in
+            guard let self = self else { return }
+            var policy = ret_default_policy()
+            let now = Int64(Self.now().timeIntervalSince1970 * 1000)
+            ret_run(&policy, self.telemetry, self.rollups, self.events, now, 512 * 1024)
         }
     }
 
     // MARK: - Feature 49: CSV Export
 
-    func exportChargeHistoryCSV() -> String {
-        var csv = "Date,Start Level,End Level,Delta,Duration (min),Adapter Watts\n"
-        for s in chargeHistory {
-            let f = DateFormatter()
-            f.dateFormat = "yyyy-MM-dd HH:mm"
-            csv += "\(f.string(from: s.startTime)),\(s.startLevel),\(s.endLevel),\(s.delta),\(s.durationMinutes),\(s.adapterWatts)\n"
+    /// Streams every logged session (not just the visible ones) to url
+    func exportChargeHistoryCSV(to url: URL) -> Bool {
+        csvx_export_sessions(sessionLog, url.path) >= 0
+    }
+
+    /// Streams every recorded telemetry sample to url
+    func exportTelemetryCSV(to url: URL) -> Bool {
+        csvx_export_telemetry(telemetry, Int64.min, Int64.max, url.path) >= 0
+    }
+
+    /// Writes sessions, capacity snapshots and telemetry as Arrow IPC (Feather)
+    /// files into dir, for loading straight into pandas or polars
+    func exportArrow(to dir: URL) -> Bool {
+        let sessions = arw_export_sessions(sessionLog, dir.appendingPathComponent("BrewCap_Sessions.arrow").path)
+        let samples = arw_export_telemetry(telemetry, Int64.min, Int64.max,
+                                           dir.appendingPathComponent("BrewCap_Samples.arrow").path)
+        let capacity = exportCapacityArrow(to: dir.appendingPathComponent("BrewCap_Capacity.arrow"))
+        return sessions >= 0 && samples >= 0 && capacity
+    }
+
+    private func exportCapacityArrow(to url: URL) -> Bool {
+        let schema: [(String, arw_type_t)] = [("date", ARW_TIMESTAMP_MS), ("max_capacity_mah", ARW_INT32),
+                                              ("design_capacity_mah", ARW_INT32), ("cycle_count", ARW_INT32)]
+        let names = schema.map { strdup($0.0) }
+        defer { names.forEach { free($0) } }
+        let columns = zip(names, schema).map { arw_column_t(name: $0.0, type: $0.1.1) }
+        guard let writer = arw_create(url.path, columns, columns.count) else { return false }
+
+        let dates = capacitySnapshots.map { Int64($0.date.timeIntervalSince1970 * 1000) }
+        let maxCapacity = capacitySnapshots.map { Int32(clamping: $0.maxCapacity) }
+        let designCapacity = capacitySnapshots.map { Int32(clamping: $0.designCapacity) }
+        let cycles = capacitySnapshots.map { Int32(clamping: $0.cycleCount) }
+        let rc = dates.withUnsafeBytes { d in
+            maxCapacity.withUnsafeBytes { m in
+                designCapacity.withUnsafeBytes { dc in
+                    cycles.withUnsafeBytes { c in
+                        let ptrs = [d.baseAddress, m.baseAddress, dc.baseAddress, c.baseAddress]
+                        return arw_write_batch(writer, dates.count, ptrs)
+                    }
+                }
+            }
+        }
+        guard rc == 0 else {
+            arw_abort(writer)
+            return false
         }
-        return csv
+        return arw_finish(writer) == 0
     }
 
     // MARK: - Feature 50: Copy Stats to Clipboard
@@ -796,7 +1561,7 @@ class BatteryManager: ObservableObject {
         """
         NSPasteboard.general.clearContents()
         NSPasteboard.general.setString(stats, forType: .string)
-        logEvent("Stats copied to clipboard")
+        logEvent(EV_STATS_COPIED)
     }
 
     // MARK: - Feature 53: Settings Export/Import
@@ -814,7 +1579,16 @@ class BatteryManager: ObservableObject {
             "autoPauseLowBattery": autoPauseLowBattery,
             "chargeChimeEnabled": chargeChimeEnabled,
             "menuBarDisplayMode": menuBarDisplayMode,
-            "reduceMotion": reduceMotion
+            "reduceMotion": reduceMotion,
+            "historyDurability": historyDurability,
+            "sailingBandAbove": sailingBandAbove,
+            "sailingBandBelow": sailingBandBelow,
+            "sailingMinDwell": sailingMinDwell,
+            "predictUnplug": predictUnplug,
+            "thermalForecastMinutes": thermalForecastMinutes,
+            "fullByEnabled": fullByEnabled,
+            "fullByDate": fullByDate.timeIntervalSince1970,
+            "fullByWeekly": fullByWeekly
         ]
         return try? JSONSerialization.data(withJSONObject: settings, options: .prettyPrinted)
     }
@@ -833,7 +1607,16 @@ class BatteryManager: ObservableObject {
         if let v = settings["chargeChimeEnabled"] as? Bool { chargeChimeEnabled = v }
         if let v = settings["menuBarDisplayMode"] as? Int { menuBarDisplayMode = v }
         if let v = settings["reduceMotion"] as? Bool { reduceMotion = v }
-        logEvent("Settings imported from JSON")
+        if let v = settings["historyDurability"] as? Int { historyDurability = v }
+        if let v = settings["sailingBandAbove"] as? Int { sailingBandAbove = v }
+        if let v = settings["sailingBandBelow"] as? Int { sailingBandBelow = v }
+        if let v = settings["sailingMinDwell"] as? Double { sailingMinDwell = v }
+        if let v = settings["predictUnplug"] as? Bool { predictUnplug = v }
+        if let v = settings["thermalForecastMinutes"] as? Int { thermalForecastMinutes = v }
+        if let v = settings["fullByDate"] as? Double { fullByDate = Date(timeIntervalSince1970: v) }
+        if let v = settings["fullByWeekly"] as? Bool { fullByWeekly = v }
+        if let v = settings["fullByEnabled"] as? Bool { fullByEnabled = v }
+        logEvent(EV_SETTINGS_IMPORTED)
         return true
     }
 
@@ -856,6 +1639,254 @@ class BatteryManager: ObservableObject {
         UNUserNotificationCenter.current().requestAuthorization(options: [.alert, .sound, .badge]) { _, _ in }
     }
 
+    // MARK: - Power Devices
+
+    /// One batched pass over every device; cost is linear in the device count.
+    /// The internal battery was just read for `internal`, so that sample is
+    /// handed to the set instead of reading the battery a second time.
+    private func pollPowerDevices(internal: pdev_sample_t) -> [PowerDevice] {
+        guard let set = deviceSet else { return [] }
+        var sample = internal
+        if let i = (0..<pdev_count(set)).first(where: { pdev_info(set, $0)?.pointee.kind == Int32(PDEV_INTERNAL.rawValue) }) {
+            pdev_submit(set, i, &sample)
+        }
+        pdev_poll(set, sample.t_ms)
+        return (0..<pdev_count(set)).compactMap { i in
+            guard let info = pdev_info(set, i)?.pointee,
+                  let sample = pdev_latest(set, i)?.pointee else { return nil }
+            return PowerDevice(info: info, sample: sample)
+        }
+    }
+
+    // MARK: - Storage
+
+    /// ~/Library/Application Support/BrewCap/<name>, creating the folder. A
+    /// simulator run uses BrewCap/Simulator so its history stays apart.
+    static func storageURL(_ name: String) -> URL {
+        var dir = FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask)[0]
+            .appendingPathComponent("BrewCap", isDirectory: true)
+        if simulator != nil {
+            dir.appendPathComponent("Simulator", isDirectory: true)
+        }
+        try? FileManager.default.createDirectory(at: dir, withIntermediateDirectories: true)
+        return dir.appendingPathComponent(name)
+    }
+
+    private static func openTelemetryStore() -> OpaquePointer? {
+        let dir = storageURL("telemetry")
+        try? FileManager.default.createDirectory(at: dir, withIntermediateDirectories: true)
+        return ts_open(dir.path)
+    }
+
+    /// The log only checks its delay budget when a sample arrives, so a quiet
+    /// stream (monitor paused, long intervals) could sit unsynced for good.
+    /// Syncing on a timer slightly inside the budget bounds the wait.
+    private func startHistorySyncTimer() {
+        let delay = TimeInterval(Self.walPolicy(historyDurability).max_delay_ms) / 1000
+        guard delay > 0 else {
+            TaskScheduler.shared.cancel("historySync") // every sample syncs
+            return
+        }
+        TaskScheduler.shared.schedule("historySync", every: delay * 0.9, tolerance: delay * 0.1) { [weak self] in
+            ts_sync(self?.telemetry)
+        }
+    }
+
+    private static func walPolicy(_ level: Int) -> wal_policy_t {
+        switch level {
+        case 0: return wal_policy_t(max_delay_ms: 0, max_bytes: 0)
+        case 2: return wal_policy_t(max_delay_ms: 60 * 60 * 1000, max_bytes: 64 * 1024)
+        default: return wal_policy_t(max_delay_ms: 5 * 60 * 1000, max_bytes: 4096)
+        }
+    }
+
+    private static func telemetrySample(_ info: BatteryInfo, watts: Double) -> pdev_sample_t {
+        var sample = pdev_sample_t()
+        sample.t_ms = Int64(now().timeIntervalSince1970 * 1000)
+        sample.level = Int32(info.level)
+        sample.amperage_ma = Int32(clamping: info.amperage)
+        sample.voltage_mv = Int32(info.voltage * 1000)
+        sample.temp_cc = Int32(info.temperature * 100)
+        sample.cur_mah = Int32(clamping: info.rawCurrentCapacity)
+        sample.max_mah = Int32(clamping: info.maxCapacity)
+        sample.design_mah = Int32(clamping: info.designCapacity)
+        sample.cycle_count = Int32(clamping: info.cycleCount)
+        sample.power_w = Float(watts)
+        sample.plugged = info.isPluggedIn ? 1 : 0
+        sample.charging = info.isCharging ? 1 : 0
+        sample.valid = 1
+        return sample
+    }
+
+    private func recordTelemetry(_ sample: pdev_sample_t) {
+        guard let store = telemetry else { return }
+        var sample = sample
+        ts_append(store, &sample)
+        rollup_add(rollups, &sample)
+    }
+
+    private static func openRollups() -> OpaquePointer? {
+        let dir = storageURL("rollups")
+        try? FileManager.default.createDirectory(at: dir, withIntermediateDirectories: true)
+        return rollup_open(dir.path)
+    }
+
+    /// Mean of a field in `points` equal slices of [from, to), read from the
+    /// coarsest rollup tier that still resolves one slice. Empty slices are
+    /// skipped, so the cost follows the points shown, not the samples stored.
+    func rollupSeries(_ field: rollup_field_t, from: Date, to: Date = BatteryManager.now(),
+                      points: Int) -> [(date: Date, mean: Double)] {
+        guard let r = rollups, points > 0, to > from else { return [] }
+        let fromMs = Int64(from.timeIntervalSince1970 * 1000)
+        let toMs = Int64(to.timeIntervalSince1970 * 1000)
+        let slice = max((toMs - fromMs) / Int64(points), 1)
+        let tier = rollup_pick_tier(slice)
+        let width = rollup_tier_width(tier)
+        // Include the bucket that straddles `from`
+        let start = fromMs - fromMs % width
+        var buckets = [rollup_bucket_t](repeating: rollup_bucket_t(),
+                                        count: Int((toMs - start) / width) + 1)
+        let n = Int(rollup_query(r, tier, start, toMs, &buckets, buckets.count))
+        guard n > 0 else { return [] }
+
+        var sums = [Double](repeating: 0, count: points)
+        var counts = [Double](repeating: 0, count: points)
+        let f = Int(field.rawValue)
+        for b in buckets.prefix(n) {
+            let i = min(max(Int((b.start_ms - fromMs) / slice), 0), points - 1)
+            let sum = withUnsafeBytes(of: b.sum) { $0.bindMemory(to: Double.self)[f] }
+            sums[i] += sum
+            counts[i] += Double(b.count)
+        }
+        return (0..<points).compactMap { i in
+            guard counts[i] > 0 else { return nil }
+            let date = Date(timeIntervalSince1970: Double(fromMs + Int64(i) * slice) / 1000)
+            return (date: date, mean: sums[i] / counts[i])
+        }
+    }
+
+    /// Means per local calendar day over the last `days` days, today included,
+    /// one per field. Built from the 1h tier: 1d buckets end at UTC midnight,
+    /// which is not where the user's days end. Hours are assigned by their
+    /// start, so in half-hour time zones a day boundary is off by 30 minutes.
+    func dailyMeans(_ fields: [rollup_field_t], days: Int) -> [(date: Date, means: [Double])] {
+        let calendar = Calendar.current
+        let now = Self.now()
+        guard let r = rollups, days > 0, !fields.isEmpty,
+              let first = calendar.date(byAdding: .day, value: -(days - 1), to: calendar.startOfDay(for: now))
+        else { return [] }
+        let tier = Int32(ROLLUP_1H.rawValue)
+        let width = rollup_tier_width(tier)
+        let fromMs = Int64(first.timeIntervalSince1970 * 1000)
+        let toMs = Int64(now.timeIntervalSince1970 * 1000) + 1
+        // Include the hour that straddles local midnight in half-hour zones
+        let start = fromMs - fromMs % width
+        var buckets = [rollup_bucket_t](repeating: rollup_bucket_t(),
+                                        count: Int((toMs - start) / width) + 1)
+        let n = Int(rollup_query(r, tier, start, toMs, &buckets, buckets.count))
+        guard n > 0 else { return [] }
+
+        var sums = [[Double]](repeating: [Double](repeating: 0, count: fields.count), count: days)
+        var counts = [Double](repeating: 0, count: days)
+        for b in buckets.prefix(n) {
+            let day = calendar.startOfDay(for: Date(timeIntervalSince1970: Double(b.start_ms) / 1000))
+            guard let i = calendar.dateComponents([.day], from: first, to: day).day,
+                  i >= 0, i < days else { continue }
+            withUnsafeBytes(of: b.sum) { raw in
+                let sum = raw.bindMemory(to: Double.self)
+                for (j, field) in fields.enumerated() {
+                    sums[i][j] += sum[Int(field.rawValue)]
+                }
+            }
+            counts[i] += Double(b.count)
+        }
+        return (0..<days).compactMap { i in
+            guard counts[i] > 0,
+                  let date = calendar.date(byAdding: .day, value: i, to: first) else { return nil }
+            return (date: date, means: sums[i].map { $0 / counts[i] })
+        }
+    }
+
+    /// One column summarised over the last `days` days; nil when there is no data.
+    /// Whole chunks are answered from the store's index without decoding.
+    func telemetrySummary(_ column: ts_column_t, days: Int) -> ts_aggregate_t? {
+        guard let store = telemetry else { return nil }
+        let now = Int64(Self.now().timeIntervalSince1970 * 1000)
+        var agg = ts_aggregate_t()
+        guard ts_aggregate(store, now - Int64(days) * 86_400_000, now + 1, Int32(column.rawValue), &agg) == 0,
+              agg.count > 0 else { return nil }
+        return agg
+    }
+
+    /// Replays the last `days` of telemetry through the current charge policy
+    /// with each limit in place of the user's (100 = no Sailing Mode), all
+    /// limits in parallel; nil without enough history
+    func simulateLimits(_ limits: [Int], days: Int) -> [(limit: Int, result: psim_result_t)]? {
+        guard let store = telemetry, maxCapacity > 0, !limits.isEmpty else { return nil }
+        let now = Int64(Self.now().timeIntervalSince1970 * 1000)
+        var samples: [pdev_sample_t] = []
+        let columns = UInt32((1 << TS_NCOLS.rawValue) - 1)
+        let visited = withUnsafeMutablePointer(to: &samples) { out in
+            ts_scan(store, now - Int64(days) * 86_400_000, now + 1, columns, { batch, n, ctx in
+                let out = ctx!.assumingMemoryBound(to: [pdev_sample_t].self)
+                out.pointee.append(contentsOf: UnsafeBufferPointer(start: batch, count: n))
+                return 0
+            }, out)
+        }
+        guard visited > 1 else { return nil }
+
+        let policies: [cc_config_t] = limits.map { limit in
+            var config = chargeControlConfig()
+            config.limit = UInt8(clamping: limit)
+            config.sailing = limit < 100 ? 1 : 0
+            config.travel_until_ms = 0
+            config.full_by_ms = 0
+            return config
+        }
+        var results = [psim_result_t](repeating: psim_result_t(), count: policies.count)
+        let ran = samples.withUnsafeBufferPointer { buf -> Int32 in
+            var trace = psim_trace_t(samples: buf.baseAddress, count: buf.count,
+                                     capacity_mah: Int32(maxCapacity), adapter_w: Int32(max(adapterWatts, 1)))
+            return psim_run_many(&trace, policies, &results, Int32(policies.count), 0)
+        }
+        guard ran == policies.count else { return nil }
+        return Array(zip(limits, results)).map { (limit: $0.0, result: $0.1) }
+    }
+
+    // MARK: - SMC Sensors
+
+    private func openSensorCatalog() {
+        guard smc_open() == 0 else { return }
+        let dir = FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask)[0]
+            .appendingPathComponent("BrewCap", isDirectory: true)
+        try? FileManager.default.createDirectory(at: dir, withIntermediateDirectories: true)
+        smcCatalog = smc_catalog_create(dir.appendingPathComponent("smc-catalog").path)
+        if smcCatalog == nil { smc_close() }
+    }
+
+    /// One batched read of every catalogued key, or nil without SMC access
+    private func sweepSensors() -> smc_sensor_frame_t? {
+        guard let cat = smcCatalog else { return nil }
+        var frame = smc_sensor_frame_t()
+        return smc_sensor_sweep(cat, &frame) == 0 ? frame : nil
+    }
+
+    private static func temperatures(in frame: smc_sensor_frame_t) -> [(key: String, celsius: Double)] {
+        var keys = frame.temp_keys
+        var temps = frame.temps_c
+        let count = Int(frame.temp_count)
+        return withUnsafeBytes(of: &keys) { keyBytes in
+            withUnsafeBytes(of: &temps) { tempBytes in
+                let t = tempBytes.bindMemory(to: Float.self)
+                return (0..<count).map { i in
+                    let raw = keyBytes[(i * 5)..<(i * 5 + 4)]
+                    let key = String(decoding: raw, as: UTF8.self)
+                    return (key: key, celsius: Double(t[i]))
+                }
+            }
+        }
+    }
+
     // MARK: - IOKit Battery Reading
 
     struct BatteryInfo {
@@ -866,6 +1897,7 @@ class BatteryManager: ObservableObject {
         var cycleCount = 0
         var designCapacity = 0
         var maxCapacity = 0
+        var rawCurrentCapacity = 0 // mAh
         var adapterWatts = 0
         var adapterName = "None"
         var amperage = 0
@@ -880,7 +1912,7 @@ class BatteryManager: ObservableObject {
         var info = BatteryInfo()
 
         let service = IOServiceGetMatchingService(kIOMainPortDefault, IOServiceMatching("AppleSmartBattery"))
-        guard service != IO_OBJECT_NULL else { return info }
+        guard service != IO_OBJECT_NULL || simulator != nil else { return info }
         defer { IOObjectRelease(service) }
 
         // Core
@@ -895,6 +1927,11 @@ class BatteryManager: ObservableObject {
         if let cc = prop(service, "CycleCount") as? Int { info.cycleCount = cc }
 
         if let dc = prop(service, "DesignCapacity") as? Int { info.designCapacity = dc }
+        if let rc = prop(service, "AppleRawCurrentCapacity") as? Int {
+            info.rawCurrentCapacity = rc
+        } else if let rc = prop(service, "CurrentCapacity") as? Int, let mc = prop(service, "MaxCapacity") as? Int, mc > 100 {
+            info.rawCurrentCapacity = rc // Intel Macs report mAh here
+        }
         if let mc = prop(service, "AppleRawMaxCapacity") as? Int {
             info.maxCapacity = mc
         } else if let mc = prop(service, "MaxCapacity") as? Int {
@@ -989,9 +2026,76 @@ class BatteryManager: ObservableObject {
     }
 
     private static func prop(_ service: io_service_t, _ key: String) -> Any? {
-        IORegistryEntryCreateCFProperty(service, key as CFString, kCFAllocatorDefault, 0)?
+        if let sim = simulator { return simulatedProp(sim, key) }
+        return IORegistryEntryCreateCFProperty(service, key as CFString, kCFAllocatorDefault, 0)?
             .takeRetainedValue()
     }
+
+    // MARK: - Simulated Battery
+
+    /// BREWCAP_SIMULATOR=<speed> runs the app on a simulated battery
+    /// (battery_sim.h) at that many times real time. Battery reads, SMC
+    /// sensors and charger writes all go to it instead of the hardware.
+    static let simulator: OpaquePointer? = {
+        guard let speed = simulatorSpeed,
+              let sim = bsim_create(nil, Int64(Date().timeIntervalSince1970 * 1000)) else { return nil }
+        bsim_set_speed(sim, speed)
+        bsim_set_plugged(sim, 1)
+        // Mostly idle, with a busy spell every quarter hour
+        var load = bsim_load_t()
+        load.kind = Int32(BSIM_LOAD_PERIODIC.rawValue)
+        load.system_w = 6
+        load.peak_w = 35
+        load.period_ms = 15 * 60_000
+        load.duty = 0.2
+        bsim_set_load(sim, &load)
+        smc_attach_simulator(sim)
+        print("BatteryManager: simulated battery at \(speed)x")
+        return sim
+    }()
+
+    private static let simulatorSpeed: Double? = {
+        guard let value = ProcessInfo.processInfo.environment["BREWCAP_SIMULATOR"],
+              let speed = Double(value), speed > 0 else { return nil }
+        return speed
+    }()
+
+    /// The clock samples are stamped with. On the simulated battery it is
+    /// the simulator's, which runs `speed` times faster than the wall, so
+    /// every model sees the battery move at the rate its timestamps say.
+    static func now() -> Date {
+        guard let sim = simulator else { return Date() }
+        return Date(timeIntervalSince1970: Double(bsim_now_ms(sim)) / 1000)
+    }
+
+    /// The wall time at which now() reaches `date`, for timers
+    static func wallDate(_ date: Date) -> Date {
+        guard let sim = simulator, let speed = simulatorSpeed else { return date }
+        let wall = Date()
+        bsim_sync(sim, Int64(wall.timeIntervalSince1970 * 1000)) // now() as of this instant
+        return wall.addingTimeInterval(date.timeIntervalSince(now()) / speed)
+    }
+
+    /// Settings and learned state. A simulator run keeps its own suite, so
+    /// what it teaches the models never reaches the real battery's.
+    static let defaults: UserDefaults = {
+        guard simulator != nil else { return .standard }
+        return UserDefaults(suiteName: "com.brewcap.app.simulator") ?? .standard
+    }()
+
+    /// A simulator property in the types IOKit hands back
+    private static func simulatedProp(_ sim: OpaquePointer, _ key: String) -> Any? {
+        var value: Int64 = 0
+        if key == "AdapterDetails" {
+            guard bsim_property(sim, "AdapterDetails.Watts", &value) == 0 else { return nil }
+            return ["Watts": Int(value), "Name": "Simulated \(value)W"] as [String: Any]
+        }
+        guard bsim_property(sim, key, &value) == 0 else { return nil }
+        switch key {
+        case "IsCharging", "ExternalConnected", "FullyCharged", "BatteryInstalled": return value != 0
+        default: return Int(value)
+        }
+    }
 }
 
 // MARK: - Models
@@ -1020,6 +2124,27 @@ struct ChargeSession: Codable, Identifiable {
     }
 }
 
+extension ChargeSession {
+    init(record: slog_record_t) {
+        self.init(startTime: Date(timeIntervalSince1970: Double(record.start_ms) / 1000),
+                  endTime: Date(timeIntervalSince1970: Double(record.end_ms) / 1000),
+                  startLevel: Int(record.start_level),
+                  endLevel: Int(record.end_level),
+                  durationMinutes: Int(record.duration_min),
+                  adapterWatts: Int(record.adapter_watts))
+    }
+
+    var record: slog_record_t {
+        slog_record_t(start_ms: Int64(startTime.timeIntervalSince1970 * 1000),
+                      end_ms: Int64(endTime.timeIntervalSince1970 * 1000),
+                      start_level: Int16(clamping: startLevel),
+                      end_level: Int16(clamping: endLevel),
+                      duration_min: Int32(clamping: durationMinutes),
+                      adapter_watts: Int32(clamping: adapterWatts),
+                      crc: 0)
+    }
+}
+
 struct CapacitySnapshot: Codable, Identifiable {
     var id = UUID()
     let date: Date
@@ -1039,10 +2164,137 @@ struct CapacitySnapshot: Codable, Identifiable {
     }
 }
 
-struct BatteryEvent: Codable, Identifiable {
+struct PowerDevice: Identifiable {
+    let id: String
+    let name: String
+    let kind: Int32
+    let level: Int
+    let isCharging: Bool
+    let isPluggedIn: Bool
+    let watts: Double
+
+    init(info: pdev_info_t, sample: pdev_sample_t) {
+        id = fixedCString(info.id)
+        name = fixedCString(info.name)
+        kind = info.kind
+        level = Int(sample.level)
+        isCharging = sample.charging != 0
+        isPluggedIn = sample.plugged != 0
+        watts = abs(Double(sample.amperage_ma)) * Double(sample.voltage_mv) / 1_000_000
+    }
+
+    var kindLabel: String {
+        switch kind {
+        case Int32(PDEV_UPS.rawValue): return "UPS"
+        case Int32(PDEV_PERIPHERAL.rawValue): return "Accessory"
+        default: return "Battery"
+        }
+    }
+}
+
+/// Reads a fixed-size C `char[N]` field imported as a tuple
+func fixedCString<T>(_ value: T) -> String {
+    withUnsafeBytes(of: value) { raw in
+        String(decoding: raw.prefix { $0 != 0 }, as: UTF8.self)
+    }
+}
+
+/// One record standing in for everything that happened while the Mac slept
+struct SleepGap: Codable, Identifiable {
+    struct State: Codable {
+        let date: Date
+        let level: Int
+        let capacityMah: Int
+        let voltage: Double
+        let temperature: Double
+        let isPluggedIn: Bool
+        let cycleCount: Int
+
+        init(date: Date, info: BatteryManager.BatteryInfo) {
+            self.date = date
+            self.level = info.level
+            self.capacityMah = info.rawCurrentCapacity
+            self.voltage = info.voltage
+            self.temperature = info.temperature
+            self.isPluggedIn = info.isPluggedIn
+            self.cycleCount = info.cycleCount
+        }
+    }
+
     var id = UUID()
+    let start: State
+    let end: State
+
+    var duration: TimeInterval { end.date.timeIntervalSince(start.date) }
+
+    /// Net charge drawn while asleep, at the average of both voltages
+    var energyWh: Double {
+        let mah = Double(start.capacityMah - end.capacityMah)
+        return mah > 0 ? mah * (start.voltage + end.voltage) / 2 / 1000 : 0
+    }
+
+    /// Ended with more charge than it started with. Only the two ends are
+    /// known, so charge added and then drawn again does not show.
+    var chargedDuringSleep: Bool {
+        end.capacityMah > start.capacityMah || end.level > start.level
+    }
+
+    var formattedDuration: String {
+        let mins = Int(duration / 60)
+        return mins >= 60 ? "\(mins / 60)h \(mins % 60)m" : "\(mins)m"
+    }
+}
+
+struct BatteryEvent: Identifiable {
+    let id = UUID()
     let date: Date
-    let message: String
+    let code: elog_code_t
+    let args: (Int32, Int32, Int32)
+    var text: String? // EV_TEXT only
+
+    init(record: elog_record_t, text: String?) {
+        self.date = Date(timeIntervalSince1970: Double(record.t_s))
+        self.code = elog_code_t(rawValue: UInt32(record.code))
+        self.args = record.args
+        self.text = text
+    }
+
+    var message: String {
+        let a0 = Int(args.0)
+        switch code {
+        case EV_TEXT: return text ?? "—"
+        case EV_LAUNCHED: return "BrewCap launched"
+        case EV_QUIT: return "BrewCap quit"
+        case EV_CHARGER_CONNECTED: return "Charger connected — \(a0)%"
+        case EV_CHARGER_DISCONNECTED: return "Charger disconnected — \(a0)%"
+        case EV_SAILING_AUTO_OFF: return "Sailing Mode auto-disabled — battery below 20%"
+        case EV_PRESET_SET: return "Charge limit preset set to \(a0)%"
+        case EV_TEMP_ALERT: return "Temperature alert: \(String(format: "%.1f°C", Double(a0) / 100))"
+        case EV_LOW_BATTERY: return "Low battery warning: \(a0)%"
+        case EV_FULLY_CHARGED: return "Battery fully charged"
+        case EV_CRITICAL_TEMP: return "CRITICAL temperature: \(String(format: "%.1f°C", Double(a0) / 100))"
+        case EV_WOKE:
+            let mins = a0 / 60
+            let duration = mins >= 60 ? "\(mins / 60)h \(mins % 60)m" : "\(mins)m"
+            let wh = Double(args.2) / 1000
+            return "Woke after \(duration) — \(Int(args.1) >> 8)% → \(Int(args.1) & 0xFF)%" +
+                (wh > 0 ? String(format: " (%.1f Wh used)", wh) : "")
+        case EV_SETTINGS_RESET: return "All settings reset"
+        case EV_CHARGING_PAUSED: return "Charging paused at \(a0)%"
+        case EV_STATS_COPIED: return "Stats copied to clipboard"
+        case EV_SETTINGS_IMPORTED: return "Settings imported from JSON"
+        case EV_TRAVEL_ON: return "Travel Mode enabled — limit raised to 100% for \(a0)h"
+        case EV_TRAVEL_OFF: return "Travel Mode disabled — limit restored to \(a0)%"
+        case EV_CSV_EXPORTED: return "Charge history exported as CSV"
+        case EV_SETTINGS_EXPORTED: return "Settings exported as JSON"
+        case EV_THERMAL_HOLD: return "Charging paused for heat: \(String(format: "%.1f°C", Double(a0) / 100))"
+        case EV_CHARGE_CONTROL_FAULT: return "Charging control failed — charging left on"
+        case EV_CHARGE_CONTROL_RECOVERED: return "Charging control restored"
+        case EV_FULL_BY_DONE: return "Scheduled charge finished — \(a0)%"
+        case EV_CHARGE_MECHANISM_INEFFECTIVE: return "\(SMCClient.chargeMethodName(Int(a0))) did not stop charging — trying another method"
+        default: return "Unknown event \(code.rawValue)"
+        }
+    }
 
     var formattedTime: String {
         let f = DateFormatter()
@@ -1056,3 +2308,9 @@ struct BatteryEvent: Codable, Identifiable {
         return f.string(from: date)
     }
 }
+
+/// Shape of the events older versions kept as JSON in UserDefaults
+private struct LegacyEvent: Codable {
+    let date: Date
+    let message: String
+}
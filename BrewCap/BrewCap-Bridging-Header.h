@@ -6,3 +6,22 @@
 //
 
 #import "smc.h"
+#import "power_source.h"
+#import "power_device.h"
+#import "session_log.h"
+#import "telemetry_store.h"
+#import "float_codec.h"
+#import "rollup.h"
+#import "event_log.h"
+#import "wal.h"
+#import "csv_export.h"
+#import "arrow_export.h"
+#import "retention.h"
+#import "charge_control.h"
+#import "thermal_model.h"
+#import "charge_schedule.h"
+#import "unplug_model.h"
+#import "policy_sim.h"
+#import "battery_sim.h"
+#import "aging_model.h"
+#import "rainflow.h"
@@ -16,6 +16,7 @@ struct MainWindowView: View {
     @State private var showShareSheet = false
     @State private var showImportPicker = false
     @State private var flashCopied = false
+    @State private var setupRunning = false
 
     private func toggleLoginItem(_ enabled: Bool) {
         do {
@@ -181,6 +182,44 @@ struct MainWindowView: View {
                 }
                 .tint(.blue)
                 .onChange(of: batteryManager.sailingModeEnabled) { _ in haptic() }
+
+                if batteryManager.setupNeeded {
+                    setupRow
+                }
+
+                if batteryManager.sailingModeEnabled {
+                    Stepper(value: $batteryManager.sailingBandBelow, in: 0...20) {
+                        Text("Resume below \(Int(batteryManager.chargeLimit) - batteryManager.sailingBandBelow)%")
+                            .font(.caption)
+                            .foregroundStyle(.secondary)
+                    }
+                    .accessibilityLabel("Resume charging below \(Int(batteryManager.chargeLimit) - batteryManager.sailingBandBelow) percent") // Feature 58
+                    Stepper(value: $batteryManager.sailingBandAbove, in: 0...5) {
+                        Text("Pause at \(min(Int(batteryManager.chargeLimit) + batteryManager.sailingBandAbove, 100))%")
+                            .font(.caption)
+                            .foregroundStyle(.secondary)
+                    }
+                    .accessibilityLabel("Pause charging at \(min(Int(batteryManager.chargeLimit) + batteryManager.sailingBandAbove, 100)) percent") // Feature 58
+                    Stepper(value: $batteryManager.sailingMinDwell, in: 0...60, step: 5) {
+                        Text("Switch at most every \(Int(batteryManager.sailingMinDwell)) min")
+                            .font(.caption)
+                            .foregroundStyle(.secondary)
+                    }
+                    .accessibilityLabel("Minimum time between charging changes") // Feature 58
+                    Toggle(isOn: $batteryManager.predictUnplug) {
+                        VStack(alignment: .leading, spacing: 2) {
+                            Text("Top up before I usually unplug")
+                                .font(.caption)
+                            if batteryManager.predictUnplug, let unplug = batteryManager.likelyUnplug {
+                                (Text("Likely unplugged by ") + Text(unplug, style: .time))
+                                    .font(.caption2)
+                                    .foregroundStyle(.secondary)
+                            }
+                        }
+                    }
+                    .toggleStyle(.checkbox)
+                    .accessibilityLabel("Top up to 100 percent before the charger is usually unplugged") // Feature 58
+                }
             }
             .cardStyle()
 
@@ -213,6 +252,37 @@ struct MainWindowView: View {
                             .foregroundStyle(.secondary)
                     }
                 }
+
+                Divider()
+
+                // Full By: 100% at a departure time, charged as late as possible
+                Toggle(isOn: $batteryManager.fullByEnabled) {
+                    HStack {
+                        Label("Full By", systemImage: "alarm")
+                            .font(.subheadline.weight(.medium))
+                        Spacer()
+                        if batteryManager.fullByEnabled, let start = batteryManager.fullByStart {
+                            (Text("Starts ") + Text(start, style: .time))
+                                .font(.caption2)
+                                .foregroundStyle(.secondary)
+                        }
+                    }
+                }
+                .tint(.purple)
+                .onChange(of: batteryManager.fullByEnabled) { _ in haptic() }
+                .accessibilityLabel("Full by, charge to 100 percent just before a set time") // Feature 58
+
+                if batteryManager.fullByEnabled {
+                    DatePicker("Ready at", selection: $batteryManager.fullByDate, in: Date()...,
+                               displayedComponents: [.date, .hourAndMinute])
+                        .font(.caption)
+                        .foregroundStyle(.secondary)
+                        .accessibilityLabel("Time the battery should be full") // Feature 58
+                    Toggle("Every week", isOn: $batteryManager.fullByWeekly)
+                        .font(.caption)
+                        .toggleStyle(.checkbox)
+                        .accessibilityLabel("Repeat every week") // Feature 58
+                }
             }
             .cardStyle()
 
@@ -249,6 +319,10 @@ struct MainWindowView: View {
                 DetailRow(label: "Condition", value: batteryManager.batteryCondition, color: conditionColor)
                 // Feature 36
                 DetailRow(label: "Battery Age", value: String(format: "~%.1f years", batteryManager.batteryAgeYears))
+                DetailRow(label: "Est. Wear", value: String(format: "%.1f%% (%.1f calendar, %.1f cycling)",
+                                                            batteryManager.agingEstimate.total_pct,
+                                                            batteryManager.agingEstimate.calendar_pct,
+                                                            batteryManager.agingEstimate.cycle_pct))
                 // Feature 42
                 if batteryManager.estimatedReplacementDate != "—" {
                     DetailRow(label: "Est. Replacement", value: batteryManager.estimatedReplacementDate, color: .orange)
@@ -267,6 +341,16 @@ struct MainWindowView: View {
                 DetailRow(label: "Amperage", value: "\(batteryManager.amperage) mA")
                 DetailRow(label: "Voltage", value: String(format: "%.2f V", batteryManager.voltage))
                 DetailRow(label: "Temperature", value: String(format: "%.1f°C", batteryManager.temperature))
+                // SMC sensors from the per-tick sweep
+                ForEach(batteryManager.sensorTemperatures, id: \.key) { sensor in
+                    DetailRow(label: "  \(sensor.key)", value: String(format: "%.1f°C", sensor.celsius),
+                              color: sensor.celsius >= batteryManager.tempAlertThreshold ? .orange : .primary)
+                }
+                if let forecast = batteryManager.temperatureForecast {
+                    DetailRow(label: "In \(batteryManager.thermalForecastMinutes) min",
+                              value: String(format: "%.1f°C", forecast),
+                              color: forecast >= 45 ? .red : forecast >= batteryManager.tempAlertThreshold ? .orange : .primary)
+                }
                 // Feature 34
                 DetailRow(label: "Intensity", value: batteryManager.usageIntensity)
                 // Feature 35
@@ -296,6 +380,22 @@ struct MainWindowView: View {
             }
             .cardStyle()
 
+            // Additional power devices (UPS, second battery, accessories)
+            if batteryManager.powerDevices.count > 1 {
+                VStack(spacing: 10) {
+                    Label("Power Devices", systemImage: "battery.100.bolt")
+                        .font(.headline)
+                        .frame(maxWidth: .infinity, alignment: .leading)
+
+                    ForEach(batteryManager.powerDevices) { device in
+                        DetailRow(label: "\(device.name) (\(device.kindLabel))",
+                                  value: "\(device.level)%" + (device.isCharging ? " ⚡︎" : ""),
+                                  color: device.level <= 20 ? .red : .primary)
+                    }
+                }
+                .cardStyle()
+            }
+
             // Device Info Card
             VStack(spacing: 10) {
                 Label("Device Info", systemImage: "laptopcomputer")
@@ -358,6 +458,44 @@ struct MainWindowView: View {
                 .cardStyle()
             }
 
+            // Charge level over the last 30 days, from the rollup tiers
+            let levelSeries = batteryManager.rollupSeries(
+                RF_LEVEL, from: BatteryManager.now().addingTimeInterval(-30 * 86400), points: 60)
+            if levelSeries.count > 1 {
+                VStack(spacing: 10) {
+                    HStack {
+                        Label("Charge Level", systemImage: "chart.xyaxis.line")
+                            .font(.headline)
+                        Spacer()
+                        Text("30 days")
+                            .font(.caption2)
+                            .foregroundStyle(.tertiary)
+                    }
+
+                    levelChart(levelSeries)
+                }
+                .cardStyle()
+            }
+
+            // Wear by cycle depth over the last 30 days, from the rainflow count
+            let depths = batteryManager.cycleDepths(days: 30)
+            let depthCycles = depths.reduce(0) { $0 + $1.cycles }
+            if depthCycles > 0 {
+                VStack(spacing: 10) {
+                    HStack {
+                        Label("Cycle Depths", systemImage: "chart.bar.xaxis")
+                            .font(.headline)
+                        Spacer()
+                        Text(String(format: "%.0f cycles · 30 days", depthCycles))
+                            .font(.caption2)
+                            .foregroundStyle(.tertiary)
+                    }
+
+                    depthChart(depths)
+                }
+                .cardStyle()
+            }
+
             // Feature 52: Event Log
             if !batteryManager.eventLog.isEmpty {
                 VStack(spacing: 10) {
@@ -440,6 +578,28 @@ struct MainWindowView: View {
                 .controlSize(.small)
                 .accessibilityLabel("Export charge history as CSV") // Feature 58
 
+                Button {
+                    exportTelemetryCSV()
+                    haptic()
+                } label: {
+                    Label("Samples", systemImage: "waveform.path.ecg")
+                        .frame(maxWidth: .infinity)
+                }
+                .buttonStyle(.bordered)
+                .controlSize(.small)
+                .accessibilityLabel("Export recorded battery samples as CSV") // Feature 58
+
+                Button {
+                    exportArrow()
+                    haptic()
+                } label: {
+                    Label("Arrow", systemImage: "square.stack.3d.up")
+                        .frame(maxWidth: .infinity)
+                }
+                .buttonStyle(.bordered)
+                .controlSize(.small)
+                .accessibilityLabel("Export history as Arrow files for analysis") // Feature 58
+
                 // Feature 21: Report
                 Button {
                     if let url = ReportGenerator.saveToDesktop(from: batteryManager) {
@@ -524,6 +684,67 @@ struct MainWindowView: View {
         .accessibilityLabel("Capacity trend chart showing \(snapshots.count) data points") // Feature 58
     }
 
+    private func levelChart(_ series: [(date: Date, mean: Double)]) -> some View {
+        GeometryReader { geo in
+            let w = geo.size.width
+            let h = geo.size.height
+            let t0 = series.first!.date.timeIntervalSince1970
+            let span = max(series.last!.date.timeIntervalSince1970 - t0, 1)
+
+            Path { path in
+                for (i, point) in series.enumerated() {
+                    let x = w * CGFloat((point.date.timeIntervalSince1970 - t0) / span)
+                    let y = h * (1 - CGFloat(point.mean / 100))
+                    if i == 0 {
+                        path.move(to: CGPoint(x: x, y: y))
+                    } else {
+                        path.addLine(to: CGPoint(x: x, y: y))
+                    }
+                }
+            }
+            .stroke(Color.green, lineWidth: 2)
+        }
+        .frame(height: 80)
+        .accessibilityLabel("Charge level chart showing \(series.count) data points") // Feature 58
+    }
+
+    // Wear per depth bin as bars, shallow on the left
+    private func depthChart(_ depths: [(depth: Int, cycles: Double, wear: Double)]) -> some View {
+        let maxWear = max(depths.map(\.wear).max() ?? 0, 1e-9)
+        let deep = depths.filter { $0.depth >= 50 }.reduce(0) { $0 + $1.wear }
+        let total = depths.reduce(0) { $0 + $1.wear }
+
+        return VStack(spacing: 4) {
+            GeometryReader { geo in
+                let w = geo.size.width
+                let h = geo.size.height
+                let slot = w / CGFloat(depths.count)
+
+                Path { path in
+                    for (i, bin) in depths.enumerated() where bin.wear > 0 {
+                        let barH = h * CGFloat(bin.wear / maxWear)
+                        path.addRect(CGRect(x: CGFloat(i) * slot + 1, y: h - barH,
+                                            width: max(slot - 2, 1), height: barH))
+                    }
+                }
+                .fill(Color.purple.opacity(0.7))
+            }
+            .frame(height: 80)
+
+            HStack {
+                Text("0%")
+                Spacer()
+                Text("50%")
+                Spacer()
+                Text("100% depth")
+            }
+            .font(.system(size: 8))
+            .foregroundStyle(.tertiary)
+        }
+        .accessibilityElement(children: .ignore) // Feature 58
+        .accessibilityLabel("Wear by cycle depth, \(total > 0 ? Int(deep / total * 100) : 0) percent from cycles deeper than 50 percent") // Feature 58
+    }
+
     // MARK: - Tab 3: Settings
 
     private var settingsTab: some View {
@@ -545,6 +766,22 @@ struct MainWindowView: View {
                 }
                 .accessibilityLabel("Temperature alert threshold: \(Int(batteryManager.tempAlertThreshold)) degrees") // Feature 58
 
+                HStack {
+                    Text("Heat Forecast")
+                        .font(.subheadline)
+                    Spacer()
+                    Picker("", selection: $batteryManager.thermalForecastMinutes) {
+                        Text("Off").tag(0)
+                        Text("5 min").tag(5)
+                        Text("10 min").tag(10)
+                        Text("20 min").tag(20)
+                    }
+                    .pickerStyle(.segmented)
+                    .frame(width: 220)
+                    .onChange(of: batteryManager.thermalForecastMinutes) { _ in haptic() }
+                }
+                .accessibilityLabel("Pause charging when the temperature forecast reaches 45 degrees") // Feature 58
+
                 HStack {
                     Text("Low Battery")
                         .font(.subheadline)
@@ -624,6 +861,21 @@ struct MainWindowView: View {
                         .font(.caption.monospacedDigit())
                         .frame(width: 30)
                 }
+
+                HStack {
+                    Text("History Durability")
+                        .font(.subheadline)
+                    Spacer()
+                    Picker("", selection: $batteryManager.historyDurability) {
+                        Text("Max").tag(0)
+                        Text("Balanced").tag(1)
+                        Text("Saver").tag(2)
+                    }
+                    .pickerStyle(.segmented)
+                    .frame(width: 200)
+                    .onChange(of: batteryManager.historyDurability) { _ in haptic() }
+                }
+                .accessibilityLabel("History durability") // Feature 58
             }
             .cardStyle()
 
@@ -713,6 +965,29 @@ struct MainWindowView: View {
         .background(.bar)
     }
 
+    // MARK: - Charging Control Setup
+
+    /// The one-time admin prompt, or its re-run after an update that needs
+    /// more of the charging keys
+    private var setupRow: some View {
+        HStack(spacing: 8) {
+            Image(systemName: "lock.shield")
+                .foregroundStyle(.orange)
+            Text(SMCClient.needsSetupUpdate
+                 ? "Setup needs updating to use every charging method"
+                 : "Charging control needs a one-time setup")
+                .font(.caption)
+                .foregroundStyle(.secondary)
+            Spacer()
+            Button(setupRunning ? "Running…" : "Run Setup") {
+                setupRunning = true
+                batteryManager.runSetup { _ in setupRunning = false }
+            }
+            .controlSize(.small)
+            .disabled(setupRunning)
+        }
+    }
+
     // MARK: - Onboarding
 
     private var onboardingSheet: some View {
@@ -754,14 +1029,39 @@ struct MainWindowView: View {
     // MARK: - Feature 49: CSV Export
 
     private func exportCSV() {
-        let csv = batteryManager.exportChargeHistoryCSV()
         let panel = NSSavePanel()
         panel.allowedContentTypes = [.commaSeparatedText]
         panel.nameFieldStringValue = "BrewCap_History.csv"
         panel.begin { result in
-            if result == .OK, let url = panel.url {
-                try? csv.write(to: url, atomically: true, encoding: .utf8)
-                batteryManager.logEvent("Charge history exported as CSV")
+            if result == .OK, let url = panel.url,
+               batteryManager.exportChargeHistoryCSV(to: url) {
+                batteryManager.logEvent(EV_CSV_EXPORTED)
+            }
+        }
+    }
+
+    private func exportArrow() {
+        let panel = NSOpenPanel()
+        panel.canChooseDirectories = true
+        panel.canChooseFiles = false
+        panel.canCreateDirectories = true
+        panel.prompt = "Export"
+        panel.message = "Choose a folder for the sessions, capacity and samples files"
+        panel.begin { result in
+            if result == .OK, let url = panel.url, batteryManager.exportArrow(to: url) {
+                NSWorkspace.shared.selectFile(nil, inFileViewerRootedAtPath: url.path)
+            }
+        }
+    }
+
+    private func exportTelemetryCSV() {
+        let panel = NSSavePanel()
+        panel.allowedContentTypes = [.commaSeparatedText]
+        panel.nameFieldStringValue = "BrewCap_Samples.csv"
+        panel.begin { result in
+            if result == .OK, let url = panel.url,
+               batteryManager.exportTelemetryCSV(to: url) {
+                batteryManager.logEvent(EV_CSV_EXPORTED)
             }
         }
     }
@@ -786,7 +1086,7 @@ struct MainWindowView: View {
         panel.begin { result in
             if result == .OK, let url = panel.url {
                 try? data.write(to: url)
-                batteryManager.logEvent("Settings exported as JSON")
+                batteryManager.logEvent(EV_SETTINGS_EXPORTED)
             }
         }
     }
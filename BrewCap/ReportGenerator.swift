@@ -33,11 +33,28 @@ struct ReportGenerator {
         lines.append("  Design Capacity:    \(manager.designCapacity) mAh")
         lines.append("  Current Max:        \(manager.maxCapacity) mAh")
         lines.append("  Capacity Lost:      \(manager.designCapacity - manager.maxCapacity) mAh")
+        let aging = manager.agingEstimate
+        lines.append("  Est. Wear:          \(String(format: "%.1f%% (%.1f%% calendar, %.1f%% cycling), %.0f%% of budget", aging.total_pct, aging.calendar_pct, aging.cycle_pct, aging.budget_used * 100))")
+        lines.append("  Wear-Equiv. Age:    \(String(format: "%.1f years", aging.equivalent_years))")
+        if aging.worst_share > 0 {
+            let level = Int(age_soc_bin_low(Int32(aging.worst_soc_bin)))
+            let temp = Int(age_temp_bin_low(Int32(aging.worst_temp_bin)))
+            let band = temp < -50 ? "below 15°C"
+                : aging.worst_temp_bin == AGE_TEMP_BINS - 1 ? "\(temp)°C and up" : "\(temp)–\(temp + 5)°C"
+            lines.append("  Most Calendar Wear: \(level)–\(level + 10)% at \(band) (\(Int(aging.worst_share * 100))%)")
+        }
+        if manager.estimatedReplacementDate != "—" {
+            lines.append("  Est. Replacement:   \(manager.estimatedReplacementDate)")
+        }
         lines.append("")
 
         lines.append("── Electrical ───────────────────────")
         lines.append("  Voltage:            \(String(format: "%.2fV", manager.voltage))")
         lines.append("  Amperage:           \(manager.amperage) mA")
+        if !manager.sensorTemperatures.isEmpty {
+            let sensors = manager.sensorTemperatures.map { String(format: "%@ %.1f°C", $0.key, $0.celsius) }
+            lines.append("  SMC Sensors:        \(sensors.joined(separator: ", "))")
+        }
         lines.append("  Time Remaining:     \(manager.timeRemaining)")
         lines.append("")
 
@@ -57,11 +74,78 @@ struct ReportGenerator {
         lines.append("  Charge Limit:       \(Int(manager.chargeLimit))%")
         lines.append("  Sailing Mode:       \(manager.sailingModeEnabled ? "On" : "Off")")
         lines.append("  Charging Inhibited: \(manager.chargingInhibited ? "Yes" : "No")")
+        lines.append("  Sailing Band:       \(Int(manager.chargeLimit) - manager.sailingBandBelow)% – \(Int(manager.chargeLimit) + manager.sailingBandAbove)%, \(Int(manager.sailingMinDwell)) min dwell")
+        if let rates = manager.chargeControlRates() {
+            lines.append("  Charge Control:     \(String(format: "%.1f changes/hr, %.1f writes/hr, %d deferred", rates.transitions, rates.writes, rates.deferred))")
+        }
+        let mechanisms = manager.chargeMechanismRecords().filter { $0.confirmed + $0.refuted > 0 }
+        if !mechanisms.isEmpty {
+            let summary = mechanisms.map { "\($0.name) \($0.confirmed)✓ \($0.refuted)✗" }.joined(separator: ", ")
+            lines.append("  Inhibit Methods:    \(summary)")
+        }
+        if let whatIf = manager.simulateLimits([70, 80, 90, 100], days: 7) {
+            lines.append("  What-If (last 7 days, replayed):")
+            for (limit, r) in whatIf {
+                lines.append("    \(limit)% limit: \(String(format: "%.1fh ≥90%%, %.2f cycles, %.1fh >35°C, %lld writes", r.hours_high, r.cycles, r.hours_hot, r.writes))")
+            }
+        }
+        if manager.predictUnplug {
+            let formatter = DateFormatter()
+            formatter.dateFormat = "EEE HH:mm"
+            let unplug = manager.likelyUnplug.map { "likely by \(formatter.string(from: $0))" } ?? "not expected within a day"
+            lines.append("  Unplug Forecast:    \(unplug)")
+        }
+        if manager.fullByEnabled {
+            let formatter = DateFormatter()
+            formatter.dateFormat = "EEE HH:mm"
+            var line = "  Full By:            \(formatter.string(from: manager.fullByDate))"
+            if let start = manager.fullByStart { line += ", charging from \(formatter.string(from: start))" }
+            if let minutes = manager.minutesToFull() { line += " (\(minutes) min to full)" }
+            lines.append(line)
+        }
         lines.append("  Temp Alert:         \(Int(manager.tempAlertThreshold))°C")
         lines.append("  Low Battery Alert:  \(manager.lowBatteryThreshold)%")
         lines.append("  Monitor Interval:   \(Int(manager.monitoringInterval))s")
+        lines.append("  Monitor Wakeups:    \(String(format: "%.0f/hr (%.1f tasks each)", TaskScheduler.shared.wakeupsPerHour, TaskScheduler.shared.tasksPerWakeup))")
         lines.append("")
 
+        if let temp = manager.telemetrySummary(TS_COL_TEMP, days: 7) {
+            lines.append("── Last 7 Days ──────────────────────")
+            lines.append("  Samples:            \(temp.count)")
+            lines.append("  Temperature:        \(String(format: "avg %.1f°C, max %.1f°C", temp.sum / Double(temp.count) / 100, temp.max / 100))")
+            if let watts = manager.telemetrySummary(TS_COL_WATTS, days: 7) {
+                lines.append("  Power Draw:         \(String(format: "avg %.1f W, peak %.1f W", watts.sum / Double(watts.count), watts.max))")
+            }
+            if let level = manager.telemetrySummary(TS_COL_LEVEL, days: 7) {
+                lines.append("  Charge Range:       \(Int(level.min))% – \(Int(level.max))%")
+            }
+            lines.append("")
+        }
+
+        let dayFormatter = DateFormatter()
+        dayFormatter.dateFormat = "EEE MMM d"
+        let daily = manager.dailyMeans([RF_TEMP, RF_PLUGGED], days: 7)
+        if !daily.isEmpty {
+            lines.append("── Daily Averages ───────────────────")
+            for day in daily {
+                let temp = String(format: "%.1f°C", day.means[0] / 100)
+                let plugged = String(format: "%3.0f%% plugged in", day.means[1] * 100)
+                lines.append("  \(dayFormatter.string(from: day.date))  │  \(temp)  │  \(plugged)")
+            }
+            lines.append("")
+        }
+
+        let depths = manager.cycleDepths(days: 30).filter { $0.cycles > 0 }
+        if !depths.isEmpty {
+            lines.append("── Cycle Depths (30 Days) ───────────")
+            let wear = depths.reduce(0) { $0 + $1.wear }
+            for bin in depths {
+                let share = wear > 0 ? bin.wear / wear * 100 : 0
+                lines.append("  \(String(format: "%3d–%3d%%", bin.depth, bin.depth + 5))  │  \(String(format: "%6.1f cycles", bin.cycles))  │  \(String(format: "%.3f%% wear (%.0f%%)", bin.wear, share))")
+            }
+            lines.append("")
+        }
+
         if !manager.chargeHistory.isEmpty {
             lines.append("── Charge History (Last \(manager.chargeHistory.count)) ──")
             for session in manager.chargeHistory.prefix(10) {
@@ -71,6 +155,17 @@ struct ReportGenerator {
             lines.append("")
         }
 
+        if !manager.sleepGaps.isEmpty {
+            lines.append("── Sleep (Last \(min(manager.sleepGaps.count, 10))) ────────────────────")
+            let sleepFormatter = DateFormatter()
+            sleepFormatter.dateFormat = "MMM d, HH:mm"
+            for gap in manager.sleepGaps.prefix(10) {
+                let change = gap.chargedDuringSleep ? "charged" : String(format: "%.2f Wh drawn", gap.energyWh)
+                lines.append("  \(sleepFormatter.string(from: gap.start.date))  │  \(gap.formattedDuration)  │  \(gap.start.level)% → \(gap.end.level)%  │  \(change)  │  \(gap.start.isPluggedIn ? "AC" : "Battery") → \(gap.end.isPluggedIn ? "AC" : "Battery")")
+            }
+            lines.append("")
+        }
+
         lines.append("═══════════════════════════════════════")
         lines.append("  Report by BrewCap v1.0")
         lines.append("═══════════════════════════════════════")
@@ -22,9 +22,35 @@ class SMCClient {
         return Bundle.main.path(forResource: "smc", ofType: nil) ?? ""
     }
 
-    /// Whether the one-time visudo setup has been completed
+    /// Whether the one-time visudo setup has been completed. A simulated
+    /// battery needs no setup.
     static var isSetupComplete: Bool {
-        UserDefaults.standard.bool(forKey: "brewcap_setup_complete")
+        installedSetupVersion > 0
+    }
+
+    /// Version of the sudoers entry the setup writes; bump it whenever the
+    /// entry allows new commands. 2 added CH0B and CH0I.
+    static let setupVersion = 2
+
+    /// The version installed on this Mac: 0 for none, 1 for a setup from
+    /// before versions were recorded
+    static var installedSetupVersion: Int {
+        if BatteryManager.simulator != nil { return setupVersion }
+        let version = UserDefaults.standard.integer(forKey: "brewcap_setup_version")
+        if version > 0 { return version }
+        return UserDefaults.standard.bool(forKey: "brewcap_setup_complete") ? 1 : 0
+    }
+
+    /// Setup was run, but by a version whose entry lacks commands used now
+    static var needsSetupUpdate: Bool {
+        (1..<setupVersion).contains(installedSetupVersion)
+    }
+
+    /// Methods `sudo -n` refuses with the installed entry, as a mask over
+    /// smc_charge_method_t; charge control leaves them alone until setup is
+    /// run again
+    static var unavailableMethods: UInt32 {
+        installedSetupVersion >= 2 ? 0 : 1 << SMC_CHARGE_CH0B.rawValue | 1 << SMC_CHARGE_CH0I.rawValue
     }
 
     // MARK: - One-time Setup (installs smc + visudo entry)
@@ -52,6 +78,10 @@ class SMCClient {
         ALL ALL = NOPASSWD: \(installPath) -k CHIE -r
         ALL ALL = NOPASSWD: \(installPath) -k CHIE -w 08
         ALL ALL = NOPASSWD: \(installPath) -k CHIE -w 00
+        ALL ALL = NOPASSWD: \(installPath) -k CH0B -w 02
+        ALL ALL = NOPASSWD: \(installPath) -k CH0B -w 00
+        ALL ALL = NOPASSWD: \(installPath) -k CH0I -w 01
+        ALL ALL = NOPASSWD: \(installPath) -k CH0I -w 00
         """
 
         let escapedBundled = bundledSmc.replacingOccurrences(of: "'", with: "'\\''")
@@ -91,6 +121,7 @@ class SMCClient {
 
             if process.terminationStatus == 0 {
                 UserDefaults.standard.set(true, forKey: "brewcap_setup_complete")
+                UserDefaults.standard.set(setupVersion, forKey: "brewcap_setup_version")
                 print("SMCClient: setup complete — no more password prompts!")
                 return true
             } else {
@@ -137,7 +168,8 @@ class SMCClient {
 
         let process = Process()
         process.executableURL = URL(fileURLWithPath: "/usr/bin/sudo")
-        process.arguments = [path, "-k", key, "-w", hex]
+        // -n: a key missing from the sudoers entry fails instead of prompting
+        process.arguments = ["-n", path, "-k", key, "-w", hex]
 
         let pipe = Pipe()
         let errPipe = Pipe()
@@ -167,16 +199,48 @@ class SMCClient {
 
     /// Disable charging via CHTE key (macOS 26 Tahoe)
     static func disableCharging() -> Bool {
-        return writeKey("CHTE", hex: "01000000")
+        return setCharging(false, method: SMC_CHARGE_CHTE)
     }
 
-    /// Enable charging via CHTE key
+    /// Enable charging through every method, whichever one turned it off
     static func enableCharging() -> Bool {
-        return writeKey("CHTE", hex: "00000000")
+        var enabled = false
+        for raw in 0..<SMC_CHARGE_METHODS.rawValue where unavailableMethods & 1 << raw == 0 {
+            if setCharging(true, method: smc_charge_method_t(rawValue: raw)) { enabled = true }
+        }
+        return enabled
+    }
+
+    /// One charging mechanism on its own, so charge control can find out
+    /// which of them actually stops the current on this Mac. SMC keys go
+    /// through the installed smc CLI under sudo; ChargeInhibit is an IORegistry
+    /// property set in-process, which only works where the app is allowed to.
+    /// A simulated battery takes every method in-process.
+    static func setCharging(_ enabled: Bool, method: smc_charge_method_t) -> Bool {
+        if BatteryManager.simulator != nil {
+            return smc_set_charging(method, enabled ? 1 : 0) == 0
+        }
+        switch method {
+        case SMC_CHARGE_CHTE: return writeKey("CHTE", hex: enabled ? "00000000" : "01000000")
+        case SMC_CHARGE_CH0B: return writeKey("CH0B", hex: enabled ? "00" : "02")
+        case SMC_CHARGE_CH0I: return writeKey("CH0I", hex: enabled ? "00" : "01")
+        case SMC_CHARGE_INHIBIT: return smc_set_charging(method, enabled ? 1 : 0) == 0
+        default: return false
+        }
+    }
+
+    static func chargeMethodName(_ method: Int) -> String {
+        let names = ["CHTE", "CH0B", "CH0I", "ChargeInhibit"]
+        return names.indices.contains(method) ? names[method] : "Method \(method)"
     }
 
     /// Check if charging is currently inhibited
     static func isChargingInhibited() -> Bool {
+        if BatteryManager.simulator != nil {
+            var bytes = [UInt8](repeating: 0, count: 32)
+            var size: UInt32 = 0
+            return smc_read_key("CHTE", &bytes, &size) == 0 && bytes[0] != 0
+        }
         guard let output = readKey("CHTE") else { return false }
         // Output looks like: "  CHTE  [ui32]  (bytes 01 00 00 00)"
         // Extract the first byte after "bytes "
@@ -0,0 +1,127 @@
+//
+//  TaskScheduler.swift
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+import Foundation
+import AppKit
+
+/// Single-timer scheduler for all of BrewCap's periodic work.
+/// Each task has a due time and a tolerance; the one underlying timer is armed
+/// for the earliest `due + tolerance`, and every task already due at that point
+/// runs in the same wakeup. Main thread only.
+final class TaskScheduler {
+    static let shared = TaskScheduler()
+
+    private struct Task {
+        var interval: TimeInterval?   // nil = one-shot
+        var tolerance: TimeInterval
+        var due: Date
+        let work: () -> Void
+    }
+
+    private var tasks: [String: Task] = [:]
+    private var timer: DispatchSourceTimer?
+    private var armedFor: Date?
+
+    // MARK: - Energy Stats
+
+    private(set) var wakeups = 0
+    private(set) var tasksRun = 0
+    private let startedAt = Date()
+
+    /// Timer wakeups per hour since launch — the monitor's own energy cost
+    var wakeupsPerHour: Double {
+        let hours = Date().timeIntervalSince(startedAt) / 3600
+        return hours > 0.01 ? Double(wakeups) / hours : 0
+    }
+
+    /// Average tasks served per wakeup; > 1 means coalescing is working
+    var tasksPerWakeup: Double {
+        wakeups > 0 ? Double(tasksRun) / Double(wakeups) : 0
+    }
+
+    private init() {
+        // Wall-clock due times drift from the monotonic timer across sleep
+        NSWorkspace.shared.notificationCenter.addObserver(
+            forName: NSWorkspace.didWakeNotification, object: nil, queue: .main
+        ) { [weak self] _ in
+            self?.rearm()
+        }
+    }
+
+    // MARK: - Registration
+
+    /// Registers (or replaces) a repeating task. Tolerance defaults to 10% of
+    /// the interval, the same slack macOS recommends for `Timer.tolerance`.
+    func schedule(_ name: String, every interval: TimeInterval, tolerance: TimeInterval? = nil,
+                  runNow: Bool = false, _ work: @escaping () -> Void) {
+        let tol = tolerance ?? interval * 0.1
+        tasks[name] = Task(interval: interval, tolerance: tol,
+                           due: Date().addingTimeInterval(runNow ? 0 : interval), work: work)
+        rearm()
+    }
+
+    /// Registers (or replaces) a one-shot task at a wall-clock date
+    func schedule(_ name: String, at date: Date, tolerance: TimeInterval = 60,
+                  _ work: @escaping () -> Void) {
+        tasks[name] = Task(interval: nil, tolerance: tolerance, due: date, work: work)
+        rearm()
+    }
+
+    func cancel(_ name: String) {
+        guard tasks.removeValue(forKey: name) != nil else { return }
+        rearm()
+    }
+
+    func isScheduled(_ name: String) -> Bool { tasks[name] != nil }
+
+    // MARK: - Timer
+
+    private func rearm() {
+        guard let deadline = tasks.values.map({ $0.due.addingTimeInterval($0.tolerance) }).min() else {
+            timer?.cancel()
+            timer = nil
+            armedFor = nil
+            return
+        }
+        if armedFor == deadline, timer != nil { return }
+
+        if timer == nil {
+            let t = DispatchSource.makeTimerSource(queue: .main)
+            t.setEventHandler { [weak self] in self?.fire() }
+            t.resume()
+            timer = t
+        }
+        armedFor = deadline
+        let delay = max(0, deadline.timeIntervalSinceNow)
+        // The leeway lets the OS fold our wakeup into other processes' timers too
+        timer?.schedule(deadline: .now() + delay, repeating: .never,
+                        leeway: .milliseconds(Int(min(delay * 0.05, 5) * 1000)))
+    }
+
+    private func fire() {
+        wakeups += 1
+        armedFor = nil
+        let now = Date()
+
+        let due = tasks.filter { $0.value.due <= now }
+        for (name, task) in due {
+            if let interval = task.interval {
+                // Skip missed periods (e.g. after sleep) instead of bursting
+                var next = task.due.addingTimeInterval(interval)
+                if next <= now { next = now.addingTimeInterval(interval) }
+                tasks[name]?.due = next
+            } else {
+                tasks.removeValue(forKey: name)
+            }
+        }
+        for (_, task) in due {
+            tasksRun += 1
+            task.work()
+        }
+        rearm()
+    }
+}
@@ -0,0 +1,234 @@
+//
+//  aging_model.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "aging_model.h"
+#include <math.h>
+#include <string.h>
+
+#define DAY_MS 86400000.0
+#define GAS_R 8.314
+#define REF_K 298.15
+#define REST_C 25.0 // ceiling for the temperature across a long gap
+
+// Calendar rate relative to 50% at 0, 10, ... 100%: slow while the anode is
+// lithium-poor, then a step up past about 60%
+static const double k_soc_factor[11] = {0.45, 0.5, 0.55, 0.65, 0.8, 1.0,
+                                        1.25, 1.4, 1.5, 1.6, 1.8};
+
+static double clamp(double x, double lo, double hi) {
+  return x < lo ? lo : x > hi ? hi : x;
+}
+
+static double arrhenius(double ea, double temp_c) {
+  return exp(ea / GAS_R * (1.0 / REF_K - 1.0 / (temp_c + 273.15)));
+}
+
+static double soc_factor(double level) {
+  double x = clamp(level, 0, 100) / 10.0;
+  int i = (int)x;
+  if (i >= 10)
+    return k_soc_factor[10];
+  return k_soc_factor[i] + (k_soc_factor[i + 1] - k_soc_factor[i]) * (x - i);
+}
+
+static double calendar_rate(double level, double temp_c) {
+  return AGE_CAL_K_REF * soc_factor(level) * arrhenius(AGE_CAL_EA, temp_c);
+}
+
+static int soc_bin(double level) {
+  int b = (int)(clamp(level, 0, 100) / 10.0);
+  return b < AGE_SOC_BINS ? b : AGE_SOC_BINS - 1;
+}
+
+static int temp_bin(double temp_c) {
+  if (temp_c < 15.0)
+    return 0;
+  int b = 1 + (int)((temp_c - 15.0) / 5.0);
+  return b < AGE_TEMP_BINS ? b : AGE_TEMP_BINS - 1;
+}
+
+// Wear of one firmware cycle count (100% of throughput) in typical use
+static double ref_cycle_wear(void) {
+  return 100.0 / AGE_REF_DEPTH_PCT *
+         age_cycle_wear(AGE_REF_DEPTH_PCT, 50.0, 25.0);
+}
+
+static void calendar(age_model_t *m, double level, double temp_c,
+                     int64_t dt_ms) {
+  double days = (double)dt_ms / DAY_MS;
+  double k = calendar_rate(level, temp_c);
+  double teq = m->calendar_pct / k;
+  double loss = k * sqrt(teq * teq + days) - m->calendar_pct;
+  m->calendar_pct += loss;
+  m->calendar_bin_pct[soc_bin(level)][temp_bin(temp_c)] += loss;
+  m->hours[soc_bin(level)][temp_bin(temp_c)] += days * 24.0;
+  m->k_days += k * days;
+  m->days += days;
+}
+
+static int32_t local_day(const age_model_t *m, int64_t t_ms) {
+  return (int32_t)((t_ms / 1000 + m->utc_offset_s) / 86400);
+}
+
+static void track_cycles(age_model_t *m, int64_t t_ms, double level,
+                         double temp_c) {
+  rfc_cycle_t cycles[RFC_STACK];
+  int n = rfc_push(&m->rainflow, level, temp_c, cycles, RFC_STACK);
+  for (int i = 0; i < n; i++) {
+    const rfc_cycle_t *c = &cycles[i];
+    double wear =
+        c->count * age_cycle_wear(c->depth_pct, c->mean_pct, c->temp_c);
+    m->cycle_pct += wear;
+    m->half_cycles += 2.0 * c->count;
+    rfc_history_add(&m->depths, local_day(m, t_ms), c, wear);
+  }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void age_init(age_model_t *m) {
+  if (m == NULL)
+    return;
+  memset(m, 0, sizeof(*m));
+  m->version = AGE_MODEL_VERSION;
+  rfc_init(&m->rainflow, AGE_HYSTERESIS_PCT);
+}
+
+void age_seed(age_model_t *m, double measured_loss_pct, int32_t cycle_count) {
+  if (m == NULL || m->seeded)
+    return;
+  m->seeded = 1;
+  double loss = clamp(measured_loss_pct, 0, 50);
+  double cyc = cycle_count > 0 ? cycle_count * ref_cycle_wear() : 0;
+  if (cyc > loss)
+    cyc = loss;
+  m->seed_cycle_pct = cyc;
+  m->seed_calendar_pct = loss - cyc;
+  m->cycle_pct += cyc;
+  m->calendar_pct += loss - cyc;
+}
+
+void age_sample(age_model_t *m, const pdev_sample_t *s) {
+  if (m == NULL || s == NULL || !s->valid)
+    return;
+  double level = clamp(s->level, 0, 100);
+  double temp_c = m->have_last ? m->last_temp_c : REST_C;
+  if (s->temp_cc)
+    temp_c = s->temp_cc / 100.0;
+  if (m->have_last) {
+    int64_t dt = s->t_ms - m->last_ms;
+    if (dt <= 0)
+      return;
+    // Across a long gap the machine was most likely asleep or off: the
+    // level held, and it cooled down
+    double gap_temp = m->last_temp_c;
+    if (dt > AGE_MAX_GAP_MS && gap_temp > REST_C)
+      gap_temp = REST_C;
+    calendar(m, m->last_level, gap_temp, dt);
+  }
+  track_cycles(m, s->t_ms, level, temp_c);
+  m->last_ms = s->t_ms;
+  m->last_level = level;
+  m->last_temp_c = temp_c;
+  m->have_last = 1;
+}
+
+void age_estimate(const age_model_t *m, age_estimate_t *out) {
+  memset(out, 0, sizeof(*out));
+  out->days_to_eol = -1;
+  if (m == NULL)
+    return;
+  rfc_cycle_t open[RFC_STACK + 1];
+  int n = rfc_residue(&m->rainflow, open, RFC_STACK + 1);
+  double open_pct = 0;
+  for (int i = 0; i < n; i++)
+    open_pct += open[i].count * age_cycle_wear(open[i].depth_pct,
+                                               open[i].mean_pct,
+                                               open[i].temp_c);
+  out->calendar_pct = m->calendar_pct;
+  out->cycle_pct = m->cycle_pct + open_pct;
+  out->total_pct = out->calendar_pct + out->cycle_pct;
+  out->budget_used = out->total_pct / AGE_EOL_PCT;
+  out->observed_days = m->days;
+  out->half_cycles = m->half_cycles + n;
+
+  // Typical use: calendar at the reference rate plus AGE_REF_CYCLES_YEAR
+  double per_year = AGE_REF_CYCLES_YEAR * ref_cycle_wear();
+  double lo = 0, hi = 100;
+  for (int i = 0; i < 50; i++) {
+    double y = (lo + hi) / 2.0;
+    double ref = AGE_CAL_K_REF * sqrt(365.0 * y) + per_year * y;
+    if (ref < out->total_pct)
+      lo = y;
+    else
+      hi = y;
+  }
+  out->equivalent_years = lo;
+
+  double observed = m->calendar_pct - m->seed_calendar_pct;
+  for (int b = 0; b < AGE_SOC_BINS; b++) {
+    for (int t = 0; t < AGE_TEMP_BINS; t++) {
+      double v = m->calendar_bin_pct[b][t];
+      if (v > m->calendar_bin_pct[out->worst_soc_bin][out->worst_temp_bin]) {
+        out->worst_soc_bin = b;
+        out->worst_temp_bin = t;
+      }
+    }
+  }
+  if (observed > 0)
+    out->worst_share =
+        m->calendar_bin_pct[out->worst_soc_bin][out->worst_temp_bin] /
+        observed;
+
+  // Projection at the mean calendar rate and cycle wear per day so far
+  if (m->days < 1.0)
+    return;
+  if (out->total_pct >= AGE_EOL_PCT) {
+    out->days_to_eol = 0;
+    return;
+  }
+  double k = m->k_days / m->days;
+  double per_day = (m->cycle_pct - m->seed_cycle_pct) / m->days;
+  double teq = m->calendar_pct / k;
+  teq *= teq;
+  lo = 0;
+  hi = 50 * 365.0;
+  if (k * sqrt(teq + hi) + out->cycle_pct + per_day * hi < AGE_EOL_PCT)
+    return; // beyond 50 years: unknown
+  for (int i = 0; i < 60; i++) {
+    double d = (lo + hi) / 2.0;
+    if (k * sqrt(teq + d) + out->cycle_pct + per_day * d < AGE_EOL_PCT)
+      lo = d;
+    else
+      hi = d;
+  }
+  out->days_to_eol = hi;
+}
+
+double age_cycle_wear(double depth_pct, double mean_pct, double temp_c) {
+  if (depth_pct <= 0)
+    return 0;
+  double d = clamp(depth_pct, 0, 100) / 100.0;
+  double mean = 1.0 + 0.5 * clamp(mean_pct - 50.0, 0, 50) / 50.0;
+  double heat = temp_c > 25.0 ? arrhenius(AGE_CYC_EA, temp_c) : 1.0;
+  return AGE_EOL_PCT / AGE_CYCLES_FULL * pow(d, AGE_DOD_EXP) * mean * heat;
+}
+
+int age_depths(const age_model_t *m, int64_t now_ms, int days,
+               double cycles[RFC_BINS], double wear_pct[RFC_BINS]) {
+  if (m == NULL || days <= 0)
+    return rfc_history_sum(NULL, 0, 0, cycles, wear_pct);
+  int32_t today = local_day(m, now_ms);
+  return rfc_history_sum(&m->depths, today - days + 1, today, cycles,
+                         wear_pct);
+}
+
+int age_soc_bin_low(int bin) { return bin * 10; }
+
+int age_temp_bin_low(int bin) { return bin <= 0 ? -100 : 15 + 5 * (bin - 1); }
@@ -0,0 +1,109 @@
+//
+//  aging_model.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef aging_model_h
+#define aging_model_h
+
+#include "power_device.h"
+#include "rainflow.h"
+#include <stdint.h>
+
+// Capacity lost to aging, estimated from what the battery goes through
+// rather than read back from the firmware, so it moves with habits (time
+// spent full, heat, deep cycles) long before the reported health does.
+//
+// Calendar aging follows the square root of time at a rate set by state of
+// charge and temperature (Arrhenius). As the rate changes from sample to
+// sample, the loss so far is carried as the time it would have taken at the
+// current rate, t_eq = (loss / k)^2, which the sample then advances.
+// Cycle aging rainflow-counts the charge level (rainflow.h) and charges each
+// cycle on a Woehler curve: a full cycle costs 1 / AGE_CYCLES_FULL of the
+// end-of-life loss, a cycle of depth d costs (d / 100)^AGE_DOD_EXP of that,
+// more at a high mean level or hot. Cycles still open count as half cycles
+// in the estimate.
+//
+// Each sample is O(1) amortized and the state is one flat struct that is
+// persisted as is; it starts with AGE_MODEL_VERSION, which changes with the
+// layout, so a saved model is not misread even when the size matches. Hours
+// and calendar loss are also kept per charge level x temperature bin, and
+// cycles and their wear per depth bin and local day, for reports.
+
+#define AGE_SOC_BINS 10   // 10% each
+#define AGE_TEMP_BINS 8   // below 15 C, 5 C each, 45 C and up
+#define AGE_EOL_PCT 20.0  // capacity loss at end of life (80% health)
+#define AGE_CAL_K_REF 0.105 // % per sqrt(day) at 25 C and 50%: 2% a year
+#define AGE_CAL_EA 50000.0  // J/mol; about twice as fast per 10 C
+#define AGE_CYCLES_FULL 1000.0
+#define AGE_DOD_EXP 1.5
+#define AGE_CYC_EA 30000.0  // J/mol, above 25 C only
+#define AGE_HYSTERESIS_PCT 2.0 // smaller wiggles are not reversals
+#define AGE_MAX_GAP_MS (6 * 3600000LL) // longer gaps age at rest, <= 25 C
+#define AGE_REF_CYCLES_YEAR 300.0 // typical use, for equivalent age
+#define AGE_REF_DEPTH_PCT 60.0
+#define AGE_MODEL_VERSION 2 // 1 was the reversal-counting layout, unversioned
+
+typedef struct {
+  int32_t version; // AGE_MODEL_VERSION
+  double hours[AGE_SOC_BINS][AGE_TEMP_BINS];
+  double calendar_bin_pct[AGE_SOC_BINS][AGE_TEMP_BINS];
+  double calendar_pct; // including the seed
+  double cycle_pct;
+  double seed_calendar_pct;
+  double seed_cycle_pct;
+  double half_cycles;
+  double k_days; // sum of calendar rate x days, for the mean rate
+  double days;   // observed
+  int32_t seeded;
+  // Sample stream
+  int64_t last_ms;
+  double last_level;
+  double last_temp_c;
+  int32_t have_last;
+  int32_t utc_offset_s; // for the local day of the depth history
+  rfc_counter_t rainflow;
+  rfc_history_t depths;
+} age_model_t;
+
+typedef struct {
+  double calendar_pct;
+  double cycle_pct;
+  double total_pct;
+  double budget_used;      // total_pct / AGE_EOL_PCT
+  double equivalent_years; // of typical use with the same loss
+  double days_to_eol;      // at the stress seen so far; < 0 unknown
+  double observed_days;
+  double half_cycles;
+  int worst_soc_bin; // the bin with the most calendar loss
+  int worst_temp_bin;
+  double worst_share; // its share of the observed calendar loss
+} age_estimate_t;
+
+void age_init(age_model_t *m);
+
+// Wear from before the model was started, split from the measured capacity
+// loss and the firmware cycle count. Only the first call counts.
+void age_seed(age_model_t *m, double measured_loss_pct, int32_t cycle_count);
+
+// One battery sample: level, temperature and time
+void age_sample(age_model_t *m, const pdev_sample_t *s);
+
+void age_estimate(const age_model_t *m, age_estimate_t *out);
+
+// Capacity loss in percent from one full cycle of depth_pct around
+// mean_pct at temp_c; half that for a half cycle
+double age_cycle_wear(double depth_pct, double mean_pct, double temp_c);
+
+// Cycles and wear per depth bin over the last `days` local days up to
+// now_ms; returns the days with cycles
+int age_depths(const age_model_t *m, int64_t now_ms, int days,
+               double cycles[RFC_BINS], double wear_pct[RFC_BINS]);
+
+// Bin lower edges, for labels
+int age_soc_bin_low(int bin);
+int age_temp_bin_low(int bin); // -100 for the open-ended bottom bin
+
+#endif
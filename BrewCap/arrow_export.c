@@ -0,0 +1,588 @@
+//
+//  arrow_export.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "arrow_export.h"
+#include "store_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// File layout (Arrow columnar format, IPC file variant):
+//   "ARROW1\0\0"
+//   Schema message, then one RecordBatch message per batch, then end-of-stream
+//   Footer flatbuffer (schema again plus the location of every batch)
+//   int32 footer length, "ARROW1"
+// A message is 0xFFFFFFFF, int32 metadata length, a flatbuffer Message
+// padded to 8 bytes, then the body buffers.
+
+#define ARW_ALIGN 64
+#define ARW_METADATA_V5 4
+
+// Type union ids from Schema.fbs
+enum { FB_TYPE_INT = 2, FB_TYPE_FLOAT = 3, FB_TYPE_BOOL = 6, FB_TYPE_TS = 10 };
+// MessageHeader union ids from Message.fbs
+enum { FB_MSG_SCHEMA = 1, FB_MSG_RECORD_BATCH = 3 };
+
+typedef struct {
+  int64_t offset; // of the message's continuation marker
+  int32_t metadata_len;
+  int32_t pad;
+  int64_t body_len;
+} block_t;
+
+_Static_assert(sizeof(block_t) == 24, "block_t must match the Block struct");
+
+struct arw_writer {
+  int fd;
+  int err;
+  int64_t offset;
+  size_t ncols;
+  arw_column_t cols[ARW_MAX_COLUMNS];
+  char names[ARW_MAX_COLUMNS][64];
+  block_t *blocks;
+  size_t nblocks;
+  size_t blocks_cap;
+  char path[1024];
+  char tmp[1040];
+};
+
+static const uint8_t k_zeros[ARW_ALIGN];
+
+// ============================================================
+// Flatbuffers
+// ============================================================
+
+// Just enough of a flatbuffer builder for Arrow's metadata. It builds front
+// to back: a parent is laid out first and its offset fields are patched once
+// each child has been placed after it, which keeps every uoffset positive.
+
+typedef struct {
+  uint8_t *p;
+  size_t len;
+  size_t cap;
+  int err;
+} fb_t;
+
+#define FB_MAX_FIELDS 8
+
+typedef struct {
+  size_t pos;
+  uint16_t off[FB_MAX_FIELDS]; // field offsets within the table, 0 = absent
+} fb_table_t;
+
+static size_t fb_alloc(fb_t *b, size_t n, size_t align) {
+  size_t pos = (b->len + align - 1) & ~(align - 1);
+  if (pos + n > b->cap) {
+    size_t cap = b->cap ? b->cap * 2 : 1024;
+    while (cap < pos + n)
+      cap *= 2;
+    uint8_t *p = realloc(b->p, cap);
+    if (p == NULL) {
+      b->err = 1;
+      return SIZE_MAX;
+    }
+    b->p = p;
+    b->cap = cap;
+  }
+  memset(b->p + b->len, 0, pos + n - b->len);
+  b->len = pos + n;
+  return pos;
+}
+
+static void fb_put(fb_t *b, size_t pos, const void *v, size_t n) {
+  if (!b->err && pos <= b->len && n <= b->len - pos)
+    memcpy(b->p + pos, v, n);
+}
+
+static void fb_ref(fb_t *b, size_t at, size_t target) {
+  uint32_t rel = (uint32_t)(target - at);
+  fb_put(b, at, &rel, 4);
+}
+
+// sizes[i] is the inline size of field i (offsets are 4), 0 if absent.
+// The vtable goes first, then the table with each field naturally aligned.
+static fb_table_t fb_table(fb_t *b, const uint8_t *sizes, int n) {
+  fb_table_t t;
+  memset(&t, 0, sizeof(t));
+  size_t vt = fb_alloc(b, 4 + 2 * (size_t)n, 2);
+  t.pos = fb_alloc(b, 4, 4);
+  for (int i = 0; i < n; i++)
+    if (sizes[i])
+      t.off[i] = (uint16_t)(fb_alloc(b, sizes[i], sizes[i]) - t.pos);
+  uint16_t hdr[2] = {(uint16_t)(4 + 2 * n), (uint16_t)(b->len - t.pos)};
+  fb_put(b, vt, hdr, sizeof(hdr));
+  fb_put(b, vt + 4, t.off, 2 * (size_t)n);
+  int32_t vtable = (int32_t)(t.pos - vt);
+  fb_put(b, t.pos, &vtable, 4);
+  return t;
+}
+
+static void fb_field(fb_t *b, const fb_table_t *t, int i, const void *v,
+                     size_t n) {
+  fb_put(b, t->pos + t->off[i], v, n);
+}
+
+static void fb_field_ref(fb_t *b, const fb_table_t *t, int i, size_t target) {
+  fb_ref(b, t->pos + t->off[i], target);
+}
+
+// Returns the position of the length word; elements follow it
+static size_t fb_vector(fb_t *b, size_t count, size_t elem, size_t align) {
+  if (align < 4)
+    align = 4;
+  size_t first = (b->len + 4 + align - 1) & ~(align - 1);
+  if (fb_alloc(b, first + count * elem - b->len, 1) == SIZE_MAX)
+    return SIZE_MAX;
+  uint32_t n = (uint32_t)count;
+  fb_put(b, first - 4, &n, 4);
+  return first - 4;
+}
+
+static size_t fb_string(fb_t *b, const char *s) {
+  size_t n = strlen(s);
+  size_t v = fb_vector(b, n + 1, 1, 4); // the NUL is counted, then dropped
+  uint32_t len = (uint32_t)n;
+  fb_put(b, v, &len, 4);
+  fb_put(b, v + 4, s, n);
+  return v;
+}
+
+// Root offset, to be patched with the root table
+static void fb_begin(fb_t *b) {
+  b->len = 0;
+  b->err = 0;
+  fb_alloc(b, 4, 4);
+}
+
+// ============================================================
+// Arrow metadata
+// ============================================================
+
+static size_t build_type(fb_t *b, arw_type_t type, uint8_t *id) {
+  static const uint8_t int_sizes[] = {4, 1};  // bitWidth, is_signed
+  static const uint8_t float_sizes[] = {2};   // precision
+  static const uint8_t ts_sizes[] = {2, 4};   // unit, timezone
+  fb_table_t t;
+  int32_t bits = 0;
+  uint8_t is_signed = 1;
+  int16_t v;
+  switch (type) {
+  case ARW_TIMESTAMP_MS:
+    *id = FB_TYPE_TS;
+    t = fb_table(b, ts_sizes, 2);
+    v = 1; // MILLISECOND
+    fb_field(b, &t, 0, &v, 2);
+    fb_field_ref(b, &t, 1, fb_string(b, "UTC"));
+    return t.pos;
+  case ARW_FLOAT32:
+  case ARW_FLOAT64:
+    *id = FB_TYPE_FLOAT;
+    t = fb_table(b, float_sizes, 1);
+    v = type == ARW_FLOAT32 ? 1 : 2; // SINGLE, DOUBLE
+    fb_field(b, &t, 0, &v, 2);
+    return t.pos;
+  case ARW_BOOL:
+    *id = FB_TYPE_BOOL;
+    return fb_table(b, NULL, 0).pos;
+  case ARW_INT8:
+    bits = 8;
+    break;
+  case ARW_INT16:
+    bits = 16;
+    break;
+  case ARW_INT32:
+    bits = 32;
+    break;
+  case ARW_INT64:
+    bits = 64;
+    break;
+  }
+  *id = FB_TYPE_INT;
+  t = fb_table(b, int_sizes, 2);
+  fb_field(b, &t, 0, &bits, 4);
+  fb_field(b, &t, 1, &is_signed, 1);
+  return t.pos;
+}
+
+static size_t build_schema(fb_t *b, const arw_writer_t *w) {
+  static const uint8_t schema_sizes[] = {2, 4}; // endianness, fields
+  // name, nullable, type_type, type, dictionary, children
+  static const uint8_t field_sizes[] = {4, 1, 1, 4, 0, 4};
+  fb_table_t s = fb_table(b, schema_sizes, 2);
+  int16_t little = 0;
+  fb_field(b, &s, 0, &little, 2);
+  size_t fields = fb_vector(b, w->ncols, 4, 4);
+  fb_field_ref(b, &s, 1, fields);
+  for (size_t i = 0; i < w->ncols; i++) {
+    fb_table_t f = fb_table(b, field_sizes, 6);
+    fb_ref(b, fields + 4 + 4 * i, f.pos);
+    fb_field_ref(b, &f, 0, fb_string(b, w->cols[i].name));
+    uint8_t nullable = 0, id = 0;
+    fb_field(b, &f, 1, &nullable, 1);
+    size_t type = build_type(b, w->cols[i].type, &id);
+    fb_field(b, &f, 2, &id, 1);
+    fb_field_ref(b, &f, 3, type);
+    fb_field_ref(b, &f, 5, fb_vector(b, 0, 4, 4));
+  }
+  return s.pos;
+}
+
+// Message table wrapping a header; the header table is laid out next
+static fb_table_t begin_message(fb_t *b, uint8_t header_type,
+                                int64_t body_len) {
+  static const uint8_t msg_sizes[] = {2, 1, 4, 8};
+  fb_begin(b);
+  fb_table_t m = fb_table(b, msg_sizes, 4);
+  fb_ref(b, 0, m.pos);
+  int16_t version = ARW_METADATA_V5;
+  fb_field(b, &m, 0, &version, 2);
+  fb_field(b, &m, 1, &header_type, 1);
+  fb_field(b, &m, 3, &body_len, 8);
+  return m;
+}
+
+// ============================================================
+// File output
+// ============================================================
+
+static void put(arw_writer_t *w, const void *data, size_t len) {
+  if (w->err || len == 0)
+    return;
+  if (store_write_all(w->fd, data, len) != 0) {
+    fprintf(stderr, "arw: write failed: %s\n", strerror(errno));
+    w->err = 1;
+    return;
+  }
+  w->offset += (int64_t)len;
+}
+
+static size_t padded(size_t n) {
+  return (n + ARW_ALIGN - 1) & ~(size_t)(ARW_ALIGN - 1);
+}
+
+// Writes the encapsulated metadata, padded so the body that follows starts
+// on a 64-byte boundary. Returns the metadata length for the Block entry.
+static int32_t put_metadata(arw_writer_t *w, const fb_t *b) {
+  if (b->err) {
+    w->err = 1;
+    return 0;
+  }
+  size_t end = (size_t)w->offset + 8 + b->len;
+  size_t pad = padded(end) - end;
+  uint32_t prefix[2] = {0xFFFFFFFFu, (uint32_t)(b->len + pad)};
+  put(w, prefix, sizeof(prefix));
+  put(w, b->p, b->len);
+  put(w, k_zeros, pad);
+  return (int32_t)(8 + b->len + pad);
+}
+
+static size_t column_bytes(arw_type_t type, size_t nrows) {
+  switch (type) {
+  case ARW_INT8:
+    return nrows;
+  case ARW_INT16:
+    return nrows * 2;
+  case ARW_INT32:
+  case ARW_FLOAT32:
+    return nrows * 4;
+  case ARW_BOOL:
+    return (nrows + 7) / 8;
+  default:
+    return nrows * 8;
+  }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+arw_writer_t *arw_create(const char *path, const arw_column_t *columns,
+                         size_t ncolumns) {
+  if (ncolumns == 0 || ncolumns > ARW_MAX_COLUMNS)
+    return NULL;
+  arw_writer_t *w = calloc(1, sizeof(arw_writer_t));
+  if (w == NULL)
+    return NULL;
+  w->ncols = ncolumns;
+  for (size_t i = 0; i < ncolumns; i++) {
+    snprintf(w->names[i], sizeof(w->names[i]), "%s", columns[i].name);
+    w->cols[i].name = w->names[i];
+    w->cols[i].type = columns[i].type;
+  }
+  snprintf(w->path, sizeof(w->path), "%s", path);
+  snprintf(w->tmp, sizeof(w->tmp), "%s.tmp", path);
+  w->fd = open(w->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (w->fd < 0) {
+    fprintf(stderr, "arw: cannot create %s: %s\n", w->tmp, strerror(errno));
+    free(w);
+    return NULL;
+  }
+
+  put(w, "ARROW1\0\0", 8);
+  fb_t b = {0};
+  fb_table_t m = begin_message(&b, FB_MSG_SCHEMA, 0);
+  fb_field_ref(&b, &m, 2, build_schema(&b, w));
+  put_metadata(w, &b);
+  free(b.p);
+  if (w->err) {
+    arw_abort(w);
+    return NULL;
+  }
+  return w;
+}
+
+int arw_write_batch(arw_writer_t *w, size_t nrows,
+                    const void *const *columns) {
+  if (w == NULL || columns == NULL || w->err)
+    return -1;
+  if (nrows == 0)
+    return 0;
+  if (w->nblocks == w->blocks_cap) {
+    size_t cap = w->blocks_cap ? w->blocks_cap * 2 : 16;
+    block_t *blocks = realloc(w->blocks, cap * sizeof(block_t));
+    if (blocks == NULL) {
+      w->err = 1;
+      return -1;
+    }
+    w->blocks = blocks;
+    w->blocks_cap = cap;
+  }
+
+  // Every column has an empty validity buffer (no nulls) and a data buffer
+  static const uint8_t batch_sizes[] = {8, 4, 4}; // length, nodes, buffers
+  fb_t b = {0};
+  int64_t body = 0;
+  for (size_t i = 0; i < w->ncols; i++)
+    body += (int64_t)padded(column_bytes(w->cols[i].type, nrows));
+  fb_table_t m = begin_message(&b, FB_MSG_RECORD_BATCH, body);
+  fb_table_t rb = fb_table(&b, batch_sizes, 3);
+  fb_field_ref(&b, &m, 2, rb.pos);
+  int64_t length = (int64_t)nrows;
+  fb_field(&b, &rb, 0, &length, 8);
+  size_t nodes = fb_vector(&b, w->ncols, 16, 8);
+  fb_field_ref(&b, &rb, 1, nodes);
+  for (size_t i = 0; i < w->ncols; i++) {
+    int64_t node[2] = {length, 0}; // length, null_count
+    fb_put(&b, nodes + 4 + 16 * i, node, sizeof(node));
+  }
+  size_t buffers = fb_vector(&b, 2 * w->ncols, 16, 8);
+  fb_field_ref(&b, &rb, 2, buffers);
+  int64_t at = 0;
+  for (size_t i = 0; i < w->ncols; i++) {
+    int64_t len = (int64_t)column_bytes(w->cols[i].type, nrows);
+    int64_t bufs[4] = {at, 0, at, len}; // validity, data
+    fb_put(&b, buffers + 4 + 32 * i, bufs, sizeof(bufs));
+    at += (int64_t)padded((size_t)len);
+  }
+
+  block_t *blk = &w->blocks[w->nblocks];
+  memset(blk, 0, sizeof(*blk));
+  blk->offset = w->offset;
+  blk->metadata_len = put_metadata(w, &b);
+  blk->body_len = body;
+  free(b.p);
+
+  for (size_t i = 0; i < w->ncols && !w->err; i++) {
+    size_t len = column_bytes(w->cols[i].type, nrows);
+    if (w->cols[i].type == ARW_BOOL) {
+      uint8_t *bits = calloc(1, len);
+      if (bits == NULL) {
+        w->err = 1;
+        break;
+      }
+      const uint8_t *v = columns[i];
+      for (size_t r = 0; r < nrows; r++)
+        if (v[r])
+          bits[r >> 3] |= (uint8_t)(1u << (r & 7));
+      put(w, bits, len);
+      free(bits);
+    } else {
+      put(w, columns[i], len);
+    }
+    put(w, k_zeros, padded(len) - len);
+  }
+  if (w->err)
+    return -1;
+  w->nblocks++;
+  return 0;
+}
+
+int arw_finish(arw_writer_t *w) {
+  if (w == NULL)
+    return -1;
+  uint32_t eos[2] = {0xFFFFFFFFu, 0};
+  put(w, eos, sizeof(eos));
+
+  // version, schema, dictionaries, recordBatches
+  static const uint8_t footer_sizes[] = {2, 4, 0, 4};
+  fb_t b = {0};
+  fb_begin(&b);
+  fb_table_t f = fb_table(&b, footer_sizes, 4);
+  fb_ref(&b, 0, f.pos);
+  int16_t version = ARW_METADATA_V5;
+  fb_field(&b, &f, 0, &version, 2);
+  fb_field_ref(&b, &f, 1, build_schema(&b, w));
+  size_t blocks = fb_vector(&b, w->nblocks, sizeof(block_t), 8);
+  fb_field_ref(&b, &f, 3, blocks);
+  fb_put(&b, blocks + 4, w->blocks, w->nblocks * sizeof(block_t));
+  if (b.err)
+    w->err = 1;
+  put(w, b.p, b.len);
+  int32_t footer_len = (int32_t)b.len;
+  put(w, &footer_len, 4);
+  put(w, "ARROW1", 6);
+  free(b.p);
+
+  if (!w->err && fsync(w->fd) != 0)
+    w->err = 1;
+  close(w->fd);
+  int rc = 0;
+  if (w->err || rename(w->tmp, w->path) != 0) {
+    fprintf(stderr, "arw: cannot finish %s\n", w->path);
+    unlink(w->tmp);
+    rc = -1;
+  }
+  free(w->blocks);
+  free(w);
+  return rc;
+}
+
+void arw_abort(arw_writer_t *w) {
+  if (w == NULL)
+    return;
+  close(w->fd);
+  unlink(w->tmp);
+  free(w->blocks);
+  free(w);
+}
+
+// ============================================================
+// Exports
+// ============================================================
+
+int64_t arw_export_sessions(slog_t *log, const char *path) {
+  static const arw_column_t cols[] = {
+      {"start", ARW_TIMESTAMP_MS},  {"end", ARW_TIMESTAMP_MS},
+      {"start_level", ARW_INT16},   {"end_level", ARW_INT16},
+      {"duration_min", ARW_INT32},  {"adapter_watts", ARW_INT32},
+  };
+  struct {
+    int64_t start[ARW_BATCH_ROWS];
+    int64_t end[ARW_BATCH_ROWS];
+    int16_t start_level[ARW_BATCH_ROWS];
+    int16_t end_level[ARW_BATCH_ROWS];
+    int32_t duration[ARW_BATCH_ROWS];
+    int32_t watts[ARW_BATCH_ROWS];
+  } *batch = malloc(sizeof(*batch));
+  arw_writer_t *w = batch ? arw_create(path, cols, 6) : NULL;
+  if (w == NULL) {
+    free(batch);
+    return -1;
+  }
+  const void *const ptrs[] = {batch->start,       batch->end,
+                              batch->start_level, batch->end_level,
+                              batch->duration,    batch->watts};
+  int64_t rows = 0;
+  size_t n = 0, count = slog_count(log);
+  int rc = 0;
+  for (size_t i = 0; i < count && rc == 0; i++) {
+    slog_record_t r;
+    if (slog_read(log, i, &r) != 0)
+      continue;
+    batch->start[n] = r.start_ms;
+    batch->end[n] = r.end_ms;
+    batch->start_level[n] = r.start_level;
+    batch->end_level[n] = r.end_level;
+    batch->duration[n] = r.duration_min;
+    batch->watts[n] = r.adapter_watts;
+    rows++;
+    if (++n == ARW_BATCH_ROWS) {
+      rc = arw_write_batch(w, n, ptrs);
+      n = 0;
+    }
+  }
+  if (rc == 0)
+    rc = arw_write_batch(w, n, ptrs);
+  free(batch);
+  if (rc != 0) {
+    arw_abort(w);
+    return -1;
+  }
+  return arw_finish(w) == 0 ? rows : -1;
+}
+
+typedef struct {
+  int64_t t[ARW_BATCH_ROWS];
+  int32_t amperage[ARW_BATCH_ROWS];
+  int32_t voltage[ARW_BATCH_ROWS];
+  float temp[ARW_BATCH_ROWS];
+  float watts[ARW_BATCH_ROWS];
+  int8_t level[ARW_BATCH_ROWS];
+  uint8_t plugged[ARW_BATCH_ROWS];
+  uint8_t charging[ARW_BATCH_ROWS];
+  size_t n;
+  arw_writer_t *w;
+} telemetry_batch_t;
+
+static int telemetry_flush(telemetry_batch_t *b) {
+  const void *const ptrs[] = {b->t,     b->level, b->amperage, b->voltage,
+                              b->temp,  b->watts, b->plugged,  b->charging};
+  int rc = arw_write_batch(b->w, b->n, ptrs);
+  b->n = 0;
+  return rc;
+}
+
+static int telemetry_rows(const pdev_sample_t *s, size_t n, void *ctx) {
+  telemetry_batch_t *b = ctx;
+  for (size_t i = 0; i < n; i++) {
+    size_t r = b->n;
+    b->t[r] = s[i].t_ms;
+    b->level[r] = (int8_t)s[i].level;
+    b->amperage[r] = s[i].amperage_ma;
+    b->voltage[r] = s[i].voltage_mv;
+    b->temp[r] = (float)s[i].temp_cc / 100.0f;
+    b->watts[r] = s[i].power_w;
+    b->plugged[r] = s[i].plugged;
+    b->charging[r] = s[i].charging;
+    if (++b->n == ARW_BATCH_ROWS && telemetry_flush(b) != 0)
+      return 1;
+  }
+  return 0;
+}
+
+int64_t arw_export_telemetry(ts_store_t *store, int64_t from_ms, int64_t to_ms,
+                             const char *path) {
+  static const arw_column_t cols[] = {
+      {"time", ARW_TIMESTAMP_MS}, {"level", ARW_INT8},
+      {"amperage_ma", ARW_INT32}, {"voltage_mv", ARW_INT32},
+      {"temp_c", ARW_FLOAT32},    {"power_w", ARW_FLOAT32},
+      {"plugged", ARW_BOOL},      {"charging", ARW_BOOL},
+  };
+  telemetry_batch_t *b = malloc(sizeof(telemetry_batch_t));
+  if (b == NULL)
+    return -1;
+  b->n = 0;
+  b->w = arw_create(path, cols, 8);
+  if (b->w == NULL) {
+    free(b);
+    return -1;
+  }
+  int64_t rows = ts_scan(store, from_ms, to_ms, TS_ALL_COLUMNS,
+                         telemetry_rows, b);
+  arw_writer_t *w = b->w;
+  if (rows >= 0 && (w->err || telemetry_flush(b) != 0))
+    rows = -1;
+  free(b);
+  if (rows < 0) {
+    arw_abort(w);
+    return -1;
+  }
+  return arw_finish(w) == 0 ? rows : -1;
+}
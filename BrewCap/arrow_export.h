@@ -0,0 +1,62 @@
+//
+//  arrow_export.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef arrow_export_h
+#define arrow_export_h
+
+#include "session_log.h"
+#include "telemetry_store.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Arrow IPC file (Feather v2) export. Columns are typed and uncompressed,
+// with every buffer 64-byte aligned, so pyarrow / pandas can map the file
+// without parsing or copying. Rows are written in record batches built
+// straight from the binary stores; memory stays at one batch.
+//
+// Nothing in the build reads the files back. To check an export by hand,
+// `pip install pyarrow` in a scratch environment and compare
+// pyarrow.feather.read_table(path) with the columns and rows written.
+
+typedef enum {
+  ARW_TIMESTAMP_MS = 0, // int64 ms since 1970, UTC
+  ARW_INT8,
+  ARW_INT16,
+  ARW_INT32,
+  ARW_INT64,
+  ARW_FLOAT32,
+  ARW_FLOAT64,
+  ARW_BOOL, // one uint8_t per row on input, bit-packed on disk
+} arw_type_t;
+
+typedef struct {
+  const char *name;
+  arw_type_t type;
+} arw_column_t;
+
+#define ARW_MAX_COLUMNS 16
+#define ARW_BATCH_ROWS 65536 // rows per record batch in the exports below
+
+typedef struct arw_writer arw_writer_t;
+
+// Writes to path.tmp; arw_finish renames it over path
+arw_writer_t *arw_create(const char *path, const arw_column_t *columns,
+                         size_t ncolumns);
+
+// One record batch. columns[i] points at nrows values of column i's type.
+int arw_write_batch(arw_writer_t *w, size_t nrows, const void *const *columns);
+
+// Writes the footer and renames into place; frees the writer either way
+int arw_finish(arw_writer_t *w);
+void arw_abort(arw_writer_t *w);
+
+// Whole-file exports; return the number of rows written or -1
+int64_t arw_export_sessions(slog_t *log, const char *path);
+int64_t arw_export_telemetry(ts_store_t *store, int64_t from_ms, int64_t to_ms,
+                             const char *path);
+
+#endif
@@ -0,0 +1,668 @@
+//
+//  battery_sim.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "battery_sim.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BSIM_TYPE(a, b, c, d)                                                  \
+  ((uint32_t)(a) << 24 | (uint32_t)(b) << 16 | (uint32_t)(c) << 8 |          \
+   (uint32_t)(d))
+
+// Open-circuit voltage of one cell at 0, 10, ... 100% (graphite / high
+// voltage LCO); 100% sits on the charge voltage so the CV phase tapers out
+#define OCV_POINTS 11
+static const double k_ocv[OCV_POINTS] = {3.00, 3.55, 3.66, 3.72, 3.76, 3.81,
+                                         3.88, 3.96, 4.06, 4.18, 4.35};
+
+#define R_TEMP_COEF 0.02 // resistance rises 2% per degree below 25 C
+
+struct bsim {
+  pthread_mutex_t lock;
+  bsim_params_t p;
+  int64_t t_ms;
+
+  // Cell state
+  double soc;
+  double v1;     // RC pair voltage, positive while charging
+  double temp_c;
+  double amps;   // > 0 into the battery
+  double volts;  // terminal
+  double system_w;
+  double discharged_mah; // towards the next cycle
+  int32_t cycles;
+  int plugged;
+  int full; // charge terminated; waiting for BSIM_RESUME_PCT
+
+  // Controls written through SMC keys and battery properties
+  uint32_t chte;
+  uint8_t chie, ch0b, ch0c, ch0i, bclm;
+  int inhibit_prop;
+  int64_t charge_rate; // mA cap, -1 for none
+
+  // Load profile
+  int load_kind;
+  float base_w, peak_w, duty;
+  int64_t period_ms;
+  bsim_event_t *events;
+  size_t count;
+  size_t cursor;   // next event to apply
+  int64_t base_ms; // start of the current pass over the script
+  int64_t loop_ms;
+
+  // Wall clock
+  double speed;
+  int64_t wall_ms;
+  int have_wall;
+  double carry_ms;
+};
+
+static double ocv(const bsim_t *s, double soc) {
+  double x = (soc < 0 ? 0 : soc > 1 ? 1 : soc) * (OCV_POINTS - 1);
+  int i = (int)x;
+  if (i >= OCV_POINTS - 1)
+    return k_ocv[OCV_POINTS - 1] * s->p.cells;
+  return (k_ocv[i] + (k_ocv[i + 1] - k_ocv[i]) * (x - i)) * s->p.cells;
+}
+
+static double r0(const bsim_t *s) {
+  double k = 1.0 + R_TEMP_COEF * (25.0 - s->temp_c);
+  return s->p.r0_ohm * (k < 0.5 ? 0.5 : k);
+}
+
+static int adapter_on(const bsim_t *s) {
+  return s->plugged && !s->chie && !s->ch0i;
+}
+
+static int charge_allowed(const bsim_t *s) {
+  return adapter_on(s) && !s->full && !s->chte && !s->ch0b &&
+         !s->ch0c && !s->inhibit_prop && s->charge_rate != 0 &&
+         s->soc * 100.0 < s->bclm;
+}
+
+// Current that takes power_w (> 0 out, < 0 in) at the terminals:
+// P = -I (E + I R0), solved for I
+static double current_for(double e, double r, double power_w) {
+  double d = e * e - 4.0 * r * power_w;
+  if (d < 0)
+    d = 0; // more than the pack can give; it sags to half of E
+  return (-e + sqrt(d)) / (2.0 * r);
+}
+
+// One integration step of h seconds at a constant load
+static void step(bsim_t *s, double h) {
+  double r = r0(s);
+  double e = ocv(s, s->soc) + s->v1;
+  double amps = 0;
+
+  if (!adapter_on(s)) {
+    amps = current_for(e, r, s->system_w);
+  } else {
+    double spare_w = (s->p.adapter_w - s->system_w) * s->p.charger_eff;
+    if (spare_w < 0) {
+      amps = current_for(e, r, -spare_w / s->p.charger_eff);
+    } else if (charge_allowed(s)) {
+      double cc = s->p.charge_ma / 1000.0;
+      if (s->charge_rate > 0 && s->charge_rate / 1000.0 < cc)
+        cc = s->charge_rate / 1000.0;
+      double pw = current_for(e, r, -spare_w);
+      double cv = (s->p.cv_mv_cell * s->p.cells / 1000.0 - e) / r;
+      amps = cc < pw ? cc : pw;
+      if (cv < amps) {
+        amps = cv > 0 ? cv : 0;
+        if (amps * 1000.0 < s->p.term_ma) {
+          // The gauge calls the end of charge full, whatever it counted
+          s->full = 1;
+          s->soc = 1.0;
+          amps = 0;
+        }
+      }
+    }
+  }
+  if (amps < 0 && s->soc <= 0)
+    amps = 0; // shut down
+
+  double cap_ah = s->p.capacity_mah / 1000.0;
+  s->soc += amps * h / 3600.0 / cap_ah;
+  s->soc = s->soc < 0 ? 0 : s->soc > 1 ? 1 : s->soc;
+  if (amps < 0) {
+    s->discharged_mah += -amps * h / 3.6;
+    while (s->discharged_mah >= s->p.capacity_mah) {
+      s->discharged_mah -= s->p.capacity_mah;
+      s->cycles++;
+    }
+  }
+
+  double tau = s->p.r1_ohm * s->p.c1_f;
+  double a = tau > 0 ? exp(-h / tau) : 0;
+  s->v1 = s->v1 * a + amps * s->p.r1_ohm * (1.0 - a);
+
+  double heat_w = amps * amps * r + s->v1 * s->v1 / s->p.r1_ohm +
+                  s->p.system_heat * s->system_w;
+  double loss_w = (s->temp_c - s->p.ambient_c) / s->p.cool_k_per_w;
+  s->temp_c += h * (heat_w - loss_w) / s->p.heat_j_per_k;
+
+  s->amps = amps;
+  s->volts = ocv(s, s->soc) + s->v1 + amps * r;
+  if (s->full && (!s->plugged || s->soc * 100.0 < BSIM_RESUME_PCT))
+    s->full = 0;
+}
+
+// ============================================================
+// Load profile
+// ============================================================
+
+// Applies script events that are due and returns when the load next
+// changes, so no step crosses a change
+static int64_t load_update(bsim_t *s) {
+  switch (s->load_kind) {
+  case BSIM_LOAD_PERIODIC: {
+    int64_t pos = (s->t_ms - s->base_ms) % s->period_ms;
+    int64_t on_ms = (int64_t)(s->duty * (float)s->period_ms);
+    int on = pos < on_ms;
+    s->system_w = on ? s->peak_w : s->base_w;
+    return s->t_ms + (on ? on_ms - pos : s->period_ms - pos);
+  }
+  case BSIM_LOAD_SCRIPT:
+    for (;;) {
+      if (s->cursor >= s->count) {
+        if (s->loop_ms <= 0)
+          return INT64_MAX;
+        s->base_ms += s->loop_ms;
+        s->cursor = 0;
+      }
+      const bsim_event_t *e = &s->events[s->cursor];
+      if (s->base_ms + e->at_ms > s->t_ms)
+        return s->base_ms + e->at_ms;
+      s->system_w = e->system_w;
+      if (e->plugged >= 0)
+        s->plugged = e->plugged;
+      s->cursor++;
+    }
+  default:
+    s->system_w = s->base_w;
+    return INT64_MAX;
+  }
+}
+
+static void advance_locked(bsim_t *s, int64_t dt_ms) {
+  int64_t end = s->t_ms + dt_ms;
+  while (s->t_ms < end) {
+    int64_t next = load_update(s);
+    int64_t h = end - s->t_ms;
+    if (h > BSIM_STEP_MS)
+      h = BSIM_STEP_MS;
+    if (next - s->t_ms < h)
+      h = next - s->t_ms;
+    step(s, (double)h / 1000.0);
+    s->t_ms += h;
+  }
+  load_update(s);
+}
+
+// ============================================================
+// SMC keys
+// ============================================================
+
+enum {
+  KEY_CHTE, KEY_CHIE, KEY_CH0B, KEY_CH0C, KEY_CH0I, KEY_BCLM,
+  KEY_PSTR, KEY_PDTR, KEY_PPBR, KEY_TB0T, KEY_TB1T, KEY_TB2T,
+  KEY_B0AC, KEY_B0AV, KEY_B0RM, KEY_B0FC, KEY_B0CT, KEYS
+};
+
+static const struct {
+  char name[5];
+  uint32_t type;
+  uint32_t size;
+  int writable;
+} k_keys[KEYS] = {
+    {"CHTE", BSIM_TYPE('u', 'i', '3', '2'), 4, 1},
+    {"CHIE", BSIM_TYPE('h', 'e', 'x', '_'), 1, 1},
+    {"CH0B", BSIM_TYPE('h', 'e', 'x', '_'), 1, 1},
+    {"CH0C", BSIM_TYPE('h', 'e', 'x', '_'), 1, 1},
+    {"CH0I", BSIM_TYPE('h', 'e', 'x', '_'), 1, 1},
+    {"BCLM", BSIM_TYPE('u', 'i', '8', ' '), 1, 1},
+    {"PSTR", BSIM_TYPE('f', 'l', 't', ' '), 4, 0},
+    {"PDTR", BSIM_TYPE('f', 'l', 't', ' '), 4, 0},
+    {"PPBR", BSIM_TYPE('f', 'l', 't', ' '), 4, 0},
+    {"TB0T", BSIM_TYPE('f', 'l', 't', ' '), 4, 0},
+    {"TB1T", BSIM_TYPE('f', 'l', 't', ' '), 4, 0},
+    {"TB2T", BSIM_TYPE('f', 'l', 't', ' '), 4, 0},
+    {"B0AC", BSIM_TYPE('s', 'i', '1', '6'), 2, 0},
+    {"B0AV", BSIM_TYPE('u', 'i', '1', '6'), 2, 0},
+    {"B0RM", BSIM_TYPE('u', 'i', '1', '6'), 2, 0},
+    {"B0FC", BSIM_TYPE('u', 'i', '1', '6'), 2, 0},
+    {"B0CT", BSIM_TYPE('u', 'i', '1', '6'), 2, 0},
+};
+
+static int find_key(const char *key) {
+  if (key == NULL)
+    return -1;
+  for (int i = 0; i < KEYS; i++)
+    if (strncmp(k_keys[i].name, key, 4) == 0)
+      return i;
+  return -1;
+}
+
+// Integers are little-endian, as on Apple Silicon
+static void put_uint(uint8_t *b, uint64_t v, uint32_t size) {
+  for (uint32_t i = 0; i < size; i++)
+    b[i] = (uint8_t)(v >> (8 * i));
+}
+
+static void put_float(uint8_t *b, double v) {
+  float f = (float)v;
+  memcpy(b, &f, 4);
+}
+
+// Power the adapter delivers: the system plus the charger's input
+static double dc_in_w(const bsim_t *s) {
+  if (!adapter_on(s))
+    return 0;
+  double w = s->system_w;
+  if (s->amps > 0)
+    w += s->amps * s->volts / s->p.charger_eff;
+  return w < s->p.adapter_w ? w : s->p.adapter_w;
+}
+
+// ============================================================
+// Battery properties
+// ============================================================
+
+static int prop_locked(const bsim_t *s, const char *name, int64_t *out) {
+  double mah = s->soc * s->p.capacity_mah;
+  if (strcmp(name, "CurrentCapacity") == 0)
+    *out = s->full ? 100 : (int64_t)floor(s->soc * 100.0 + 0.5);
+  else if (strcmp(name, "MaxCapacity") == 0)
+    *out = 100;
+  else if (strcmp(name, "AppleRawCurrentCapacity") == 0)
+    *out = (int64_t)lround(mah);
+  else if (strcmp(name, "AppleRawMaxCapacity") == 0)
+    *out = (int64_t)lround(s->p.capacity_mah);
+  else if (strcmp(name, "DesignCapacity") == 0)
+    *out = s->p.design_mah;
+  else if (strcmp(name, "CycleCount") == 0)
+    *out = s->cycles;
+  else if (strcmp(name, "Voltage") == 0)
+    *out = (int64_t)lround(s->volts * 1000.0);
+  else if (strcmp(name, "Amperage") == 0 ||
+           strcmp(name, "InstantAmperage") == 0)
+    *out = (int64_t)lround(s->amps * 1000.0);
+  else if (strcmp(name, "Temperature") == 0)
+    *out = (int64_t)lround(s->temp_c * 100.0);
+  else if (strcmp(name, "IsCharging") == 0)
+    *out = s->amps > 0;
+  else if (strcmp(name, "ExternalConnected") == 0)
+    *out = s->plugged;
+  else if (strcmp(name, "FullyCharged") == 0)
+    *out = s->full;
+  else if (strcmp(name, "BatteryInstalled") == 0)
+    *out = 1;
+  else if (strcmp(name, "PermanentFailureStatus") == 0)
+    *out = 0;
+  else if (strcmp(name, "ChargeInhibit") == 0)
+    *out = s->inhibit_prop;
+  else if (strcmp(name, "ChargeRate") == 0)
+    *out = s->charge_rate;
+  else if (strcmp(name, "AdapterDetails.Watts") == 0 && s->plugged)
+    *out = (int64_t)lround(s->p.adapter_w);
+  else
+    return -1;
+  return 0;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void bsim_default_params(bsim_params_t *p) {
+  if (p == NULL)
+    return;
+  memset(p, 0, sizeof(*p));
+  p->cells = 3;
+  p->capacity_mah = 5800;
+  p->design_mah = 6075;
+  p->cycle_count = 120;
+  p->r0_ohm = 0.09;
+  p->r1_ohm = 0.06;
+  p->c1_f = 500; // 30 s polarisation
+  p->charge_ma = 4600;
+  p->cv_mv_cell = 4350;
+  p->term_ma = 290; // C/20
+  p->adapter_w = 96;
+  p->charger_eff = 0.9;
+  p->ambient_c = 25;
+  p->heat_j_per_k = 800; // 40 minute thermal time constant
+  p->cool_k_per_w = 3.0;
+  p->system_heat = 0.15;
+  p->soc = 0.5;
+  p->plugged = 0;
+}
+
+bsim_t *bsim_create(const bsim_params_t *params, int64_t start_ms) {
+  bsim_params_t p;
+  if (params)
+    p = *params;
+  else
+    bsim_default_params(&p);
+  if (p.cells <= 0 || p.capacity_mah <= 0 || p.r0_ohm <= 0 ||
+      p.r1_ohm <= 0 || p.charger_eff <= 0 || p.heat_j_per_k <= 0 ||
+      p.cool_k_per_w <= 0) {
+    fprintf(stderr, "bsim: invalid parameters\n");
+    return NULL;
+  }
+  bsim_t *s = calloc(1, sizeof(bsim_t));
+  if (s == NULL)
+    return NULL;
+  pthread_mutex_init(&s->lock, NULL);
+  s->p = p;
+  s->t_ms = start_ms;
+  s->base_ms = start_ms;
+  s->soc = p.soc < 0 ? 0 : p.soc > 1 ? 1 : p.soc;
+  s->temp_c = p.ambient_c;
+  s->volts = ocv(s, s->soc);
+  s->cycles = p.cycle_count;
+  s->plugged = p.plugged != 0;
+  s->bclm = 100;
+  s->charge_rate = -1;
+  s->base_w = BSIM_IDLE_W;
+  s->system_w = BSIM_IDLE_W;
+  return s;
+}
+
+void bsim_free(bsim_t *sim) {
+  if (sim == NULL)
+    return;
+  pthread_mutex_destroy(&sim->lock);
+  free(sim->events);
+  free(sim);
+}
+
+int bsim_set_load(bsim_t *sim, const bsim_load_t *load) {
+  if (sim == NULL || load == NULL)
+    return -1;
+  bsim_event_t *events = NULL;
+  if (load->kind == BSIM_LOAD_PERIODIC &&
+      (load->period_ms <= 0 || load->duty < 0 || load->duty > 1))
+    return -1;
+  if (load->kind == BSIM_LOAD_SCRIPT) {
+    if (load->events == NULL || load->count == 0 ||
+        load->count > BSIM_MAX_EVENTS)
+      return -1;
+    for (size_t i = 0; i < load->count; i++) {
+      int64_t at = load->events[i].at_ms;
+      if (at < 0 || (i > 0 && at < load->events[i - 1].at_ms) ||
+          (load->loop_ms > 0 && at >= load->loop_ms))
+        return -1;
+    }
+    events = malloc(load->count * sizeof(bsim_event_t));
+    if (events == NULL)
+      return -1;
+    memcpy(events, load->events, load->count * sizeof(bsim_event_t));
+  }
+
+  pthread_mutex_lock(&sim->lock);
+  free(sim->events);
+  sim->events = events;
+  sim->count = events ? load->count : 0;
+  sim->cursor = 0;
+  sim->loop_ms = load->loop_ms;
+  sim->load_kind = load->kind;
+  sim->base_w = load->system_w;
+  sim->peak_w = load->peak_w;
+  sim->period_ms = load->period_ms;
+  sim->duty = load->duty;
+  sim->base_ms = sim->t_ms;
+  load_update(sim);
+  pthread_mutex_unlock(&sim->lock);
+  return 0;
+}
+
+void bsim_set_plugged(bsim_t *sim, int plugged) {
+  if (sim == NULL)
+    return;
+  pthread_mutex_lock(&sim->lock);
+  sim->plugged = plugged != 0;
+  pthread_mutex_unlock(&sim->lock);
+}
+
+void bsim_set_ambient(bsim_t *sim, double celsius) {
+  if (sim == NULL)
+    return;
+  pthread_mutex_lock(&sim->lock);
+  sim->p.ambient_c = celsius;
+  pthread_mutex_unlock(&sim->lock);
+}
+
+void bsim_advance(bsim_t *sim, int64_t dt_ms) {
+  if (sim == NULL || dt_ms <= 0)
+    return;
+  pthread_mutex_lock(&sim->lock);
+  advance_locked(sim, dt_ms);
+  pthread_mutex_unlock(&sim->lock);
+}
+
+void bsim_set_speed(bsim_t *sim, double speed) {
+  if (sim == NULL)
+    return;
+  pthread_mutex_lock(&sim->lock);
+  sim->speed = speed > 0 ? speed : 0;
+  pthread_mutex_unlock(&sim->lock);
+}
+
+void bsim_sync(bsim_t *sim, int64_t wall_ms) {
+  if (sim == NULL)
+    return;
+  pthread_mutex_lock(&sim->lock);
+  if (sim->have_wall && wall_ms > sim->wall_ms) {
+    double dt = (double)(wall_ms - sim->wall_ms) * sim->speed + sim->carry_ms;
+    int64_t whole = (int64_t)dt;
+    sim->carry_ms = dt - (double)whole;
+    advance_locked(sim, whole);
+  }
+  if (!sim->have_wall || wall_ms > sim->wall_ms)
+    sim->wall_ms = wall_ms;
+  sim->have_wall = 1;
+  pthread_mutex_unlock(&sim->lock);
+}
+
+int64_t bsim_now_ms(bsim_t *sim) {
+  if (sim == NULL)
+    return 0;
+  pthread_mutex_lock(&sim->lock);
+  int64_t t = sim->t_ms;
+  pthread_mutex_unlock(&sim->lock);
+  return t;
+}
+
+int bsim_key_info(bsim_t *sim, const char *key, uint32_t *type,
+                  uint32_t *size) {
+  int k = find_key(key);
+  if (sim == NULL || k < 0)
+    return -1;
+  *type = k_keys[k].type;
+  *size = k_keys[k].size;
+  return 0;
+}
+
+int bsim_read_key(bsim_t *sim, const char *key, uint8_t *bytes,
+                  uint32_t *size) {
+  int k = find_key(key);
+  if (sim == NULL || k < 0)
+    return -1;
+  pthread_mutex_lock(&sim->lock);
+  const bsim_t *s = sim;
+  // Cells differ a little; the middle one runs warmest
+  static const double spread[3] = {0.0, 0.4, -0.3};
+  switch (k) {
+  case KEY_CHTE:
+    put_uint(bytes, s->chte, 4);
+    break;
+  case KEY_CHIE:
+    bytes[0] = s->chie;
+    break;
+  case KEY_CH0B:
+    bytes[0] = s->ch0b;
+    break;
+  case KEY_CH0C:
+    bytes[0] = s->ch0c;
+    break;
+  case KEY_CH0I:
+    bytes[0] = s->ch0i;
+    break;
+  case KEY_BCLM:
+    bytes[0] = s->bclm;
+    break;
+  case KEY_PSTR:
+    put_float(bytes, s->system_w);
+    break;
+  case KEY_PDTR:
+    put_float(bytes, dc_in_w(s));
+    break;
+  case KEY_PPBR:
+    put_float(bytes, -s->amps * s->volts);
+    break;
+  case KEY_TB0T:
+  case KEY_TB1T:
+  case KEY_TB2T:
+    put_float(bytes, s->temp_c + spread[k - KEY_TB0T]);
+    break;
+  case KEY_B0AC:
+    put_uint(bytes, (uint16_t)(int16_t)lround(s->amps * 1000.0), 2);
+    break;
+  case KEY_B0AV:
+    put_uint(bytes, (uint64_t)lround(s->volts * 1000.0), 2);
+    break;
+  case KEY_B0RM:
+    put_uint(bytes, (uint64_t)lround(s->soc * s->p.capacity_mah), 2);
+    break;
+  case KEY_B0FC:
+    put_uint(bytes, (uint64_t)lround(s->p.capacity_mah), 2);
+    break;
+  case KEY_B0CT:
+    put_uint(bytes, (uint64_t)s->cycles, 2);
+    break;
+  }
+  pthread_mutex_unlock(&sim->lock);
+  *size = k_keys[k].size;
+  return 0;
+}
+
+int bsim_write_key(bsim_t *sim, const char *key, const uint8_t *bytes,
+                   uint32_t size) {
+  int k = find_key(key);
+  if (sim == NULL || k < 0 || !k_keys[k].writable || bytes == NULL ||
+      size < k_keys[k].size)
+    return -1;
+  pthread_mutex_lock(&sim->lock);
+  switch (k) {
+  case KEY_CHTE:
+    sim->chte = (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 |
+                (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+    break;
+  case KEY_CHIE:
+    sim->chie = bytes[0];
+    break;
+  case KEY_CH0B:
+    sim->ch0b = bytes[0];
+    break;
+  case KEY_CH0C:
+    sim->ch0c = bytes[0];
+    break;
+  case KEY_CH0I:
+    sim->ch0i = bytes[0];
+    break;
+  case KEY_BCLM:
+    sim->bclm = bytes[0] > 100 ? 100 : bytes[0];
+    break;
+  }
+  pthread_mutex_unlock(&sim->lock);
+  return 0;
+}
+
+int bsim_property(bsim_t *sim, const char *name, int64_t *out) {
+  if (sim == NULL || name == NULL || out == NULL)
+    return -1;
+  pthread_mutex_lock(&sim->lock);
+  int rc = prop_locked(sim, name, out);
+  pthread_mutex_unlock(&sim->lock);
+  return rc;
+}
+
+int bsim_set_property(bsim_t *sim, const char *name, int64_t value) {
+  if (sim == NULL || name == NULL)
+    return -1;
+  int rc = 0;
+  pthread_mutex_lock(&sim->lock);
+  if (strcmp(name, "ChargeInhibit") == 0)
+    sim->inhibit_prop = value != 0;
+  else if (strcmp(name, "ChargeRate") == 0)
+    sim->charge_rate = value < 0 ? -1 : value;
+  else
+    rc = -1;
+  pthread_mutex_unlock(&sim->lock);
+  return rc;
+}
+
+// ============================================================
+// Device backend
+// ============================================================
+
+static int sim_enumerate(void *ctx, pdev_info_t *out, int max) {
+  (void)ctx;
+  if (max < 1)
+    return 0;
+  memset(out, 0, sizeof(*out));
+  snprintf(out->id, sizeof(out->id), "bsim0");
+  snprintf(out->name, sizeof(out->name), "Simulated Battery");
+  out->kind = PDEV_INTERNAL;
+  return 1;
+}
+
+// Mirrors the AppleSmartBattery read in power_device.c property for property
+static int sim_read(void *ctx, int index, pdev_sample_t *out) {
+  bsim_t *sim = ctx;
+  if (index != 0)
+    return -1;
+  int64_t v, cur = 0, max = 0;
+  if (bsim_property(sim, "CurrentCapacity", &cur) == 0 &&
+      bsim_property(sim, "MaxCapacity", &max) == 0 && max > 0)
+    out->level = (int32_t)(cur * 100 / max);
+  if (bsim_property(sim, "AppleRawCurrentCapacity", &v) == 0)
+    out->cur_mah = (int32_t)v;
+  if (bsim_property(sim, "AppleRawMaxCapacity", &v) == 0)
+    out->max_mah = (int32_t)v;
+  if (bsim_property(sim, "DesignCapacity", &v) == 0)
+    out->design_mah = (int32_t)v;
+  if (bsim_property(sim, "CycleCount", &v) == 0)
+    out->cycle_count = (int32_t)v;
+  if (bsim_property(sim, "Voltage", &v) == 0)
+    out->voltage_mv = (int32_t)v;
+  if (bsim_property(sim, "Temperature", &v) == 0)
+    out->temp_cc = (int32_t)v;
+  if (bsim_property(sim, "Amperage", &v) == 0)
+    out->amperage_ma = (int32_t)v;
+  if (bsim_property(sim, "IsCharging", &v) == 0)
+    out->charging = (uint8_t)(v != 0);
+  if (bsim_property(sim, "ExternalConnected", &v) == 0)
+    out->plugged = (uint8_t)(v != 0);
+  return 0;
+}
+
+int bsim_backend(bsim_t *sim, pdev_backend_t *out) {
+  if (sim == NULL || out == NULL)
+    return -1;
+  memset(out, 0, sizeof(*out));
+  out->name = "simulator";
+  out->ctx = sim;
+  out->enumerate = sim_enumerate;
+  out->read = sim_read;
+  return 0; // the caller keeps ownership of the simulator
+}
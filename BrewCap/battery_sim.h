@@ -0,0 +1,135 @@
+//
+//  battery_sim.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef battery_sim_h
+#define battery_sim_h
+
+#include "power_device.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// A simulated laptop battery, for exercising battery reads and charge
+// control where there is no battery to read (Linux, CI) or where waiting a
+// week for real data is too slow.
+//
+// The pack is a Thevenin equivalent circuit: open-circuit voltage from a
+// state-of-charge table, a series resistance R0 and one RC pair (R1, C1)
+// for the slow polarisation. The charger is constant current up to the
+// charge voltage, then constant voltage until the current falls below the
+// termination current; it starts again below BSIM_RESUME_PCT, as a Mac
+// does. Charge current is also capped by whatever the adapter has left over
+// after the system load. Heat (I^2 R in both resistors plus a share of the
+// system load) goes into one lumped thermal mass cooled towards ambient.
+//
+// It answers the same questions as the hardware: SMC keys (CHTE, CHIE,
+// CH0B, CH0C, CH0I, BCLM writes; PSTR, PDTR, PPBR, TB*T, B0** reads, with
+// Apple Silicon types and byte order) and AppleSmartBattery properties
+// (CurrentCapacity, Amperage, ExternalConnected, ...). smc.c routes its key
+// calls here once smc_attach_simulator() is called, and bsim_backend() puts
+// it behind a pdev_backend_t.
+//
+// Time is whatever the caller says: bsim_advance() moves it by any amount,
+// integrating in steps of at most BSIM_STEP_MS that never cross a load
+// change, so results do not depend on how the time was chunked. bsim_sync()
+// ties it to a wall clock at a chosen speed. Every call takes the
+// simulator's lock, so the app's reader and charge control threads can share
+// one.
+
+#define BSIM_STEP_MS 1000   // longest integration step
+#define BSIM_RESUME_PCT 95  // a full battery is topped up again below this
+#define BSIM_MAX_EVENTS 256 // per load script
+#define BSIM_IDLE_W 8.0f    // constant system load until a profile is set
+
+typedef struct {
+  int cells;           // in series
+  double capacity_mah; // full charge capacity
+  int32_t design_mah;
+  int32_t cycle_count; // at the start
+  double r0_ohm;       // whole pack, at 25 C
+  double r1_ohm;
+  double c1_f;
+  double charge_ma;    // constant-current phase
+  double cv_mv_cell;   // constant-voltage phase
+  double term_ma;      // charging ends below this in the CV phase
+  double adapter_w;
+  double charger_eff;  // adapter power that reaches the battery
+  double ambient_c;
+  double heat_j_per_k; // thermal mass
+  double cool_k_per_w; // thermal resistance to ambient
+  double system_heat;  // share of the system load that heats the battery
+  double soc;          // 0..1 at the start
+  int plugged;         // at the start
+} bsim_params_t;
+
+// A 3-cell 70 Wh pack on a 96 W adapter, half full, unplugged
+void bsim_default_params(bsim_params_t *p);
+
+// Load profiles: what the rest of the machine draws, and when the charger
+// is connected. Event times are relative to when the profile is set.
+typedef enum {
+  BSIM_LOAD_CONSTANT = 0, // system_w
+  BSIM_LOAD_PERIODIC,     // peak_w for duty of every period, else system_w
+  BSIM_LOAD_SCRIPT,       // events
+} bsim_load_kind_t;
+
+typedef struct {
+  int64_t at_ms;
+  float system_w;
+  int8_t plugged; // 1 connect, 0 disconnect, -1 unchanged
+} bsim_event_t;
+
+typedef struct {
+  int kind;
+  float system_w;
+  float peak_w;
+  int64_t period_ms;
+  float duty; // 0..1
+  const bsim_event_t *events; // oldest first; copied
+  size_t count;
+  int64_t loop_ms; // the script repeats with this period; 0 = hold the last
+} bsim_load_t;
+
+typedef struct bsim bsim_t;
+
+// NULL params for the defaults; the clock starts at start_ms
+bsim_t *bsim_create(const bsim_params_t *params, int64_t start_ms);
+void bsim_free(bsim_t *sim);
+
+int bsim_set_load(bsim_t *sim, const bsim_load_t *load);
+void bsim_set_plugged(bsim_t *sim, int plugged);
+void bsim_set_ambient(bsim_t *sim, double celsius);
+
+// Moves simulated time forward by dt_ms
+void bsim_advance(bsim_t *sim, int64_t dt_ms);
+
+// Moves simulated time forward by speed times the wall time since the last
+// sync; the first call only sets the reference
+void bsim_set_speed(bsim_t *sim, double speed);
+void bsim_sync(bsim_t *sim, int64_t wall_ms);
+
+int64_t bsim_now_ms(bsim_t *sim);
+
+// SMC keys. key_info gives the four-char data type and size; all return 0,
+// or -1 for a key the simulated machine does not have (or a read-only key
+// on write).
+int bsim_key_info(bsim_t *sim, const char *key, uint32_t *type,
+                  uint32_t *size);
+int bsim_read_key(bsim_t *sim, const char *key, uint8_t *bytes,
+                  uint32_t *size);
+int bsim_write_key(bsim_t *sim, const char *key, const uint8_t *bytes,
+                   uint32_t size);
+
+// AppleSmartBattery properties that are numbers or booleans, plus
+// AdapterDetails.Watts. ChargeInhibit and ChargeRate can be set.
+int bsim_property(bsim_t *sim, const char *name, int64_t *out);
+int bsim_set_property(bsim_t *sim, const char *name, int64_t value);
+
+// One internal battery read through the same properties as the IOKit
+// backend. The caller keeps ownership of the simulator.
+int bsim_backend(bsim_t *sim, pdev_backend_t *out);
+
+#endif
@@ -0,0 +1,548 @@
+//
+//  charge_control.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "charge_control.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct cc {
+  cc_config_t config;
+  cc_actuator_t actuator;
+  cc_state_t state;
+  int inhibited;          // last state the actuator accepted
+  int failures;           // consecutive steps whose write failed
+  int64_t retry_ms;       // next write in Fault
+  int64_t dwell_until_ms; // no policy writes before this
+  // Verification of the inhibit in force
+  int mechanism;    // holding the charger off; -1 when none or unknown
+  int verified;     // the current was seen to stop
+  int was_charging; // it was flowing when the inhibit went in
+  int leaks;        // consecutive samples with current flowing anyway
+  int64_t leak_ms;  // first of them
+  int refuted;      // mechanism behind the last CC_NOTE_INEFFECTIVE
+  uint32_t tried;   // mechanisms rejected or refuted since the last success
+  uint32_t unavailable; // mechanisms not to use at all (cc_set_unavailable)
+  cc_mechanism_t mechanisms[CC_MAX_MECHANISMS];
+  int64_t first_ms;
+  thm_model_t thermal;
+  int32_t charge_ma; // last charging current seen, for forecasts while paused
+  int32_t adapter_w;
+  cs_rates_t rates;
+  int64_t full_from_ms; // latest start for config.full_by_ms
+  int64_t start_for_ms; // the deadline a started schedule is latched to
+  upm_model_t unplug;
+  int64_t predicted_by_ms; // a top-up for a predicted unplug runs to this
+  pdev_sample_t last;
+  int have_last;
+  cc_stats_t stats;
+};
+
+static const char *const k_state_names[CC_STATES] = {
+    "Charging", "Holding", "Inhibited (thermal)", "Travel", "Scheduled",
+    "Fault"};
+
+static int64_t local_ms(const cc_t *cc, int64_t t_ms) {
+  return t_ms + (int64_t)cc->config.utc_offset_s * 1000;
+}
+
+// Charge time to 100% with the schedule's margin
+static int64_t top_up_ms(const cc_t *cc, int level) {
+  int64_t need = cs_time_to(&cc->rates, cc->adapter_w, level, 100);
+  return need + need * CS_MARGIN_PCT / 100 + CS_MARGIN_MS;
+}
+
+static int wants_inhibit(cc_state_t state) {
+  return state == CC_HOLDING || state == CC_INHIBITED_THERMAL;
+}
+
+// The state the policy asks for, ignoring Fault. Retires Travel Mode and
+// Sailing Mode in the controller's own config when their conditions hit.
+static cc_state_t decide(cc_t *cc, const pdev_sample_t *s, uint32_t *notes) {
+  cc_config_t *c = &cc->config;
+  if (c->travel_until_ms > 0 && s->t_ms >= c->travel_until_ms) {
+    c->travel_until_ms = 0;
+    *notes |= CC_NOTE_TRAVEL_EXPIRED;
+  }
+  if (c->sailing && c->auto_pause_low && !s->plugged &&
+      s->level < c->low_level) {
+    c->sailing = 0;
+    *notes |= CC_NOTE_SAILING_AUTO_OFF;
+  }
+
+  if (c->thermal_inhibit_cc > 0 && s->plugged) {
+    int paused = cc->state == CC_INHIBITED_THERMAL;
+    int hot = paused ? s->temp_cc > c->thermal_resume_cc
+                     : s->temp_cc >= c->thermal_inhibit_cc;
+    // Predictive: would charging (now, or once resumed) cross the limit
+    // within the horizon? Resuming needs the forecast under the resume
+    // threshold, the same band the measured temperature gets.
+    if (!hot && c->forecast_ms > 0 && (s->charging || paused) &&
+        thm_ready(&cc->thermal)) {
+      int32_t ma = s->amperage_ma > 0 ? s->amperage_ma : cc->charge_ma;
+      int32_t ahead =
+          thm_forecast(&cc->thermal, c->forecast_ms / 1000, ma, s->power_w);
+      hot = paused ? ahead > c->thermal_resume_cc
+                   : ahead >= c->thermal_inhibit_cc;
+    }
+    if (hot)
+      return CC_INHIBITED_THERMAL;
+  }
+  if (c->full_by_ms > 0) {
+    if (s->t_ms >= c->full_by_ms + CC_SCHEDULE_GRACE_MS ||
+        (s->t_ms >= c->full_by_ms && !s->plugged)) {
+      c->full_by_ms = 0;
+      cc->full_from_ms = 0;
+      *notes |= CC_NOTE_SCHEDULE_DONE;
+    } else {
+      // Once started the start stays put; recomputed, it would slide later
+      // as the level rises and the charger would toggle
+      if (cc->state != CC_SCHEDULED || cc->start_for_ms != c->full_by_ms) {
+        int target = c->full_target ? c->full_target : 100;
+        cc->full_from_ms = cs_latest_start(&cc->rates, cc->adapter_w,
+                                           s->level, target, c->full_by_ms);
+      }
+      if (s->t_ms >= cc->full_from_ms) {
+        cc->start_for_ms = c->full_by_ms;
+        return CC_SCHEDULED;
+      }
+    }
+  }
+  if (!s->plugged)
+    cc->predicted_by_ms = 0;
+  if (c->sailing && c->predict_unplug && s->plugged) {
+    // Latched like the schedule until the expected unplug has had its grace
+    if (cc->state == CC_SCHEDULED && cc->predicted_by_ms > 0 &&
+        s->t_ms < cc->predicted_by_ms + CC_SCHEDULE_GRACE_MS)
+      return CC_SCHEDULED;
+    int64_t need = top_up_ms(cc, s->level);
+    double p = upm_probability(&cc->unplug, local_ms(cc, s->t_ms), need);
+    if (p * 100.0 >= c->predict_unplug) {
+      cc->predicted_by_ms = s->t_ms + need;
+      return CC_SCHEDULED;
+    }
+    cc->predicted_by_ms = 0;
+  }
+  if (c->travel_until_ms > 0)
+    return CC_TRAVEL;
+  if (c->sailing) {
+    int hold_at = c->limit + c->band_above < 100 ? c->limit + c->band_above : 100;
+    int hold = cc->state == CC_HOLDING
+                   ? s->level >= (int)c->limit - c->band_below
+                   : s->plugged && s->level >= hold_at;
+    if (hold)
+      return CC_HOLDING;
+  }
+  return CC_CHARGING;
+}
+
+static int mechanism_count(const cc_t *cc) {
+  int n = cc->actuator.mechanisms;
+  if (n < 1)
+    return 1;
+  return n < CC_MAX_MECHANISMS ? n : CC_MAX_MECHANISMS;
+}
+
+static int flowing(const pdev_sample_t *s) {
+  return s->charging && s->amperage_ma > CC_VERIFY_MA;
+}
+
+static int actuate(cc_t *cc, int mechanism, int enabled) {
+  cc->stats.writes++;
+  if (cc->actuator.set_charging &&
+      cc->actuator.set_charging(cc->actuator.ctx, mechanism, enabled) == 0)
+    return 0;
+  cc->stats.failures++;
+  return -1;
+}
+
+// Best untried mechanism: a refutation outweighs two confirmations, and
+// without records the actuator's order decides. -1 when none is left.
+static int pick(const cc_t *cc) {
+  int best = -1;
+  int64_t best_score = 0;
+  for (int m = 0; m < mechanism_count(cc); m++) {
+    if ((cc->tried | cc->unavailable) & (1u << m))
+      continue;
+    int64_t score = (int64_t)cc->mechanisms[m].confirmed -
+                    2 * (int64_t)cc->mechanisms[m].refuted;
+    if (best < 0 || score > best_score) {
+      best = m;
+      best_score = score;
+    }
+  }
+  return best;
+}
+
+// Charger off through the best mechanism that accepts the write
+static int inhibit(cc_t *cc, const pdev_sample_t *s) {
+  int m;
+  while ((m = pick(cc)) >= 0) {
+    if (actuate(cc, m, 0) == 0) {
+      cc->inhibited = 1;
+      cc->mechanism = m;
+      cc->verified = 0;
+      cc->was_charging = flowing(s);
+      cc->leaks = 0;
+      return 0;
+    }
+    cc->tried |= 1u << m;
+  }
+  return -1;
+}
+
+// Charger on through the mechanism that turned it off, or through all of
+// them when that is not known
+static int release(cc_t *cc) {
+  int ok = 0;
+  if (cc->mechanism >= 0) {
+    ok = actuate(cc, cc->mechanism, 1) == 0;
+  } else {
+    for (int m = 0; m < mechanism_count(cc); m++)
+      if (!(cc->unavailable & (1u << m)) && actuate(cc, m, 1) == 0)
+        ok = 1;
+  }
+  if (!ok)
+    return -1;
+  cc->inhibited = 0;
+  cc->mechanism = -1;
+  cc->verified = 0;
+  cc->leaks = 0;
+  return 0;
+}
+
+// Checks a new sample against the inhibit in force. Returns -1 when it
+// refuted the last mechanism left to try.
+static int verify(cc_t *cc, const pdev_sample_t *s, uint32_t *notes) {
+  if (!cc->inhibited || !s->plugged)
+    return 0;
+  if (!flowing(s)) {
+    cc->leaks = 0;
+    if (!cc->verified) {
+      cc->verified = 1;
+      cc->tried = 0;
+      // Only a current that was there and stopped says the write did it
+      if (cc->mechanism >= 0 && cc->was_charging)
+        cc->mechanisms[cc->mechanism].confirmed++;
+      if (cc->state == CC_HOLDING)
+        *notes |= CC_NOTE_PAUSED;
+      else if (cc->state == CC_INHIBITED_THERMAL)
+        *notes |= CC_NOTE_THERMAL;
+    }
+    return 0;
+  }
+  if (cc->leaks++ == 0)
+    cc->leak_ms = s->t_ms;
+  if (cc->leaks < CC_VERIFY_SAMPLES || s->t_ms - cc->leak_ms < CC_VERIFY_MS)
+    return 0;
+
+  int m = cc->mechanism;
+  fprintf(stderr, "cc: %d mA still flowing through mechanism %d\n",
+          s->amperage_ma, m);
+  *notes |= CC_NOTE_INEFFECTIVE;
+  cc->refuted = m;
+  if (m >= 0) {
+    cc->mechanisms[m].refuted++;
+    cc->tried |= 1u << m;
+  }
+  // Undo it whatever the result: it was not holding anything off
+  release(cc);
+  cc->inhibited = 0;
+  cc->mechanism = -1;
+  cc->dwell_until_ms = 0; // the next mechanism goes in at once
+  return pick(cc) < 0 ? -1 : 0;
+}
+
+static void report(const cc_t *cc, uint32_t notes, cc_output_t *out) {
+  out->state = cc->state;
+  out->inhibited = (uint8_t)(cc->inhibited && cc->verified);
+  out->verifying = (uint8_t)(cc->inhibited && !cc->verified);
+  out->mechanism = (int8_t)((notes & CC_NOTE_INEFFECTIVE) ? cc->refuted
+                            : cc->inhibited                ? cc->mechanism
+                                                           : -1);
+  out->notices = notes;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+cc_t *cc_create(const cc_config_t *config, cc_actuator_t actuator) {
+  cc_t *cc = calloc(1, sizeof(cc_t));
+  if (cc == NULL)
+    return NULL;
+  if (config)
+    cc->config = *config;
+  cc->actuator = actuator;
+  cc->state = CC_CHARGING;
+  cc->mechanism = -1;
+  cc->refuted = -1;
+  thm_init(&cc->thermal);
+  cs_init(&cc->rates);
+  upm_init(&cc->unplug);
+  return cc;
+}
+
+void cc_free(cc_t *cc) { free(cc); }
+
+void cc_configure(cc_t *cc, const cc_config_t *config) {
+  if (cc && config) {
+    cc->config = *config;
+    cc->dwell_until_ms = 0;
+  }
+}
+
+void cc_set_adapter(cc_t *cc, int32_t adapter_w) {
+  if (cc)
+    cc->adapter_w = adapter_w;
+}
+
+void cc_learn_session(cc_t *cc, int64_t start_ms, int64_t end_ms) {
+  if (cc)
+    upm_session(&cc->unplug, local_ms(cc, start_ms), local_ms(cc, end_ms));
+}
+
+void cc_set_unavailable(cc_t *cc, uint32_t mask) {
+  if (cc)
+    cc->unavailable = mask;
+}
+
+void cc_unplug_model(const cc_t *cc, upm_model_t *out) {
+  if (out == NULL)
+    return;
+  if (cc)
+    *out = cc->unplug;
+  else
+    upm_init(out);
+}
+
+void cc_set_unplug_model(cc_t *cc, const upm_model_t *model) {
+  if (cc && model) {
+    cc->unplug = *model;
+    cc->unplug.have_last = 0;
+  }
+}
+
+void cc_rates(const cc_t *cc, cs_rates_t *out) {
+  if (out == NULL)
+    return;
+  if (cc)
+    *out = cc->rates;
+  else
+    cs_init(out);
+}
+
+void cc_set_rates(cc_t *cc, const cs_rates_t *rates) {
+  if (cc && rates)
+    cc->rates = *rates;
+}
+
+void cc_assume(cc_t *cc, int inhibited) {
+  if (cc == NULL)
+    return;
+  cc->inhibited = inhibited != 0;
+  cc->mechanism = -1;
+  cc->verified = 0;
+  cc->was_charging = 0;
+  cc->leaks = 0;
+}
+
+int cc_mechanisms(const cc_t *cc, cc_mechanism_t *out, int max) {
+  if (cc == NULL || out == NULL)
+    return 0;
+  int n = mechanism_count(cc);
+  if (n > max)
+    n = max;
+  memcpy(out, cc->mechanisms, (size_t)(n > 0 ? n : 0) * sizeof(*out));
+  return n > 0 ? n : 0;
+}
+
+void cc_set_mechanisms(cc_t *cc, const cc_mechanism_t *records, int count) {
+  if (cc == NULL || records == NULL)
+    return;
+  if (count > CC_MAX_MECHANISMS)
+    count = CC_MAX_MECHANISMS;
+  for (int m = 0; m < count; m++)
+    cc->mechanisms[m] = records[m];
+}
+
+int cc_step(cc_t *cc, const pdev_sample_t *sample, cc_output_t *out) {
+  if (cc == NULL || out == NULL)
+    return -1;
+  memset(out, 0, sizeof(*out));
+  out->mechanism = -1;
+  if (sample && sample->valid) {
+    if (!cc->have_last)
+      cc->first_ms = sample->t_ms;
+    cc->last = *sample;
+    cc->have_last = 1;
+    thm_update(&cc->thermal, sample);
+    cs_observe(&cc->rates, sample, cc->adapter_w);
+    upm_sample(&cc->unplug, local_ms(cc, sample->t_ms), sample->plugged);
+    if (sample->amperage_ma > 0)
+      cc->charge_ma = sample->amperage_ma;
+  }
+  if (!cc->have_last || (sample && !sample->valid)) {
+    report(cc, 0, out);
+    return 0;
+  }
+  const pdev_sample_t *s = &cc->last;
+  cc->stats.steps++;
+  cc->stats.span_ms = s->t_ms - cc->first_ms;
+
+  uint32_t notes = 0;
+  if (sample && verify(cc, s, &notes) < 0 && cc->state != CC_FAULT) {
+    fprintf(stderr, "cc: no mechanism stops charging, entering Fault\n");
+    notes |= CC_NOTE_FAULT;
+    cc->stats.transitions++;
+    cc->state = CC_FAULT;
+    cc->retry_ms = s->t_ms + CC_VERIFY_RETRY_MS;
+  }
+  cc_state_t next = decide(cc, s, &notes);
+
+  if (cc->state == CC_FAULT) {
+    // Leave charging on until writes work again; retry on a slow clock
+    if (!cc->config.armed) {
+      cc->failures = 0;
+      cc->tried = 0;
+    } else if (s->t_ms < cc->retry_ms) {
+      next = CC_FAULT;
+    } else {
+      cc->tried = 0;
+      if (release(cc) == 0) {
+        cc->failures = 0;
+        notes |= CC_NOTE_RECOVERED;
+      } else {
+        next = CC_FAULT;
+        cc->retry_ms = s->t_ms + CC_FAULT_RETRY_MS;
+      }
+    }
+  }
+
+  int write = next != CC_FAULT && cc->config.armed &&
+              wants_inhibit(next) != cc->inhibited;
+  if (write && next != CC_INHIBITED_THERMAL && s->t_ms < cc->dwell_until_ms) {
+    // Too soon after the last write: stay put and look again next step
+    cc->stats.deferred++;
+    next = cc->state;
+  } else if (write) {
+    int rc = wants_inhibit(next) ? inhibit(cc, s) : release(cc);
+    if (rc == 0) {
+      // PAUSED / THERMAL wait for verify() to see the current stop
+      cc->failures = 0;
+      cc->dwell_until_ms = s->t_ms + cc->config.min_dwell_ms;
+    } else if (++cc->failures >= CC_FAULT_AFTER) {
+      fprintf(stderr, "cc: %d charger writes failed, entering Fault\n",
+              cc->failures);
+      next = CC_FAULT;
+      notes |= CC_NOTE_FAULT;
+      cc->retry_ms = s->t_ms + CC_FAULT_RETRY_MS;
+    }
+  }
+
+  if (next != cc->state) {
+    cc->stats.transitions++;
+    cc->state = next;
+  }
+  report(cc, notes, out);
+  if (cc->config.full_by_ms > 0)
+    out->full_from_ms = cc->full_from_ms;
+  if (cc->config.predict_unplug) {
+    int64_t local = local_ms(cc, s->t_ms);
+    int64_t at = upm_likely_unplug(&cc->unplug, local, 24 * 3600000LL);
+    out->unplug_at_ms = at ? at - (local - s->t_ms) : 0;
+    if (s->plugged)
+      out->unplug_pct = (uint8_t)lround(
+          100.0 * upm_probability(&cc->unplug, local, top_up_ms(cc, s->level)));
+  }
+  if (cc->config.forecast_ms > 0 && thm_ready(&cc->thermal))
+    out->forecast_cc = thm_forecast(&cc->thermal, cc->config.forecast_ms / 1000,
+                                    s->amperage_ma, s->power_w);
+  return 0;
+}
+
+cc_state_t cc_state(const cc_t *cc) { return cc ? cc->state : CC_CHARGING; }
+
+const char *cc_state_name(cc_state_t state) {
+  return state < CC_STATES ? k_state_names[state] : "Unknown";
+}
+
+void cc_stats(const cc_t *cc, cc_stats_t *out) {
+  if (out == NULL)
+    return;
+  memset(out, 0, sizeof(*out));
+  if (cc)
+    *out = cc->stats;
+}
+
+// ============================================================
+// Fake charger
+// ============================================================
+
+struct cc_fake {
+  uint8_t off[CC_MAX_MECHANISMS];    // what each mechanism was last set to
+  uint8_t reject[CC_MAX_MECHANISMS]; // writes fail
+  uint8_t ignore[CC_MAX_MECHANISMS]; // writes succeed and do nothing
+  int fail;
+  int64_t writes;
+};
+
+cc_fake_t *cc_fake_create(void) { return calloc(1, sizeof(cc_fake_t)); }
+
+void cc_fake_fail(cc_fake_t *fake, int writes) {
+  if (fake)
+    fake->fail = writes;
+}
+
+void cc_fake_reject(cc_fake_t *fake, int mechanism) {
+  if (fake && mechanism >= 0 && mechanism < CC_MAX_MECHANISMS)
+    fake->reject[mechanism] = 1;
+}
+
+void cc_fake_ignore(cc_fake_t *fake, int mechanism) {
+  if (fake && mechanism >= 0 && mechanism < CC_MAX_MECHANISMS)
+    fake->ignore[mechanism] = 1;
+}
+
+int cc_fake_inhibited(const cc_fake_t *fake) {
+  if (fake == NULL)
+    return 0;
+  for (int m = 0; m < CC_MAX_MECHANISMS; m++)
+    if (fake->off[m] && !fake->ignore[m])
+      return 1;
+  return 0;
+}
+
+int64_t cc_fake_writes(const cc_fake_t *fake) {
+  return fake ? fake->writes : 0;
+}
+
+static int fake_set_charging(void *ctx, int mechanism, int enabled) {
+  cc_fake_t *fake = ctx;
+  fake->writes++;
+  if (fake->fail > 0) {
+    fake->fail--;
+    return -1;
+  }
+  if (mechanism < 0 || mechanism >= CC_MAX_MECHANISMS ||
+      fake->reject[mechanism])
+    return -1;
+  fake->off[mechanism] = !enabled;
+  return 0;
+}
+
+int cc_fake_actuator(cc_fake_t *fake, int mechanisms, cc_actuator_t *out) {
+  if (fake == NULL || out == NULL)
+    return -1;
+  out->ctx = fake;
+  out->mechanisms = mechanisms;
+  out->set_charging = fake_set_charging;
+  return 0; // the caller keeps ownership of the fake
+}
+
+void cc_fake_destroy(cc_fake_t *fake) { free(fake); }
@@ -0,0 +1,215 @@
+//
+//  charge_control.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef charge_control_h
+#define charge_control_h
+
+#include "charge_schedule.h"
+#include "power_device.h"
+#include "thermal_model.h"
+#include "unplug_model.h"
+#include <stdint.h>
+
+// Charging policy as an explicit state machine. Each battery sample is one
+// step: the controller picks a state, and when that needs the charger on or
+// off differently from what the hardware was last told, it issues the write
+// through an actuator. Time comes from the samples, so a run is replayable.
+//
+// A write the actuator accepts is not trusted until the samples agree: after
+// an inhibit, the current has to stop. If it keeps flowing, that mechanism is
+// undone, marked ineffective and the next one is tried. Confirmations and
+// refutations are kept per mechanism, so later inhibits start with the one
+// that has worked on this machine.
+
+typedef enum {
+  CC_CHARGING = 0,      // charging allowed
+  CC_HOLDING,           // Sailing Mode at or above the limit on AC
+  CC_INHIBITED_THERMAL, // too hot to charge
+  CC_TRAVEL,            // Travel Mode: the limit is lifted until it expires
+  CC_SCHEDULED,         // charging to full_target for full_by_ms, or to 100%
+                        // for an unplug predict_unplug expects
+  CC_FAULT,             // the actuator keeps failing, or no mechanism stops
+                        // the current; charging is re-enabled
+  CC_STATES
+} cc_state_t;
+
+// Things the app should tell the user about, reported once per occurrence
+enum {
+  CC_NOTE_SAILING_AUTO_OFF = 1 << 0, // battery fell below low_level unplugged
+  CC_NOTE_TRAVEL_EXPIRED = 1 << 1,
+  CC_NOTE_PAUSED = 1 << 2,  // charging was seen to stop at the limit
+  CC_NOTE_THERMAL = 1 << 3, // charging was seen to stop for heat
+  CC_NOTE_FAULT = 1 << 4,
+  CC_NOTE_RECOVERED = 1 << 5,   // the actuator works again
+  CC_NOTE_INEFFECTIVE = 1 << 6, // a mechanism took the write but the current
+                                // kept flowing; see cc_output_t.mechanism
+  CC_NOTE_SCHEDULE_DONE = 1 << 7, // the deadline passed and the charger was
+                                  // unplugged, or the grace period ran out
+};
+
+typedef struct {
+  uint8_t armed;          // the actuator may be used (SMC setup done)
+  uint8_t sailing;        // hold at limit while on AC
+  uint8_t limit;          // percent
+  uint8_t auto_pause_low; // turn Sailing Mode off below low_level unplugged
+  uint8_t low_level;      // percent
+  // Sailing hysteresis: hold from limit + band_above, resume once the level
+  // is below limit - band_below (plugged in or not)
+  uint8_t band_above;
+  uint8_t band_below;
+  int32_t thermal_inhibit_cc; // centi-degrees C; 0 disables heat protection
+  int32_t thermal_resume_cc;
+  // Pause early when the thermal model forecasts thermal_inhibit_cc within
+  // this horizon while charging; 0 reacts to the measured temperature only
+  int64_t forecast_ms;
+  int64_t travel_until_ms; // 0 = Travel Mode off
+  // Be at full_target percent (0 = 100) by full_by_ms; 0 = no schedule.
+  // The limit is lifted at the latest start the learned charge rates allow.
+  int64_t full_by_ms;
+  uint8_t full_target;
+  // With Sailing Mode, top up to 100% when the learned unplug pattern gives
+  // at least this percent chance of an unplug within the time a top-up takes;
+  // 0 = off
+  uint8_t predict_unplug;
+  int32_t utc_offset_s; // local time for the unplug pattern
+  // Least time between two charger writes; only heat protection and Fault
+  // may cut it short
+  int64_t min_dwell_ms;
+} cc_config_t;
+
+#define CC_MAX_MECHANISMS 8
+
+// Turns the charger on or off through one of `mechanisms` ways of doing it
+// (0 .. mechanisms-1, in order of preference until some have a record);
+// returns 0 when the write was accepted. A mechanism the machine does not
+// support should fail the write. Called from cc_step on the caller's thread.
+typedef struct {
+  void *ctx;
+  int mechanisms;
+  int (*set_charging)(void *ctx, int mechanism, int enabled);
+} cc_actuator_t;
+
+// How often a mechanism's inhibit was seen to stop the current, and how often
+// the current kept flowing through it
+typedef struct {
+  uint32_t confirmed;
+  uint32_t refuted;
+} cc_mechanism_t;
+
+typedef struct {
+  cc_state_t state;
+  uint8_t inhibited; // charging is off, as confirmed by the samples
+  uint8_t verifying; // an inhibit was written and is still being checked
+  int8_t mechanism;  // the one holding the charger off (or just refuted,
+                     // with CC_NOTE_INEFFECTIVE); -1 for none
+  uint32_t notices;  // CC_NOTE_* raised by this step
+  int32_t forecast_cc; // temperature forecast_ms ahead at the present load;
+                       // 0 until the model is ready
+  int64_t full_from_ms; // when the scheduled charge starts; 0 without one
+  // With predict_unplug: when an unplug becomes more likely than not within
+  // the next day (0 if it does not), and the chance of one within the time
+  // a top-up would take, in percent
+  int64_t unplug_at_ms;
+  uint8_t unplug_pct;
+} cc_output_t;
+
+typedef struct {
+  int64_t steps;
+  int64_t transitions;
+  int64_t writes;
+  int64_t failures;
+  int64_t deferred; // steps where the dwell held a write back
+  int64_t span_ms;  // sample time covered, for per-hour rates
+} cc_stats_t;
+
+#define CC_FAULT_AFTER 3         // consecutive failed writes
+#define CC_FAULT_RETRY_MS 60000  // between re-enable attempts in Fault
+
+// Verification: charging current above CC_VERIFY_MA means the charger is
+// still on. An inhibit is refuted after CC_VERIFY_SAMPLES such samples in a
+// row spanning CC_VERIFY_MS (the SMC takes a few seconds to ramp down).
+// When every mechanism has been refuted the controller rests in Fault for
+// CC_VERIFY_RETRY_MS before trying them all again.
+#define CC_VERIFY_MA 100
+#define CC_VERIFY_SAMPLES 3
+#define CC_VERIFY_MS 60000
+#define CC_VERIFY_RETRY_MS (30 * 60000)
+
+// A schedule stays on after its deadline until the charger is unplugged, for
+// at most this long
+#define CC_SCHEDULE_GRACE_MS (2 * 3600000)
+
+typedef struct cc cc_t;
+
+cc_t *cc_create(const cc_config_t *config, cc_actuator_t actuator);
+void cc_free(cc_t *cc);
+
+// Takes effect at the next step and lifts the dwell, so a change the user
+// makes is acted on at once. Clearing sailing or travel_until_ms here is
+// how the app acknowledges CC_NOTE_SAILING_AUTO_OFF / TRAVEL_EXPIRED, though
+// the controller has already dropped them from its own copy.
+void cc_configure(cc_t *cc, const cc_config_t *config);
+
+// What the hardware is known to be doing (e.g. CHTE read at launch). The
+// controller otherwise assumes charging is enabled. An assumed inhibit is
+// verified like a written one; not knowing the mechanism, releasing it
+// writes all of them.
+void cc_assume(cc_t *cc, int inhibited);
+
+// Wattage of the connected adapter (0 = none or unknown); the charge rates
+// for the schedule are learned and looked up per adapter
+void cc_set_adapter(cc_t *cc, int32_t adapter_w);
+
+// Teaches the unplug pattern one plugged-in period from history (e.g. the
+// session log at launch); samples teach it from then on
+void cc_learn_session(cc_t *cc, int64_t start_ms, int64_t end_ms);
+
+// The learned unplug pattern, for the app to persist across launches.
+// Setting it restarts the sample stream, so the time the app was not running
+// is not read as plugged in; sessions logged meanwhile go to
+// cc_learn_session.
+void cc_unplug_model(const cc_t *cc, upm_model_t *out);
+void cc_set_unplug_model(cc_t *cc, const upm_model_t *model);
+
+// The learned charge rates, for the app to persist across launches
+void cc_rates(const cc_t *cc, cs_rates_t *out);
+void cc_set_rates(cc_t *cc, const cs_rates_t *rates);
+
+// Mechanisms the machine cannot use for now (bit m for mechanism m), e.g.
+// ones the installed helper does not allow yet. They are neither picked for
+// an inhibit nor written to release one; records are kept.
+void cc_set_unavailable(cc_t *cc, uint32_t mask);
+
+// Per-mechanism records, for the app to persist across launches. Both take
+// and return at most CC_MAX_MECHANISMS entries.
+int cc_mechanisms(const cc_t *cc, cc_mechanism_t *out, int max);
+void cc_set_mechanisms(cc_t *cc, const cc_mechanism_t *records, int count);
+
+// One decision. A NULL sample re-evaluates the last one, for settings
+// changes between samples. Invalid samples change nothing.
+int cc_step(cc_t *cc, const pdev_sample_t *sample, cc_output_t *out);
+
+cc_state_t cc_state(const cc_t *cc);
+const char *cc_state_name(cc_state_t state);
+void cc_stats(const cc_t *cc, cc_stats_t *out);
+
+// Fake charger for tests with CC_MAX_MECHANISMS mechanisms (the actuator
+// offers `mechanisms` of them). It records what each was set to and can be
+// told to fail writes, to reject a mechanism outright, or to accept one that
+// has no effect. cc_fake_inhibited is what a battery would see: whether any
+// effective mechanism is holding the charger off.
+typedef struct cc_fake cc_fake_t;
+cc_fake_t *cc_fake_create(void);
+void cc_fake_fail(cc_fake_t *fake, int writes); // fail the next n writes
+void cc_fake_reject(cc_fake_t *fake, int mechanism);
+void cc_fake_ignore(cc_fake_t *fake, int mechanism);
+int cc_fake_inhibited(const cc_fake_t *fake);
+int64_t cc_fake_writes(const cc_fake_t *fake);
+int cc_fake_actuator(cc_fake_t *fake, int mechanisms, cc_actuator_t *out);
+void cc_fake_destroy(cc_fake_t *fake);
+
+#endif
@@ -0,0 +1,124 @@
+//
+//  charge_schedule.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "charge_schedule.h"
+#include <string.h>
+
+// Share of the bulk rate left in each band once the charger moves to
+// constant voltage; only used for bands without measurements
+static const float k_taper[CS_BANDS] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f,
+                                        1.0f, 1.0f, 0.9f, 0.6f, 0.35f};
+
+#define CS_ALPHA_MIN 0.05f // EWMA floor: about the last 20 samples
+
+static int band_of(int level) {
+  if (level < 0)
+    return 0;
+  return level / 10 < CS_BANDS ? level / 10 : CS_BANDS - 1;
+}
+
+static const cs_adapter_t *find(const cs_rates_t *r, int32_t adapter_w) {
+  const cs_adapter_t *best = NULL;
+  for (int i = 0; i < CS_ADAPTERS; i++) {
+    const cs_adapter_t *a = &r->adapters[i];
+    if (a->adapter_w == 0)
+      continue;
+    if (adapter_w > 0) {
+      if (a->adapter_w == adapter_w)
+        return a;
+    } else if (best == NULL || a->last_ms > best->last_ms) {
+      best = a;
+    }
+  }
+  return best;
+}
+
+// The adapter's slot, taking a free or the least recently used one for a
+// new adapter
+static cs_adapter_t *slot(cs_rates_t *r, int32_t adapter_w) {
+  cs_adapter_t *lru = &r->adapters[0];
+  for (int i = 0; i < CS_ADAPTERS; i++) {
+    cs_adapter_t *a = &r->adapters[i];
+    if (a->adapter_w == adapter_w)
+      return a;
+    if (a->adapter_w == 0 || (lru->adapter_w != 0 && a->last_ms < lru->last_ms))
+      lru = a;
+  }
+  memset(lru, 0, sizeof(*lru));
+  lru->adapter_w = adapter_w;
+  return lru;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void cs_init(cs_rates_t *r) {
+  if (r == NULL)
+    return;
+  memset(r, 0, sizeof(*r));
+  r->version = CS_RATES_VERSION;
+}
+
+void cs_observe(cs_rates_t *r, const pdev_sample_t *s, int32_t adapter_w) {
+  if (r == NULL || s == NULL || !s->valid || !s->plugged || !s->charging ||
+      s->amperage_ma <= 0 || s->max_mah <= 0 || s->level >= 100 ||
+      adapter_w <= 0)
+    return;
+  cs_adapter_t *a = slot(r, adapter_w);
+  int b = band_of(s->level);
+  float pct = (float)s->amperage_ma * 100.0f / (float)s->max_mah;
+  float alpha = 1.0f / (float)(a->samples[b] + 1);
+  if (alpha < CS_ALPHA_MIN)
+    alpha = CS_ALPHA_MIN;
+  a->pct_per_h[b] += alpha * (pct - a->pct_per_h[b]);
+  a->samples[b]++;
+  a->last_ms = s->t_ms;
+}
+
+float cs_rate(const cs_rates_t *r, int32_t adapter_w, int level) {
+  int b = band_of(level);
+  const cs_adapter_t *a = r ? find(r, adapter_w) : NULL;
+  if (a == NULL)
+    return CS_DEFAULT_PCT_PER_H * k_taper[b];
+  if (a->samples[b] > 0 && a->pct_per_h[b] > 0)
+    return a->pct_per_h[b];
+
+  // Bulk rate implied by the bands that were measured
+  float bulk = 0;
+  int seen = 0;
+  for (int j = 0; j < CS_BANDS; j++) {
+    if (a->samples[j] > 0 && a->pct_per_h[j] > 0) {
+      bulk += a->pct_per_h[j] / k_taper[j];
+      seen++;
+    }
+  }
+  if (seen == 0)
+    return CS_DEFAULT_PCT_PER_H * k_taper[b];
+  return bulk / (float)seen * k_taper[b];
+}
+
+int64_t cs_time_to(const cs_rates_t *r, int32_t adapter_w, int level,
+                   int target) {
+  if (target > 100)
+    target = 100;
+  if (level < 0)
+    level = 0;
+  double hours = 0;
+  for (int b = band_of(level); b < CS_BANDS && level < target; b++) {
+    int top = (b + 1) * 10 < target ? (b + 1) * 10 : target;
+    hours += (double)(top - level) / cs_rate(r, adapter_w, level);
+    level = top;
+  }
+  return (int64_t)(hours * 3600000.0);
+}
+
+int64_t cs_latest_start(const cs_rates_t *r, int32_t adapter_w, int level,
+                        int target, int64_t deadline_ms) {
+  int64_t need = cs_time_to(r, adapter_w, level, target);
+  return deadline_ms - need - need * CS_MARGIN_PCT / 100 - CS_MARGIN_MS;
+}
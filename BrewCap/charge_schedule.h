@@ -0,0 +1,63 @@
+//
+//  charge_schedule.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef charge_schedule_h
+#define charge_schedule_h
+
+#include "power_device.h"
+#include <stdint.h>
+
+// Measured charge rates, per adapter and per 10% band of charge, for "full
+// by a given time": from them comes the latest moment charging can start and
+// still make the deadline, so the battery waits at the Sailing limit instead
+// of sitting at 100% for hours.
+//
+// Rates are learned from the battery current while charging. Bands never
+// seen on an adapter (above the limit, usually) are extrapolated from the
+// ones that were, scaled by a constant-voltage taper; with nothing seen at
+// all a conservative default is used, which starts early rather than late.
+
+#define CS_ADAPTERS 8
+#define CS_BANDS 10
+#define CS_DEFAULT_PCT_PER_H 30.0f
+#define CS_RATES_VERSION 1 // changes with the layout of cs_rates_t
+
+typedef struct {
+  int32_t adapter_w; // 0 = free slot
+  int64_t last_ms;   // last sample learned from, for eviction
+  float pct_per_h[CS_BANDS];
+  uint32_t samples[CS_BANDS];
+} cs_adapter_t;
+
+// Plain data: the app persists it as bytes
+typedef struct {
+  int32_t version; // CS_RATES_VERSION, so a saved copy is not misread
+  cs_adapter_t adapters[CS_ADAPTERS];
+} cs_rates_t;
+
+void cs_init(cs_rates_t *r);
+
+// Learns from a sample taken with charge flowing from an adapter of
+// adapter_w watts (0 when unknown: nothing is learned)
+void cs_observe(cs_rates_t *r, const pdev_sample_t *s, int32_t adapter_w);
+
+// Percent per hour in the band holding `level`. adapter_w 0 means the adapter
+// used most recently.
+float cs_rate(const cs_rates_t *r, int32_t adapter_w, int level);
+
+// Time to charge from level to target, in ms
+int64_t cs_time_to(const cs_rates_t *r, int32_t adapter_w, int level,
+                   int target);
+
+// Latest time charging can start and reach target by deadline_ms, with a
+// margin of CS_MARGIN_PCT of the charge time plus CS_MARGIN_MS
+#define CS_MARGIN_PCT 10
+#define CS_MARGIN_MS (10 * 60000)
+int64_t cs_latest_start(const cs_rates_t *r, int32_t adapter_w, int level,
+                        int target, int64_t deadline_ms);
+
+#endif
@@ -0,0 +1,333 @@
+//
+//  csv_export.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "csv_export.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CSVX_BUFFER (1 << 20)
+#define CSVX_FIELD_MAX 64 // widest formatted number or date, with room
+
+// UTC offsets are looked up once per window; zones only change offset on
+// quarter-hour boundaries
+#define ZONE_WINDOW_S 900
+
+struct csvx {
+  int fd;
+  int err;
+  int row_started;
+  size_t len;
+  char path[1024];
+  char tmp[1040];
+  // Local-time cache
+  int64_t zone_start; // UTC seconds; offset valid for one window from here
+  int64_t zone_offset;
+  int64_t day;        // local day number of the cached date prefix
+  char date[10];      // "yyyy-MM-dd"
+  char buf[CSVX_BUFFER];
+};
+
+static void flush(csvx_t *w) {
+  size_t off = 0;
+  while (!w->err && off < w->len) {
+    ssize_t n = write(w->fd, w->buf + off, w->len - off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      fprintf(stderr, "csvx: write failed: %s\n", strerror(errno));
+      w->err = 1;
+      break;
+    }
+    off += (size_t)n;
+  }
+  w->len = 0;
+}
+
+// Room for one field plus its separator
+static char *reserve(csvx_t *w) {
+  if (w->len + CSVX_FIELD_MAX > CSVX_BUFFER)
+    flush(w);
+  if (w->row_started)
+    w->buf[w->len++] = ',';
+  w->row_started = 1;
+  return w->buf + w->len;
+}
+
+// Writes the digits of v backwards from end; returns the first digit
+static char *put_digits(char *end, uint64_t v) {
+  do {
+    *--end = (char)('0' + v % 10);
+    v /= 10;
+  } while (v);
+  return end;
+}
+
+static void put2(char *p, int v) {
+  p[0] = (char)('0' + v / 10);
+  p[1] = (char)('0' + v % 10);
+}
+
+// Days since 1970-01-01 to y/m/d in the proleptic Gregorian calendar
+// (Hinnant's civil_from_days)
+static void civil_from_days(int64_t z, int *y, int *m, int *d) {
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+  *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+  *y = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+static int64_t floor_div(int64_t a, int64_t b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+static int64_t zone_offset(csvx_t *w, int64_t t) {
+  if (t < w->zone_start || t >= w->zone_start + ZONE_WINDOW_S) {
+    w->zone_start = floor_div(t, ZONE_WINDOW_S) * ZONE_WINDOW_S;
+    time_t tt = (time_t)w->zone_start;
+    struct tm tm;
+    w->zone_offset = localtime_r(&tt, &tm) ? tm.tm_gmtoff : 0;
+  }
+  return w->zone_offset;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+csvx_t *csvx_create(const char *path) {
+  csvx_t *w = malloc(sizeof(csvx_t));
+  if (w == NULL)
+    return NULL;
+  memset(w, 0, offsetof(csvx_t, buf));
+  w->zone_start = INT64_MAX;
+  w->day = INT64_MIN;
+  snprintf(w->path, sizeof(w->path), "%s", path);
+  snprintf(w->tmp, sizeof(w->tmp), "%s.tmp", path);
+  w->fd = open(w->tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (w->fd < 0) {
+    fprintf(stderr, "csvx: cannot create %s: %s\n", w->tmp, strerror(errno));
+    free(w);
+    return NULL;
+  }
+  return w;
+}
+
+int csvx_commit(csvx_t *w) {
+  if (w == NULL)
+    return -1;
+  flush(w);
+  if (!w->err && fsync(w->fd) != 0)
+    w->err = 1;
+  close(w->fd);
+  int rc = 0;
+  if (w->err || rename(w->tmp, w->path) != 0) {
+    fprintf(stderr, "csvx: cannot finish %s\n", w->path);
+    unlink(w->tmp);
+    rc = -1;
+  }
+  free(w);
+  return rc;
+}
+
+void csvx_abort(csvx_t *w) {
+  if (w == NULL)
+    return;
+  close(w->fd);
+  unlink(w->tmp);
+  free(w);
+}
+
+void csvx_str(csvx_t *w, const char *s) {
+  size_t n = strlen(s);
+  if (strpbrk(s, ",\"\r\n") == NULL) {
+    if (n > CSVX_FIELD_MAX - 2) {
+      // Long text goes through the buffer in pieces
+      reserve(w);
+      for (size_t i = 0; i < n; i++) {
+        if (w->len == CSVX_BUFFER)
+          flush(w);
+        w->buf[w->len++] = s[i];
+      }
+      return;
+    }
+    memcpy(reserve(w), s, n);
+    w->len += n;
+    return;
+  }
+  reserve(w);
+  for (size_t i = 0; i <= n + 1; i++) {
+    if (w->len + 2 > CSVX_BUFFER)
+      flush(w);
+    if (i == 0 || i == n + 1) {
+      w->buf[w->len++] = '"';
+    } else {
+      if (s[i - 1] == '"')
+        w->buf[w->len++] = '"';
+      w->buf[w->len++] = s[i - 1];
+    }
+  }
+}
+
+void csvx_int(csvx_t *w, int64_t v) {
+  char *p = reserve(w);
+  char tmp[24];
+  char *end = tmp + sizeof(tmp);
+  uint64_t mag = v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+  char *s = put_digits(end, mag);
+  if (v < 0)
+    *--s = '-';
+  size_t n = (size_t)(end - s);
+  memcpy(p, s, n);
+  w->len += n;
+}
+
+void csvx_fixed(csvx_t *w, int64_t v, int decimals) {
+  if (decimals <= 0) {
+    csvx_int(w, v);
+    return;
+  }
+  if (decimals > 18)
+    decimals = 18;
+  char *p = reserve(w);
+  char tmp[48];
+  char *end = tmp + sizeof(tmp);
+  uint64_t mag = v < 0 ? (uint64_t)0 - (uint64_t)v : (uint64_t)v;
+  char *s = end;
+  for (int i = 0; i < decimals; i++) {
+    *--s = (char)('0' + mag % 10);
+    mag /= 10;
+  }
+  *--s = '.';
+  s = put_digits(s, mag);
+  if (v < 0)
+    *--s = '-';
+  size_t n = (size_t)(end - s);
+  memcpy(p, s, n);
+  w->len += n;
+}
+
+void csvx_time(csvx_t *w, int64_t t_ms, int seconds) {
+  char *p = reserve(w);
+  int64_t t = floor_div(t_ms, 1000);
+  int64_t local = t + zone_offset(w, t);
+  int64_t day = floor_div(local, 86400);
+  int64_t sod = local - day * 86400;
+  if (day != w->day) {
+    int y, m, d;
+    civil_from_days(day, &y, &m, &d);
+    y = y < 0 ? 0 : y > 9999 ? 9999 : y;
+    put2(w->date, y / 100);
+    put2(w->date + 2, y % 100);
+    w->date[4] = '-';
+    put2(w->date + 5, m);
+    w->date[7] = '-';
+    put2(w->date + 8, d);
+    w->day = day;
+  }
+  memcpy(p, w->date, 10);
+  p[10] = ' ';
+  put2(p + 11, (int)(sod / 3600));
+  p[13] = ':';
+  put2(p + 14, (int)(sod / 60 % 60));
+  size_t n = 16;
+  if (seconds) {
+    p[16] = ':';
+    put2(p + 17, (int)(sod % 60));
+    n = 19;
+  }
+  w->len += n;
+}
+
+void csvx_end_row(csvx_t *w) {
+  if (w->len + 1 > CSVX_BUFFER)
+    flush(w);
+  w->buf[w->len++] = '\n';
+  w->row_started = 0;
+}
+
+// ============================================================
+// Exports
+// ============================================================
+
+static void header(csvx_t *w, const char *const *names, size_t n) {
+  for (size_t i = 0; i < n; i++)
+    csvx_str(w, names[i]);
+  csvx_end_row(w);
+}
+
+int64_t csvx_export_sessions(slog_t *log, const char *path) {
+  static const char *const cols[] = {"Date",           "Start Level",
+                                     "End Level",      "Delta",
+                                     "Duration (min)", "Adapter Watts"};
+  csvx_t *w = csvx_create(path);
+  if (w == NULL)
+    return -1;
+  header(w, cols, sizeof(cols) / sizeof(cols[0]));
+  // Newest first, matching the history list
+  int64_t rows = 0;
+  for (size_t i = slog_count(log); i-- > 0;) {
+    slog_record_t r;
+    if (slog_read(log, i, &r) != 0)
+      continue;
+    csvx_time(w, r.start_ms, 0);
+    csvx_int(w, r.start_level);
+    csvx_int(w, r.end_level);
+    csvx_int(w, r.end_level - r.start_level);
+    csvx_int(w, r.duration_min);
+    csvx_int(w, r.adapter_watts);
+    csvx_end_row(w);
+    rows++;
+  }
+  return csvx_commit(w) == 0 ? rows : -1;
+}
+
+static int telemetry_rows(const pdev_sample_t *batch, size_t n, void *ctx) {
+  csvx_t *w = ctx;
+  for (size_t i = 0; i < n; i++) {
+    const pdev_sample_t *s = &batch[i];
+    csvx_time(w, s->t_ms, 1);
+    csvx_int(w, s->level);
+    csvx_int(w, s->amperage_ma);
+    csvx_fixed(w, s->voltage_mv, 3);
+    csvx_fixed(w, s->temp_cc, 2);
+    float cw = s->power_w * 100.0f;
+    csvx_fixed(w, (int64_t)(cw < 0 ? cw - 0.5f : cw + 0.5f), 2);
+    csvx_int(w, s->plugged);
+    csvx_int(w, s->charging);
+    csvx_end_row(w);
+  }
+  return w->err;
+}
+
+int64_t csvx_export_telemetry(ts_store_t *store, int64_t from_ms,
+                              int64_t to_ms, const char *path) {
+  static const char *const cols[] = {
+      "Time",        "Level",           "Amperage (mA)", "Voltage (V)",
+      "Temperature (C)", "Power (W)",   "Plugged",       "Charging"};
+  csvx_t *w = csvx_create(path);
+  if (w == NULL)
+    return -1;
+  header(w, cols, sizeof(cols) / sizeof(cols[0]));
+  int64_t rows = ts_scan(store, from_ms, to_ms, TS_ALL_COLUMNS,
+                         telemetry_rows, w);
+  if (rows < 0) {
+    csvx_abort(w);
+    return -1;
+  }
+  return csvx_commit(w) == 0 ? rows : -1;
+}
@@ -0,0 +1,44 @@
+//
+//  csv_export.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef csv_export_h
+#define csv_export_h
+
+#include "session_log.h"
+#include "telemetry_store.h"
+#include <stdint.h>
+
+// Streaming CSV export. Records are pulled from the stores a batch at a
+// time and formatted straight into a fixed 1 MB output buffer with
+// hand-rolled number and date formatting, so memory use does not grow with
+// the history and no per-field printf or formatter object is involved.
+//
+// Output goes to path.tmp and is renamed over path once complete.
+
+typedef struct csvx csvx_t;
+
+csvx_t *csvx_create(const char *path);
+// Flushes, syncs and renames into place; frees the writer either way
+int csvx_commit(csvx_t *w);
+// Discards the partial file
+void csvx_abort(csvx_t *w);
+
+// Fields are separated automatically; csvx_end_row starts the next line
+void csvx_str(csvx_t *w, const char *s); // quoted only if it needs to be
+void csvx_int(csvx_t *w, int64_t v);
+// v / 10^decimals with exactly that many decimals, e.g. (12345, 3) = 12.345
+void csvx_fixed(csvx_t *w, int64_t v, int decimals);
+// Local time as yyyy-MM-dd HH:mm, with :ss appended if seconds is set
+void csvx_time(csvx_t *w, int64_t t_ms, int seconds);
+void csvx_end_row(csvx_t *w);
+
+// Whole-file exports; return the number of data rows written or -1
+int64_t csvx_export_sessions(slog_t *log, const char *path);
+int64_t csvx_export_telemetry(ts_store_t *store, int64_t from_ms,
+                              int64_t to_ms, const char *path);
+
+#endif
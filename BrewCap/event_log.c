@@ -0,0 +1,254 @@
+//
+//  event_log.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "event_log.h"
+#include "store_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout: 16-byte header, then capacity slots. Strings live in a
+// sibling "<path>.strings" file of NUL-terminated entries; an id is the
+// entry's byte offset.
+#define ELOG_MAGIC 0x4C454342u // "BCEL" little-endian
+#define ELOG_VERSION 1u
+#define ELOG_HEADER 16
+
+_Static_assert(sizeof(elog_record_t) == 20, "elog_record_t layout changed");
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t capacity;
+} elog_header_t;
+
+struct elog {
+  int fd;
+  uint8_t *map;
+  size_t map_len;
+  uint32_t capacity;
+  uint32_t head; // next slot to write
+  uint32_t count;
+  uint16_t seq; // of the next record
+  // Interned strings
+  int strings_fd;
+  char *strings;
+  size_t strings_len;
+};
+
+static elog_record_t *slot(const elog_t *log, uint32_t i) {
+  return (elog_record_t *)(log->map + ELOG_HEADER) + i;
+}
+
+// The newest record is the one whose successor is empty or out of sequence.
+// capacity is never a multiple of 65536, so a full ring has exactly one
+// such break.
+static void find_head(elog_t *log) {
+  uint32_t newest = UINT32_MAX;
+  log->count = 0;
+  for (uint32_t i = 0; i < log->capacity; i++) {
+    const elog_record_t *r = slot(log, i);
+    if (r->code == EV_NONE)
+      continue;
+    log->count++;
+    const elog_record_t *next = slot(log, (i + 1) % log->capacity);
+    if (newest == UINT32_MAX &&
+        (next->code == EV_NONE || next->seq != (uint16_t)(r->seq + 1)))
+      newest = i;
+  }
+  if (newest == UINT32_MAX) {
+    log->head = 0;
+    log->seq = 1;
+  } else {
+    log->head = (newest + 1) % log->capacity;
+    log->seq = (uint16_t)(slot(log, newest)->seq + 1);
+  }
+}
+
+static int load_strings(elog_t *log, const char *path) {
+  char spath[1024];
+  snprintf(spath, sizeof(spath), "%s.strings", path);
+  log->strings_fd = open(spath, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (log->strings_fd < 0)
+    return -1;
+  struct stat st;
+  if (fstat(log->strings_fd, &st) != 0)
+    return -1;
+  log->strings_len = (size_t)st.st_size;
+  log->strings = malloc(log->strings_len + 1);
+  if (log->strings == NULL)
+    return -1;
+  if (log->strings_len > 0 &&
+      store_pread_all(log->strings_fd, log->strings, log->strings_len, 0) != 0)
+    return -1;
+  log->strings[log->strings_len] = '\0';
+  return 0;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+elog_t *elog_open(const char *path, uint32_t capacity) {
+  if (capacity == 0 || capacity % 65536 == 0)
+    return NULL;
+  elog_t *log = calloc(1, sizeof(elog_t));
+  if (log == NULL)
+    return NULL;
+  log->strings_fd = -1;
+  log->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (log->fd < 0) {
+    fprintf(stderr, "elog: cannot open %s: %s\n", path, strerror(errno));
+    free(log);
+    return NULL;
+  }
+
+  struct stat st;
+  elog_header_t hdr;
+  if (fstat(log->fd, &st) != 0)
+    goto fail;
+  if (st.st_size < ELOG_HEADER) {
+    hdr = (elog_header_t){ELOG_MAGIC, ELOG_VERSION, sizeof(elog_record_t),
+                          capacity};
+    if (ftruncate(log->fd,
+                  (off_t)(ELOG_HEADER + capacity * sizeof(elog_record_t))) !=
+            0 ||
+        pwrite(log->fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+      goto fail;
+  } else if (store_pread_all(log->fd, &hdr, sizeof(hdr), 0) != 0 ||
+             hdr.magic != ELOG_MAGIC ||
+             hdr.record_size != sizeof(elog_record_t) ||
+             (size_t)st.st_size <
+                 ELOG_HEADER + hdr.capacity * sizeof(elog_record_t)) {
+    fprintf(stderr, "elog: %s is not an event log\n", path);
+    goto fail;
+  }
+  // An existing file keeps the capacity it was created with
+  log->capacity = hdr.capacity;
+  log->map_len = ELOG_HEADER + log->capacity * sizeof(elog_record_t);
+  void *m = mmap(NULL, log->map_len, PROT_READ | PROT_WRITE, MAP_SHARED,
+                 log->fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr, "elog: mmap failed: %s\n", strerror(errno));
+    goto fail;
+  }
+  log->map = m;
+  find_head(log);
+  if (load_strings(log, path) != 0) {
+    fprintf(stderr, "elog: cannot load strings for %s\n", path);
+    goto fail;
+  }
+  return log;
+
+fail:
+  elog_close(log);
+  return NULL;
+}
+
+void elog_close(elog_t *log) {
+  if (log == NULL)
+    return;
+  if (log->map)
+    munmap(log->map, log->map_len);
+  if (log->fd >= 0)
+    close(log->fd);
+  if (log->strings_fd >= 0)
+    close(log->strings_fd);
+  free(log->strings);
+  free(log);
+}
+
+int elog_append(elog_t *log, double timestamp, int code, int32_t a0,
+                int32_t a1, int32_t a2) {
+  if (log == NULL || code <= EV_NONE || code > UINT16_MAX)
+    return -1;
+  elog_record_t rec = {(uint32_t)timestamp, (uint16_t)code, log->seq,
+                       {a0, a1, a2}};
+  memcpy(slot(log, log->head), &rec, sizeof(rec));
+  log->head = (log->head + 1) % log->capacity;
+  log->seq++;
+  if (log->count < log->capacity)
+    log->count++;
+  return 0;
+}
+
+size_t elog_count(const elog_t *log) { return log ? log->count : 0; }
+
+int elog_get(const elog_t *log, size_t index, elog_record_t *out) {
+  if (log == NULL || out == NULL || index >= log->count)
+    return -1;
+  uint32_t i =
+      (uint32_t)((log->head + log->capacity - 1 - index) % log->capacity);
+  memcpy(out, slot(log, i), sizeof(*out));
+  return 0;
+}
+
+int elog_clear(elog_t *log) {
+  if (log == NULL)
+    return -1;
+  memset(log->map + ELOG_HEADER, 0, log->capacity * sizeof(elog_record_t));
+  log->head = 0;
+  log->count = 0;
+  log->seq = 1;
+  return 0;
+}
+
+size_t elog_expire(elog_t *log, double before) {
+  if (log == NULL)
+    return 0;
+  size_t dropped = 0;
+  // Oldest first; once one is recent enough, so is everything newer
+  while (log->count > 0) {
+    uint32_t i = (log->head + log->capacity - log->count) % log->capacity;
+    elog_record_t *r = slot(log, i);
+    if ((double)r->t_s >= before)
+      break;
+    memset(r, 0, sizeof(*r));
+    log->count--;
+    dropped++;
+  }
+  return dropped;
+}
+
+int32_t elog_intern(elog_t *log, const char *text) {
+  if (log == NULL || text == NULL)
+    return -1;
+  size_t len = strlen(text);
+  for (size_t off = 0; off < log->strings_len;) {
+    size_t n = strlen(log->strings + off);
+    if (n == len && memcmp(log->strings + off, text, len) == 0)
+      return (int32_t)off;
+    off += n + 1;
+  }
+  if (log->strings_len + len + 1 > INT32_MAX)
+    return -1;
+  char *grown = realloc(log->strings, log->strings_len + len + 2);
+  if (grown == NULL)
+    return -1;
+  log->strings = grown;
+  if (store_write_all(log->strings_fd, text, len + 1) != 0)
+    return -1;
+  int32_t id = (int32_t)log->strings_len;
+  memcpy(log->strings + log->strings_len, text, len + 1);
+  log->strings_len += len + 1;
+  log->strings[log->strings_len] = '\0';
+  return id;
+}
+
+int elog_string(const elog_t *log, int32_t id, char *buf, size_t size) {
+  if (log == NULL || buf == NULL || size == 0 || id < 0 ||
+      (size_t)id >= log->strings_len)
+    return -1;
+  snprintf(buf, size, "%s", log->strings + id);
+  return 0;
+}
@@ -0,0 +1,79 @@
+//
+//  event_log.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef event_log_h
+#define event_log_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Event codes. The message templates live with the renderer; a record only
+// carries the code and its numeric arguments.
+typedef enum {
+  EV_NONE = 0, // empty slot
+  EV_TEXT,     // free-form text: a0 = interned string id
+  EV_LAUNCHED,
+  EV_QUIT,
+  EV_CHARGER_CONNECTED,    // a0 = level
+  EV_CHARGER_DISCONNECTED, // a0 = level
+  EV_SAILING_AUTO_OFF,
+  EV_PRESET_SET,  // a0 = percent
+  EV_TEMP_ALERT,  // a0 = centi-degrees C
+  EV_LOW_BATTERY, // a0 = level
+  EV_FULLY_CHARGED,
+  EV_CRITICAL_TEMP, // a0 = centi-degrees C
+  EV_WOKE, // a0 = seconds asleep, a1 = start level << 8 | end level, a2 = mWh
+  EV_SETTINGS_RESET,
+  EV_CHARGING_PAUSED, // a0 = level
+  EV_STATS_COPIED,
+  EV_SETTINGS_IMPORTED,
+  EV_TRAVEL_ON,  // a0 = hours
+  EV_TRAVEL_OFF, // a0 = restored limit
+  EV_CSV_EXPORTED,
+  EV_SETTINGS_EXPORTED,
+  EV_THERMAL_HOLD, // a0 = centi-degrees C
+  EV_CHARGE_CONTROL_FAULT,
+  EV_CHARGE_CONTROL_RECOVERED,
+  EV_CHARGE_MECHANISM_INEFFECTIVE, // a0 = smc_charge_method_t
+  EV_FULL_BY_DONE,                 // a0 = level at the deadline
+} elog_code_t;
+
+typedef struct {
+  uint32_t t_s; // seconds since 1970
+  uint16_t code;
+  uint16_t seq; // consecutive per append; finds the ring head on open
+  int32_t args[3];
+} elog_record_t;
+
+typedef struct elog elog_t;
+
+// Opens the ring at path, preallocating capacity slots on first use. The
+// file never grows: once full, each append overwrites the oldest record.
+elog_t *elog_open(const char *path, uint32_t capacity);
+void elog_close(elog_t *log);
+
+// Constant time: one 20-byte store into the mapped file
+int elog_append(elog_t *log, double timestamp, int code, int32_t a0,
+                int32_t a1, int32_t a2);
+
+size_t elog_count(const elog_t *log);
+
+// index 0 is the newest record
+int elog_get(const elog_t *log, size_t index, elog_record_t *out);
+
+int elog_clear(elog_t *log);
+
+// Empties the slots of records older than before (seconds since 1970);
+// returns how many were dropped
+size_t elog_expire(elog_t *log, double before);
+
+// Free-form text goes to a side table of unique strings; records refer to
+// it by id. Returns the id, or -1.
+int32_t elog_intern(elog_t *log, const char *text);
+int elog_string(const elog_t *log, int32_t id, char *buf, size_t size);
+
+#endif
@@ -0,0 +1,195 @@
+//
+//  float_codec.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "float_codec.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Control bits after the first value (stored raw in 64 bits):
+//   0                      same value as before
+//   1 0 <bits>             XOR fits the previous lead/trail window
+//   1 1 <5: lead> <6: len-1> <bits>   new window
+
+static uint64_t to_bits(double v) {
+  uint64_t b;
+  memcpy(&b, &v, sizeof(b));
+  return b;
+}
+
+static double from_bits(uint64_t b) {
+  double v;
+  memcpy(&v, &b, sizeof(v));
+  return v;
+}
+
+static int clz64(uint64_t v) { return v ? __builtin_clzll(v) : 64; }
+static int ctz64(uint64_t v) { return v ? __builtin_ctzll(v) : 64; }
+
+// ============================================================
+// Encoder
+// ============================================================
+
+void fxor_encoder_init(fxor_encoder_t *enc) {
+  memset(enc, 0, sizeof(*enc));
+  enc->lead = -1;
+}
+
+void fxor_encoder_reset(fxor_encoder_t *enc) {
+  if (enc->buf)
+    memset(enc->buf, 0, (enc->nbits + 7) / 8);
+  enc->nbits = 0;
+  enc->count = 0;
+  enc->prev = 0;
+  enc->lead = -1;
+  enc->trail = 0;
+}
+
+void fxor_encoder_free(fxor_encoder_t *enc) {
+  free(enc->buf);
+  fxor_encoder_init(enc);
+}
+
+// Appends the low n bits of v, most significant first
+static void put_bits(fxor_encoder_t *enc, uint64_t v, int n) {
+  while (n > 0) {
+    size_t byte = enc->nbits >> 3;
+    int used = (int)(enc->nbits & 7);
+    int take = 8 - used < n ? 8 - used : n;
+    uint8_t chunk = (uint8_t)((v >> (n - take)) & ((1u << take) - 1));
+    enc->buf[byte] |= (uint8_t)(chunk << (8 - used - take));
+    enc->nbits += (size_t)take;
+    n -= take;
+  }
+}
+
+int fxor_append(fxor_encoder_t *enc, double value) {
+  // Worst case is 2 + 5 + 6 + 64 bits
+  size_t need = (enc->nbits + 77 + 7) / 8;
+  if (need > enc->cap) {
+    size_t cap = enc->cap ? enc->cap * 2 : 256;
+    while (cap < need)
+      cap *= 2;
+    uint8_t *b = realloc(enc->buf, cap);
+    if (b == NULL)
+      return -1;
+    memset(b + enc->cap, 0, cap - enc->cap);
+    enc->buf = b;
+    enc->cap = cap;
+  }
+
+  uint64_t bits = to_bits(value);
+  if (enc->count == 0) {
+    put_bits(enc, bits, 64);
+  } else {
+    uint64_t x = bits ^ enc->prev;
+    if (x == 0) {
+      put_bits(enc, 0, 1);
+    } else {
+      int lead = clz64(x), trail = ctz64(x);
+      if (lead > 31)
+        lead = 31; // 5-bit field
+      if (enc->lead >= 0 && lead >= enc->lead && trail >= enc->trail) {
+        put_bits(enc, 2, 2);
+        put_bits(enc, x >> enc->trail, 64 - enc->lead - enc->trail);
+      } else {
+        int len = 64 - lead - trail;
+        put_bits(enc, 3, 2);
+        put_bits(enc, (uint64_t)lead, 5);
+        put_bits(enc, (uint64_t)(len - 1), 6);
+        put_bits(enc, x >> trail, len);
+        enc->lead = lead;
+        enc->trail = trail;
+      }
+    }
+  }
+  enc->prev = bits;
+  enc->count++;
+  return 0;
+}
+
+size_t fxor_bytes(const fxor_encoder_t *enc) { return (enc->nbits + 7) / 8; }
+
+// ============================================================
+// Decoder
+// ============================================================
+
+void fxor_decoder_init(fxor_decoder_t *dec, const uint8_t *buf, size_t len,
+                       size_t count) {
+  memset(dec, 0, sizeof(*dec));
+  dec->buf = buf;
+  dec->nbits = len * 8;
+  dec->remaining = count;
+}
+
+// Reads up to 57 bits with one unaligned big-endian load when at least
+// eight bytes remain; falls back to byte steps at the tail of the block
+static uint64_t peek_word(const fxor_decoder_t *dec) {
+  const uint8_t *p = dec->buf + (dec->pos >> 3);
+  uint64_t w = 0;
+  for (int i = 0; i < 8; i++)
+    w = (w << 8) | p[i];
+  return w << (dec->pos & 7);
+}
+
+static int get_bits(fxor_decoder_t *dec, int n, uint64_t *out) {
+  if (dec->pos + (size_t)n > dec->nbits)
+    return -1;
+  if (n <= 57 && (dec->pos >> 3) + 8 <= dec->nbits >> 3) {
+    *out = peek_word(dec) >> (64 - n);
+    dec->pos += (size_t)n;
+    return 0;
+  }
+  uint64_t v = 0;
+  while (n > 0) {
+    size_t byte = dec->pos >> 3;
+    int used = (int)(dec->pos & 7);
+    int take = 8 - used < n ? 8 - used : n;
+    uint8_t chunk =
+        (uint8_t)((dec->buf[byte] >> (8 - used - take)) & ((1u << take) - 1));
+    v = (v << take) | chunk;
+    dec->pos += (size_t)take;
+    n -= take;
+  }
+  *out = v;
+  return 0;
+}
+
+int fxor_next(fxor_decoder_t *dec, double *out) {
+  if (dec->remaining == 0)
+    return -1;
+  uint64_t v;
+  if (!dec->started) {
+    if (get_bits(dec, 64, &v) != 0)
+      return -1;
+    dec->prev = v;
+    dec->started = 1;
+  } else {
+    uint64_t ctl;
+    if (get_bits(dec, 1, &ctl) != 0)
+      return -1;
+    if (ctl) {
+      if (get_bits(dec, 1, &ctl) != 0)
+        return -1;
+      if (ctl) {
+        uint64_t lead, len;
+        if (get_bits(dec, 5, &lead) != 0 || get_bits(dec, 6, &len) != 0)
+          return -1;
+        dec->lead = (int)lead;
+        dec->trail = 64 - (int)lead - (int)len - 1;
+        if (dec->trail < 0)
+          return -1;
+      }
+      int len = 64 - dec->lead - dec->trail;
+      if (len <= 0 || get_bits(dec, len, &v) != 0)
+        return -1;
+      dec->prev ^= v << dec->trail;
+    }
+  }
+  dec->remaining--;
+  *out = from_bits(dec->prev);
+  return 0;
+}
@@ -0,0 +1,58 @@
+//
+//  float_codec.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef float_codec_h
+#define float_codec_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Gorilla-style XOR compression for slowly changing double series (watts,
+// voltage, temperature). Each value is XORed with its predecessor: an
+// unchanged value costs one bit, and a change that fits the previous
+// leading/trailing-zero window costs two bits plus its meaningful bits.
+
+typedef struct {
+  uint8_t *buf;
+  size_t cap;
+  size_t nbits;
+  size_t count;
+  uint64_t prev;
+  int lead; // previous window; lead < 0 until a window exists
+  int trail;
+} fxor_encoder_t;
+
+void fxor_encoder_init(fxor_encoder_t *enc);
+void fxor_encoder_reset(fxor_encoder_t *enc); // keeps the buffer
+void fxor_encoder_free(fxor_encoder_t *enc);
+
+// O(1) amortised; -1 only if the buffer cannot grow
+int fxor_append(fxor_encoder_t *enc, double value);
+
+// Encoded size in whole bytes (the last byte is zero-padded)
+size_t fxor_bytes(const fxor_encoder_t *enc);
+
+// Streams values out of an encoded block without materialising it. count is
+// the number of values the block holds (the padding is not self-describing).
+typedef struct {
+  const uint8_t *buf;
+  size_t nbits;
+  size_t pos;
+  size_t remaining;
+  uint64_t prev;
+  int lead;
+  int trail;
+  int started;
+} fxor_decoder_t;
+
+void fxor_decoder_init(fxor_decoder_t *dec, const uint8_t *buf, size_t len,
+                       size_t count);
+
+// 0 and the next value, or -1 at the end of the block or on corruption
+int fxor_next(fxor_decoder_t *dec, double *out);
+
+#endif
@@ -0,0 +1,212 @@
+//
+//  policy_sim.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "policy_sim.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PSIM_MAX_THREADS 64
+
+static void accumulate(psim_result_t *out, double level, int32_t temp_cc,
+                       double hours) {
+  out->hours += hours;
+  out->mean_level += level * hours; // divided by hours at the end
+  if (level >= PSIM_HIGH_LEVEL)
+    out->hours_high += hours;
+  if (level >= 100.0)
+    out->hours_full += hours;
+  if (level < PSIM_LOW_LEVEL)
+    out->hours_low += hours;
+  if (temp_cc > PSIM_HOT_CC) {
+    out->hours_hot += hours;
+    out->degree_hours += (temp_cc - PSIM_HOT_CC) / 100.0 * hours;
+  }
+}
+
+static double clamp_level(double level) {
+  return level < 0 ? 0 : level > 100 ? 100 : level;
+}
+
+// Asleep on AC nothing steps the controller, so a charger it left on fills
+// the battery at the learned rates, a minute at a time
+static double charge_asleep(const cs_rates_t *rates, int32_t adapter_w,
+                            double level, int64_t dt) {
+  for (int64_t t = 0; t < dt && level < 100; t += 60000) {
+    int64_t step = dt - t < 60000 ? dt - t : 60000;
+    double rate = cs_rate(rates, adapter_w, (int)level);
+    if (rate <= 0)
+      break;
+    level = clamp_level(level + rate * step / 3600000.0);
+  }
+  return level;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+int psim_run(const psim_trace_t *trace, const cc_config_t *policy,
+             psim_result_t *out) {
+  if (out == NULL)
+    return -1;
+  memset(out, 0, sizeof(*out));
+  if (trace == NULL || trace->samples == NULL || trace->count == 0 ||
+      trace->capacity_mah <= 0 || policy == NULL)
+    return -1;
+  const pdev_sample_t *samples = trace->samples;
+  double cap = trace->capacity_mah;
+
+  // Charge rates as the recording shows them
+  cs_rates_t rates;
+  cs_init(&rates);
+  for (size_t i = 0; i < trace->count; i++) {
+    pdev_sample_t s = samples[i];
+    s.max_mah = trace->capacity_mah;
+    s.valid = 1;
+    cs_observe(&rates, &s, trace->adapter_w);
+  }
+
+  cc_fake_t *fake = cc_fake_create();
+  cc_actuator_t actuator;
+  if (fake == NULL || cc_fake_actuator(fake, 1, &actuator) != 0) {
+    cc_fake_destroy(fake);
+    return -1;
+  }
+  cc_config_t config = *policy;
+  config.armed = 1;
+  cc_t *cc = cc_create(&config, actuator);
+  if (cc == NULL) {
+    cc_fake_destroy(fake);
+    return -1;
+  }
+  cc_set_rates(cc, &rates);
+  cc_set_adapter(cc, trace->adapter_w);
+
+  double level = samples[0].level;
+  double heat = 0; // degrees C the simulated charging adds to the recording
+  int32_t ma = 0;  // simulated battery current until the next sample
+  out->min_level = 100;
+  out->max_temp = -100;
+  for (size_t i = 0; i < trace->count; i++) {
+    const pdev_sample_t *r = &samples[i];
+    int32_t temp_cc = r->temp_cc ? r->temp_cc + (int32_t)lround(heat * 100) : 0;
+    if (i > 0) {
+      const pdev_sample_t *p = &samples[i - 1];
+      int64_t dt = r->t_ms > p->t_ms ? r->t_ms - p->t_ms : 0;
+      double hours = dt / 3600000.0;
+      if (dt > PSIM_MAX_GAP_MS) {
+        // Asleep: a battery drains the same under any policy; on AC the
+        // charger stays on or held off as the last step left it
+        if (!p->plugged) {
+          level = clamp_level(level + (r->level - p->level));
+        } else if (ma > 0) {
+          double before = level;
+          level = charge_asleep(&rates, trace->adapter_w, level, dt);
+          out->cycles += (level - before) / 100.0;
+        }
+        // Neither battery's current is known; the difference cools off
+        heat *= exp(-hours * 60.0 / PSIM_HEAT_TAU_MIN);
+      } else {
+        double delta = ma * hours * 100.0 / cap;
+        if (delta > 0)
+          out->cycles += delta / 100.0;
+        level = clamp_level(level + delta);
+        // Joule heating the recording did not have, or had and we do not
+        double rec = p->amperage_ma > 0 ? p->amperage_ma / 1000.0 : 0;
+        double sim = ma > 0 ? ma / 1000.0 : 0;
+        double target = PSIM_HEAT_C_PER_A2 * (sim * sim - rec * rec);
+        heat += (target - heat) * (1.0 - exp(-hours * 60.0 / PSIM_HEAT_TAU_MIN));
+      }
+      accumulate(out, level, temp_cc, hours);
+    }
+    if (level < out->min_level)
+      out->min_level = (int)level;
+    if (temp_cc && temp_cc / 100.0 > out->max_temp)
+      out->max_temp = temp_cc / 100.0;
+
+    pdev_sample_t s = *r;
+    s.valid = 1;
+    s.level = (int32_t)lround(level);
+    s.max_mah = trace->capacity_mah;
+    s.temp_cc = temp_cc;
+    s.charging = ma > 0;
+    s.amperage_ma = ma;
+    cc_output_t o;
+    cc_step(cc, &s, &o);
+
+    if (!r->plugged)
+      ma = r->amperage_ma < 0 ? r->amperage_ma : 0;
+    else if (!cc_fake_inhibited(fake) && level < 100)
+      ma = (int32_t)lround(cs_rate(&rates, trace->adapter_w, (int)level) *
+                           cap / 100.0);
+    else
+      ma = 0; // the system runs off the adapter
+  }
+  if (out->hours > 0)
+    out->mean_level /= out->hours;
+
+  cc_stats_t stats;
+  cc_stats(cc, &stats);
+  out->writes = stats.writes;
+  out->transitions = stats.transitions;
+  cc_free(cc);
+  cc_fake_destroy(fake);
+  return 0;
+}
+
+typedef struct {
+  const psim_trace_t *trace;
+  const cc_config_t *policies;
+  psim_result_t *results;
+  int n;
+  atomic_int next;
+  atomic_int ran;
+} psim_jobs_t;
+
+static void *worker(void *arg) {
+  psim_jobs_t *jobs = arg;
+  int i;
+  while ((i = atomic_fetch_add(&jobs->next, 1)) < jobs->n) {
+    if (psim_run(jobs->trace, &jobs->policies[i], &jobs->results[i]) == 0)
+      atomic_fetch_add(&jobs->ran, 1);
+  }
+  return NULL;
+}
+
+int psim_run_many(const psim_trace_t *trace, const cc_config_t *policies,
+                  psim_result_t *results, int n, int threads) {
+  if (policies == NULL || results == NULL || n <= 0)
+    return 0;
+  if (threads <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores > 0 ? (int)cores : 1;
+  }
+  if (threads > n)
+    threads = n;
+  if (threads > PSIM_MAX_THREADS)
+    threads = PSIM_MAX_THREADS;
+
+  psim_jobs_t jobs = {.trace = trace, .policies = policies,
+                      .results = results, .n = n};
+  atomic_init(&jobs.next, 0);
+  atomic_init(&jobs.ran, 0);
+  // The calling thread is one of the workers
+  pthread_t tids[PSIM_MAX_THREADS];
+  int started = 0;
+  for (int t = 1; t < threads; t++) {
+    if (pthread_create(&tids[started], NULL, worker, &jobs) == 0)
+      started++;
+  }
+  worker(&jobs);
+  for (int t = 0; t < started; t++)
+    pthread_join(tids[t], NULL);
+  return atomic_load(&jobs.ran);
+}
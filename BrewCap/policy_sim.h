@@ -0,0 +1,70 @@
+//
+//  policy_sim.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef policy_sim_h
+#define policy_sim_h
+
+#include "charge_control.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Replays a recorded battery trace through charge control under other
+// policies, to compare limits, hysteresis and heat rules on real usage.
+//
+// The trace supplies what the policy does not change: when the charger was
+// connected, the discharge current while unplugged, the system draw and the
+// temperature. The battery level is re-simulated, charging at the rates
+// learned from the trace itself (charge_schedule.h) whenever the controller
+// leaves the charger on. Where the simulated battery charges and the
+// recorded one did not (or the other way round), the temperature is
+// corrected by Joule heating through a first-order lag. Each step is a
+// cc_step and a few multiplications, so a month of 10 s samples replays in
+// tens of milliseconds.
+
+typedef struct {
+  const pdev_sample_t *samples; // oldest first; telemetry store columns
+  size_t count;
+  int32_t capacity_mah; // full charge capacity, to turn current into percent
+  int32_t adapter_w;    // for the learned rates; any constant works
+} psim_trace_t;
+
+#define PSIM_HIGH_LEVEL 90    // "time at high state of charge" threshold
+#define PSIM_LOW_LEVEL 10
+#define PSIM_HOT_CC 3500      // thermal exposure above this
+#define PSIM_HEAT_C_PER_A2 1.5 // steady-state rise per A^2 of charge current
+#define PSIM_HEAT_TAU_MIN 20.0
+#define PSIM_MAX_GAP_MS 600000 // longer gaps are sleep: unplugged the level
+                               // follows the recording; on AC the charger
+                               // stays as the controller left it
+
+typedef struct {
+  double hours;        // trace time covered
+  double hours_high;   // at or above PSIM_HIGH_LEVEL
+  double hours_full;   // at 100%
+  double hours_low;    // below PSIM_LOW_LEVEL
+  double mean_level;   // time-weighted
+  double cycles;       // equivalent full cycles: charge put in / 100%
+  double hours_hot;    // above PSIM_HOT_CC
+  double degree_hours; // degree C hours above PSIM_HOT_CC
+  double max_temp;     // degrees C
+  int64_t writes;      // charger (SMC) writes
+  int64_t transitions;
+  int min_level;
+} psim_result_t;
+
+// One policy over the trace; `armed` is forced on. Returns 0, or -1 for an
+// empty trace or no capacity.
+int psim_run(const psim_trace_t *trace, const cc_config_t *policy,
+             psim_result_t *out);
+
+// n policies, spread over `threads` worker threads (0 = one per core). The
+// trace is shared read-only; each policy gets its own controller. Returns
+// the number of policies that ran.
+int psim_run_many(const psim_trace_t *trace, const cc_config_t *policies,
+                  psim_result_t *results, int n, int threads);
+
+#endif
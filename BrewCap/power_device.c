@@ -0,0 +1,683 @@
+//
+//  power_device.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "power_device.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/IOKitLib.h>
+#include <IOKit/ps/IOPSKeys.h>
+#include <IOKit/ps/IOPowerSources.h>
+#endif
+
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+struct pdev_set {
+  pdev_backend_t backend;
+  pdev_info_t info[PDEV_MAX];
+  int count;
+  // Per-device ring of recent samples
+  pdev_sample_t ring[PDEV_MAX][PDEV_HISTORY];
+  int ring_len[PDEV_MAX];
+  int ring_head[PDEV_MAX];
+};
+
+// Truncating copy; dst is always terminated
+static void copy_str(char *dst, size_t size, const char *src) {
+  if (size == 0)
+    return;
+  size_t n = src ? strnlen(src, size - 1) : 0;
+  if (n)
+    memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+// ============================================================
+// macOS: AppleSmartBattery services + IOPS for UPS/accessories
+// Each smart battery is read with one IORegistryEntryCreateCFProperties call,
+// and IOPS is snapshotted once per pass, not once per property.
+// ============================================================
+
+#ifdef __APPLE__
+
+typedef struct {
+  int kind;
+  io_service_t service; // smart batteries
+  char ps_name[48];     // IOPS devices, matched by name every pass
+} mac_device_t;
+
+typedef struct {
+  mac_device_t dev[PDEV_MAX];
+  int count;
+  CFTypeRef ps_info;
+  CFArrayRef ps_list;
+} mac_ctx_t;
+
+static int dict_int(CFDictionaryRef d, CFStringRef key, int64_t *out) {
+  CFTypeRef v = CFDictionaryGetValue(d, key);
+  if (v == NULL || CFGetTypeID(v) != CFNumberGetTypeID())
+    return -1;
+  return CFNumberGetValue((CFNumberRef)v, kCFNumberSInt64Type, out) ? 0 : -1;
+}
+
+static int dict_bool(CFDictionaryRef d, CFStringRef key) {
+  CFTypeRef v = CFDictionaryGetValue(d, key);
+  return v != NULL && CFGetTypeID(v) == CFBooleanGetTypeID() &&
+         CFBooleanGetValue((CFBooleanRef)v);
+}
+
+static void dict_str(CFDictionaryRef d, CFStringRef key, char *out,
+                     size_t size) {
+  CFTypeRef v = CFDictionaryGetValue(d, key);
+  out[0] = '\0';
+  if (v != NULL && CFGetTypeID(v) == CFStringGetTypeID())
+    CFStringGetCString((CFStringRef)v, out, (CFIndex)size,
+                       kCFStringEncodingUTF8);
+}
+
+// Amperage comes back as a 16-bit two's complement value on some models
+static int32_t signed_current(int64_t raw) {
+  if (raw > INT16_MAX && raw <= 0xFFFF)
+    return (int16_t)(uint16_t)raw;
+  return (int32_t)raw;
+}
+
+static void mac_release(mac_ctx_t *c) {
+  for (int i = 0; i < c->count; i++)
+    if (c->dev[i].service != IO_OBJECT_NULL)
+      IOObjectRelease(c->dev[i].service);
+  c->count = 0;
+}
+
+static int mac_enumerate(void *ctx, pdev_info_t *out, int max) {
+  mac_ctx_t *c = ctx;
+  mac_release(c);
+  if (max > PDEV_MAX)
+    max = PDEV_MAX;
+
+  io_iterator_t iter;
+  if (IOServiceGetMatchingServices(kIOMainPortDefault,
+                                   IOServiceMatching("AppleSmartBattery"),
+                                   &iter) == KERN_SUCCESS) {
+    io_service_t service;
+    while ((service = IOIteratorNext(iter)) != IO_OBJECT_NULL) {
+      if (c->count >= max) {
+        IOObjectRelease(service);
+        continue;
+      }
+      io_name_t name;
+      if (IORegistryEntryGetName(service, name) != KERN_SUCCESS)
+        copy_str(name, sizeof(name), "AppleSmartBattery");
+      uint64_t entry_id = 0;
+      IORegistryEntryGetRegistryEntryID(service, &entry_id);
+
+      mac_device_t *d = &c->dev[c->count];
+      d->kind = PDEV_INTERNAL;
+      d->service = service;
+      snprintf(out[c->count].id, sizeof(out[c->count].id), "%s-%llx", name,
+               (unsigned long long)entry_id);
+      copy_str(out[c->count].name, sizeof(out[c->count].name),
+               c->count == 0 ? "Internal Battery" : name);
+      out[c->count].kind = PDEV_INTERNAL;
+      c->count++;
+    }
+    IOObjectRelease(iter);
+  }
+
+  // UPS and accessory batteries only exist in the IOPS view
+  CFTypeRef info = IOPSCopyPowerSourcesInfo();
+  CFArrayRef list = info ? IOPSCopyPowerSourcesList(info) : NULL;
+  CFIndex n = list ? CFArrayGetCount(list) : 0;
+  for (CFIndex i = 0; i < n && c->count < max; i++) {
+    CFDictionaryRef desc =
+        IOPSGetPowerSourceDescription(info, CFArrayGetValueAtIndex(list, i));
+    if (desc == NULL)
+      continue;
+    char type[32];
+    dict_str(desc, CFSTR(kIOPSTypeKey), type, sizeof(type));
+    if (strcmp(type, kIOPSInternalBatteryType) == 0)
+      continue; // already covered by AppleSmartBattery
+
+    mac_device_t *d = &c->dev[c->count];
+    d->kind = strcmp(type, kIOPSUPSType) == 0 ? PDEV_UPS : PDEV_PERIPHERAL;
+    d->service = IO_OBJECT_NULL;
+    dict_str(desc, CFSTR(kIOPSNameKey), d->ps_name, sizeof(d->ps_name));
+    copy_str(out[c->count].id, sizeof(out[c->count].id), d->ps_name);
+    copy_str(out[c->count].name, sizeof(out[c->count].name), d->ps_name);
+    out[c->count].kind = d->kind;
+    c->count++;
+  }
+  if (list)
+    CFRelease(list);
+  if (info)
+    CFRelease(info);
+  return c->count;
+}
+
+static int mac_begin_pass(void *ctx) {
+  mac_ctx_t *c = ctx;
+  c->ps_info = IOPSCopyPowerSourcesInfo();
+  c->ps_list = c->ps_info ? IOPSCopyPowerSourcesList(c->ps_info) : NULL;
+  return 0;
+}
+
+static void mac_end_pass(void *ctx) {
+  mac_ctx_t *c = ctx;
+  if (c->ps_list)
+    CFRelease(c->ps_list);
+  if (c->ps_info)
+    CFRelease(c->ps_info);
+  c->ps_list = NULL;
+  c->ps_info = NULL;
+}
+
+static int mac_read_smart(io_service_t service, pdev_sample_t *out) {
+  CFMutableDictionaryRef props = NULL;
+  if (IORegistryEntryCreateCFProperties(service, &props, kCFAllocatorDefault,
+                                        0) != KERN_SUCCESS ||
+      props == NULL)
+    return -1;
+
+  int64_t v;
+  int64_t cur = 0, max = 0;
+  if (dict_int(props, CFSTR("CurrentCapacity"), &cur) == 0 &&
+      dict_int(props, CFSTR("MaxCapacity"), &max) == 0 && max > 0)
+    out->level = (int32_t)(cur * 100 / max);
+  if (dict_int(props, CFSTR("AppleRawCurrentCapacity"), &v) == 0)
+    out->cur_mah = (int32_t)v;
+  else if (max > 100)
+    out->cur_mah = (int32_t)cur; // Intel reports mAh in CurrentCapacity
+  if (dict_int(props, CFSTR("AppleRawMaxCapacity"), &v) == 0)
+    out->max_mah = (int32_t)v;
+  else if (max > 100)
+    out->max_mah = (int32_t)max;
+  if (dict_int(props, CFSTR("DesignCapacity"), &v) == 0)
+    out->design_mah = (int32_t)v;
+  if (dict_int(props, CFSTR("CycleCount"), &v) == 0)
+    out->cycle_count = (int32_t)v;
+  if (dict_int(props, CFSTR("Voltage"), &v) == 0)
+    out->voltage_mv = (int32_t)v;
+  if (dict_int(props, CFSTR("Temperature"), &v) == 0)
+    out->temp_cc = (int32_t)v;
+  if (dict_int(props, CFSTR("Amperage"), &v) == 0)
+    out->amperage_ma = signed_current(v);
+  if (out->amperage_ma == 0 &&
+      dict_int(props, CFSTR("InstantAmperage"), &v) == 0)
+    out->amperage_ma = signed_current(v);
+  out->charging = (uint8_t)dict_bool(props, CFSTR("IsCharging"));
+  out->plugged = (uint8_t)dict_bool(props, CFSTR("ExternalConnected"));
+
+  CFRelease(props);
+  return 0;
+}
+
+static int mac_read_ps(mac_ctx_t *c, const char *name, pdev_sample_t *out) {
+  CFIndex n = c->ps_list ? CFArrayGetCount(c->ps_list) : 0;
+  for (CFIndex i = 0; i < n; i++) {
+    CFDictionaryRef desc = IOPSGetPowerSourceDescription(
+        c->ps_info, CFArrayGetValueAtIndex(c->ps_list, i));
+    if (desc == NULL)
+      continue;
+    char ps_name[48];
+    dict_str(desc, CFSTR(kIOPSNameKey), ps_name, sizeof(ps_name));
+    if (strcmp(ps_name, name) != 0)
+      continue;
+
+    int64_t cur = 0, max = 0, v;
+    if (dict_int(desc, CFSTR(kIOPSCurrentCapacityKey), &cur) == 0 &&
+        dict_int(desc, CFSTR(kIOPSMaxCapacityKey), &max) == 0 && max > 0)
+      out->level = (int32_t)(cur * 100 / max);
+    if (dict_int(desc, CFSTR(kIOPSVoltageKey), &v) == 0)
+      out->voltage_mv = (int32_t)v;
+    if (dict_int(desc, CFSTR(kIOPSCurrentKey), &v) == 0)
+      out->amperage_ma = (int32_t)v;
+    out->charging = (uint8_t)dict_bool(desc, CFSTR(kIOPSIsChargingKey));
+    char state[32];
+    dict_str(desc, CFSTR(kIOPSPowerSourceStateKey), state, sizeof(state));
+    out->plugged = strcmp(state, kIOPSACPowerValue) == 0;
+    return 0;
+  }
+  return -1; // disconnected since the last rescan
+}
+
+static int mac_read(void *ctx, int index, pdev_sample_t *out) {
+  mac_ctx_t *c = ctx;
+  if (index < 0 || index >= c->count)
+    return -1;
+  if (c->dev[index].kind == PDEV_INTERNAL)
+    return mac_read_smart(c->dev[index].service, out);
+  return mac_read_ps(c, c->dev[index].ps_name, out);
+}
+
+static void mac_destroy(void *ctx) {
+  mac_ctx_t *c = ctx;
+  mac_end_pass(c);
+  mac_release(c);
+  free(c);
+}
+
+int pdev_system_backend(pdev_backend_t *out) {
+  mac_ctx_t *c = calloc(1, sizeof(mac_ctx_t));
+  if (c == NULL)
+    return -1;
+  memset(out, 0, sizeof(*out));
+  out->name = "iokit";
+  out->ctx = c;
+  out->enumerate = mac_enumerate;
+  out->begin_pass = mac_begin_pass;
+  out->read = mac_read;
+  out->end_pass = mac_end_pass;
+  out->destroy = mac_destroy;
+  return 0;
+}
+
+#endif
+
+// ============================================================
+// Linux: /sys/class/power_supply
+// Every supply's uevent file carries all of its POWER_SUPPLY_* attributes,
+// so one read per device per pass replaces a dozen attribute files.
+// ============================================================
+
+#ifdef __linux__
+
+#ifndef PDEV_SYSFS_ROOT
+#define PDEV_SYSFS_ROOT "/sys/class/power_supply"
+#endif
+
+typedef struct {
+  char dir[PDEV_MAX][48];
+  int kind[PDEV_MAX];
+  int count;
+  int mains_online; // refreshed once per pass
+} linux_ctx_t;
+
+static int read_file(const char *dev, const char *file, char *buf,
+                     size_t size) {
+  char path[256];
+  snprintf(path, sizeof(path), PDEV_SYSFS_ROOT "/%s/%s", dev, file);
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return -1;
+  size_t n = fread(buf, 1, size - 1, f);
+  fclose(f);
+  buf[n] = '\0';
+  while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' '))
+    buf[--n] = '\0';
+  return 0;
+}
+
+static int linux_enumerate(void *ctx, pdev_info_t *out, int max) {
+  linux_ctx_t *c = ctx;
+  c->count = 0;
+  if (max > PDEV_MAX)
+    max = PDEV_MAX;
+  DIR *dir = opendir(PDEV_SYSFS_ROOT);
+  if (dir == NULL)
+    return 0;
+  struct dirent *de;
+  char type[32];
+  while ((de = readdir(dir)) != NULL && c->count < max) {
+    if (de->d_name[0] == '.')
+      continue;
+    if (read_file(de->d_name, "type", type, sizeof(type)) != 0)
+      continue;
+    int kind;
+    if (strcmp(type, "Battery") == 0)
+      kind = PDEV_INTERNAL;
+    else if (strcmp(type, "UPS") == 0)
+      kind = PDEV_UPS;
+    else
+      continue; // Mains/USB are adapters, not devices
+
+    // Peripheral batteries (HID) also report type=Battery with scope=Device
+    char scope[16];
+    if (kind == PDEV_INTERNAL &&
+        read_file(de->d_name, "scope", scope, sizeof(scope)) == 0 &&
+        strcmp(scope, "Device") == 0)
+      kind = PDEV_PERIPHERAL;
+
+    copy_str(c->dir[c->count], sizeof(c->dir[c->count]), de->d_name);
+    c->kind[c->count] = kind;
+    copy_str(out[c->count].id, sizeof(out[c->count].id), de->d_name);
+    copy_str(out[c->count].name, sizeof(out[c->count].name), de->d_name);
+    out[c->count].kind = kind;
+    c->count++;
+  }
+  closedir(dir);
+  return c->count;
+}
+
+static int linux_begin_pass(void *ctx) {
+  linux_ctx_t *c = ctx;
+  c->mains_online = 0;
+  DIR *dir = opendir(PDEV_SYSFS_ROOT);
+  if (dir == NULL)
+    return 0;
+  struct dirent *de;
+  char buf[32];
+  while ((de = readdir(dir)) != NULL) {
+    if (de->d_name[0] == '.')
+      continue;
+    if (read_file(de->d_name, "type", buf, sizeof(buf)) != 0)
+      continue;
+    if (strcmp(buf, "Mains") != 0 && strncmp(buf, "USB", 3) != 0)
+      continue;
+    if (read_file(de->d_name, "online", buf, sizeof(buf)) == 0 &&
+        atoi(buf) > 0)
+      c->mains_online = 1;
+  }
+  closedir(dir);
+  return 0;
+}
+
+static int linux_read(void *ctx, int index, pdev_sample_t *out) {
+  linux_ctx_t *c = ctx;
+  if (index < 0 || index >= c->count)
+    return -1;
+  char buf[4096];
+  if (read_file(c->dir[index], "uevent", buf, sizeof(buf)) != 0)
+    return -1;
+
+  int64_t charge_now = -1, charge_full = -1, charge_design = -1;
+  int64_t energy_now = -1, energy_full = -1, energy_design = -1;
+  int64_t current_now = 0, power_now = 0;
+  int have_current = 0, online = -1;
+  char status[24] = "";
+
+  char *save = NULL;
+  for (char *line = strtok_r(buf, "\n", &save); line;
+       line = strtok_r(NULL, "\n", &save)) {
+    if (strncmp(line, "POWER_SUPPLY_", 13) != 0)
+      continue;
+    char *key = line + 13;
+    char *eq = strchr(key, '=');
+    if (eq == NULL)
+      continue;
+    *eq = '\0';
+    const char *val = eq + 1;
+    long long n = atoll(val);
+
+    if (strcmp(key, "CAPACITY") == 0)
+      out->level = (int32_t)n;
+    else if (strcmp(key, "VOLTAGE_NOW") == 0)
+      out->voltage_mv = (int32_t)(n / 1000);
+    else if (strcmp(key, "CURRENT_NOW") == 0) {
+      current_now = n;
+      have_current = 1;
+    } else if (strcmp(key, "POWER_NOW") == 0)
+      power_now = n;
+    else if (strcmp(key, "TEMP") == 0)
+      out->temp_cc = (int32_t)(n * 10); // tenths -> hundredths
+    else if (strcmp(key, "CYCLE_COUNT") == 0)
+      out->cycle_count = (int32_t)n;
+    else if (strcmp(key, "CHARGE_NOW") == 0)
+      charge_now = n;
+    else if (strcmp(key, "CHARGE_FULL") == 0)
+      charge_full = n;
+    else if (strcmp(key, "CHARGE_FULL_DESIGN") == 0)
+      charge_design = n;
+    else if (strcmp(key, "ENERGY_NOW") == 0)
+      energy_now = n;
+    else if (strcmp(key, "ENERGY_FULL") == 0)
+      energy_full = n;
+    else if (strcmp(key, "ENERGY_FULL_DESIGN") == 0)
+      energy_design = n;
+    else if (strcmp(key, "STATUS") == 0)
+      copy_str(status, sizeof(status), val);
+    else if (strcmp(key, "ONLINE") == 0)
+      online = (int)n;
+  }
+
+  // Capacities are in uAh, or uWh on energy-reporting firmware
+  int64_t mv = out->voltage_mv > 0 ? out->voltage_mv : 0;
+  if (charge_now >= 0) {
+    out->cur_mah = (int32_t)(charge_now / 1000);
+    out->max_mah = (int32_t)(charge_full / 1000);
+    out->design_mah = (int32_t)(charge_design / 1000);
+  } else if (energy_now >= 0 && mv > 0) {
+    out->cur_mah = (int32_t)(energy_now / mv);
+    out->max_mah = (int32_t)(energy_full / mv);
+    out->design_mah = (int32_t)(energy_design / mv);
+  }
+  if (!have_current && power_now != 0 && mv > 0)
+    current_now = power_now * 1000 / mv; // uW / mV = mA, scaled back to uA
+
+  out->charging = strcmp(status, "Charging") == 0;
+  // current_now is unsigned on most drivers; the status decides the sign
+  int32_t ma = (int32_t)((current_now < 0 ? -current_now : current_now) / 1000);
+  out->amperage_ma = strcmp(status, "Discharging") == 0 ? -ma : ma;
+  out->plugged = (uint8_t)(online >= 0 ? online > 0 : c->mains_online);
+  return 0;
+}
+
+static void linux_destroy(void *ctx) { free(ctx); }
+
+int pdev_system_backend(pdev_backend_t *out) {
+  linux_ctx_t *c = calloc(1, sizeof(linux_ctx_t));
+  if (c == NULL)
+    return -1;
+  memset(out, 0, sizeof(*out));
+  out->name = "sysfs";
+  out->ctx = c;
+  out->enumerate = linux_enumerate;
+  out->begin_pass = linux_begin_pass;
+  out->read = linux_read;
+  out->destroy = linux_destroy;
+  return 0;
+}
+
+#endif
+
+#if !defined(__APPLE__) && !defined(__linux__)
+int pdev_system_backend(pdev_backend_t *out) {
+  (void)out;
+  fprintf(stderr, "pdev: no system backend on this platform\n");
+  return -1;
+}
+#endif
+
+// ============================================================
+// Fake device set
+// ============================================================
+
+struct pdev_fake {
+  pdev_info_t info[PDEV_MAX];
+  pdev_sample_t sample[PDEV_MAX];
+  int count;
+};
+
+pdev_fake_t *pdev_fake_create(void) { return calloc(1, sizeof(pdev_fake_t)); }
+
+int pdev_fake_add(pdev_fake_t *fake, const char *name, int kind) {
+  if (fake == NULL || fake->count >= PDEV_MAX)
+    return -1;
+  int i = fake->count++;
+  snprintf(fake->info[i].id, sizeof(fake->info[i].id), "fake%d", i);
+  copy_str(fake->info[i].name, sizeof(fake->info[i].name), name);
+  fake->info[i].kind = kind;
+  return i;
+}
+
+int pdev_fake_update(pdev_fake_t *fake, int index,
+                     const pdev_sample_t *sample) {
+  if (fake == NULL || index < 0 || index >= fake->count)
+    return -1;
+  fake->sample[index] = *sample;
+  return 0;
+}
+
+static int fake_enumerate(void *ctx, pdev_info_t *out, int max) {
+  pdev_fake_t *fake = ctx;
+  int n = fake->count < max ? fake->count : max;
+  memcpy(out, fake->info, (size_t)n * sizeof(pdev_info_t));
+  return n;
+}
+
+static int fake_read(void *ctx, int index, pdev_sample_t *out) {
+  pdev_fake_t *fake = ctx;
+  if (index < 0 || index >= fake->count)
+    return -1;
+  *out = fake->sample[index];
+  return 0;
+}
+
+int pdev_fake_backend(pdev_fake_t *fake, pdev_backend_t *out) {
+  if (fake == NULL)
+    return -1;
+  memset(out, 0, sizeof(*out));
+  out->name = "fake";
+  out->ctx = fake;
+  out->enumerate = fake_enumerate;
+  out->read = fake_read;
+  return 0; // the caller keeps ownership of the fake
+}
+
+void pdev_fake_destroy(pdev_fake_t *fake) { free(fake); }
+
+// ============================================================
+// Device set
+// ============================================================
+
+pdev_set_t *pdev_open(const pdev_backend_t *backend) {
+  pdev_set_t *set = calloc(1, sizeof(pdev_set_t));
+  if (set == NULL)
+    return NULL;
+  if (backend)
+    set->backend = *backend;
+  else if (pdev_system_backend(&set->backend) != 0) {
+    free(set);
+    return NULL;
+  }
+  pdev_rescan(set);
+  return set;
+}
+
+int pdev_rescan(pdev_set_t *set) {
+  if (set == NULL || set->backend.enumerate == NULL)
+    return -1;
+  pdev_info_t info[PDEV_MAX];
+  memset(info, 0, sizeof(info));
+  int n = set->backend.enumerate(set->backend.ctx, info, PDEV_MAX);
+  if (n < 0)
+    n = 0;
+
+  // Keep the stream of every device that is still present
+  pdev_sample_t *old = malloc(sizeof(set->ring));
+  int old_len[PDEV_MAX], old_head[PDEV_MAX];
+  pdev_info_t old_info[PDEV_MAX];
+  int old_count = set->count;
+  if (old) {
+    memcpy(old, set->ring, sizeof(set->ring));
+    memcpy(old_len, set->ring_len, sizeof(old_len));
+    memcpy(old_head, set->ring_head, sizeof(old_head));
+    memcpy(old_info, set->info, sizeof(old_info));
+  }
+  memset(set->ring_len, 0, sizeof(set->ring_len));
+  memset(set->ring_head, 0, sizeof(set->ring_head));
+
+  for (int i = 0; i < n; i++) {
+    set->info[i] = info[i];
+    for (int j = 0; old && j < old_count; j++) {
+      if (strcmp(old_info[j].id, info[i].id) == 0) {
+        memcpy(set->ring[i], old + (size_t)j * PDEV_HISTORY,
+               sizeof(set->ring[i]));
+        set->ring_len[i] = old_len[j];
+        set->ring_head[i] = old_head[j];
+        break;
+      }
+    }
+  }
+  set->count = n;
+  free(old);
+  return n;
+}
+
+int pdev_count(const pdev_set_t *set) { return set ? set->count : 0; }
+
+const pdev_info_t *pdev_info(const pdev_set_t *set, int index) {
+  if (set == NULL || index < 0 || index >= set->count)
+    return NULL;
+  return &set->info[index];
+}
+
+static void push_sample(pdev_set_t *set, int i, const pdev_sample_t *s) {
+  set->ring[i][set->ring_head[i]] = *s;
+  set->ring_head[i] = (set->ring_head[i] + 1) % PDEV_HISTORY;
+  if (set->ring_len[i] < PDEV_HISTORY)
+    set->ring_len[i]++;
+}
+
+int pdev_poll(pdev_set_t *set, int64_t t_ms) {
+  if (set == NULL || set->backend.read == NULL)
+    return 0;
+  if (set->backend.begin_pass)
+    set->backend.begin_pass(set->backend.ctx);
+
+  int ok = 0;
+  for (int i = 0; i < set->count; i++) {
+    const pdev_sample_t *latest = pdev_latest(set, i);
+    if (latest && latest->t_ms == t_ms) {
+      ok++;
+      continue;
+    }
+    pdev_sample_t s;
+    memset(&s, 0, sizeof(s));
+    if (set->backend.read(set->backend.ctx, i, &s) != 0)
+      continue;
+    s.t_ms = t_ms;
+    s.valid = 1;
+    push_sample(set, i, &s);
+    ok++;
+  }
+
+  if (set->backend.end_pass)
+    set->backend.end_pass(set->backend.ctx);
+  return ok;
+}
+
+int pdev_submit(pdev_set_t *set, int index, const pdev_sample_t *sample) {
+  if (set == NULL || sample == NULL || index < 0 || index >= set->count)
+    return -1;
+  pdev_sample_t s = *sample;
+  s.valid = 1;
+  push_sample(set, index, &s);
+  return 0;
+}
+
+const pdev_sample_t *pdev_latest(const pdev_set_t *set, int index) {
+  if (set == NULL || index < 0 || index >= set->count ||
+      set->ring_len[index] == 0)
+    return NULL;
+  int last = (set->ring_head[index] + PDEV_HISTORY - 1) % PDEV_HISTORY;
+  return &set->ring[index][last];
+}
+
+int pdev_history(const pdev_set_t *set, int index, pdev_sample_t *out,
+                 int max) {
+  if (set == NULL || index < 0 || index >= set->count)
+    return 0;
+  int len = set->ring_len[index];
+  int n = len < max ? len : max;
+  int start = (set->ring_head[index] + PDEV_HISTORY - n) % PDEV_HISTORY;
+  for (int i = 0; i < n; i++)
+    out[i] = set->ring[index][(start + i) % PDEV_HISTORY];
+  return n;
+}
+
+void pdev_close(pdev_set_t *set) {
+  if (set == NULL)
+    return;
+  if (set->backend.destroy)
+    set->backend.destroy(set->backend.ctx);
+  free(set);
+}
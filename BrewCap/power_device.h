@@ -0,0 +1,95 @@
+//
+//  power_device.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef power_device_h
+#define power_device_h
+
+#include <stdint.h>
+
+#define PDEV_MAX 16      // devices per set
+#define PDEV_HISTORY 256 // samples kept per device stream
+
+typedef enum {
+  PDEV_INTERNAL = 0, // AppleSmartBattery / power_supply type=Battery
+  PDEV_UPS = 1,
+  PDEV_PERIPHERAL = 2, // keyboards, mice, ... reported through IOPS
+} pdev_kind_t;
+
+typedef struct {
+  char id[48]; // stable per boot: registry entry name, IOPS name, sysfs dir
+  char name[48];
+  int kind;
+} pdev_info_t;
+
+// One battery sample; the unit of every telemetry stream in the C core
+typedef struct {
+  int64_t t_ms;        // ms since 1970
+  int32_t level;       // percent
+  int32_t amperage_ma; // > 0 into the battery, < 0 out of it
+  int32_t voltage_mv;
+  int32_t temp_cc; // centi-degrees C, 0 when the device has no sensor
+  int32_t cur_mah;
+  int32_t max_mah;
+  int32_t design_mah;
+  int32_t cycle_count;
+  float power_w; // whole-system draw when known (SMC), else battery rail
+  uint8_t plugged;
+  uint8_t charging;
+  uint8_t valid;
+  uint8_t reserved;
+} pdev_sample_t;
+
+// A source of devices. begin/end bracket one polling pass so a backend can
+// take a single snapshot per tick; either may be NULL.
+typedef struct {
+  const char *name;
+  void *ctx;
+  int (*enumerate)(void *ctx, pdev_info_t *out, int max);
+  int (*begin_pass)(void *ctx);
+  int (*read)(void *ctx, int index, pdev_sample_t *out);
+  void (*end_pass)(void *ctx);
+  void (*destroy)(void *ctx);
+} pdev_backend_t;
+
+typedef struct pdev_set pdev_set_t;
+
+// IOKit (AppleSmartBattery + IOPS UPS/accessories) on macOS, sysfs on Linux
+int pdev_system_backend(pdev_backend_t *out);
+
+// Fake device set for tests: add devices, then feed samples to them
+typedef struct pdev_fake pdev_fake_t;
+pdev_fake_t *pdev_fake_create(void);
+int pdev_fake_add(pdev_fake_t *fake, const char *name, int kind);
+int pdev_fake_update(pdev_fake_t *fake, int index, const pdev_sample_t *sample);
+int pdev_fake_backend(pdev_fake_t *fake, pdev_backend_t *out);
+void pdev_fake_destroy(pdev_fake_t *fake);
+
+// The set takes ownership of the backend (destroy is called on close)
+pdev_set_t *pdev_open(const pdev_backend_t *backend);
+int pdev_rescan(pdev_set_t *set);
+int pdev_count(const pdev_set_t *set);
+const pdev_info_t *pdev_info(const pdev_set_t *set, int index);
+
+// One batched pass over every device; returns the number read successfully.
+// Devices already given a sample for t_ms with pdev_submit are not read
+// again.
+int pdev_poll(pdev_set_t *set, int64_t t_ms);
+
+// Appends a sample read elsewhere (the app's own read of the internal
+// battery) to a device's stream, so the same tick is not read twice
+int pdev_submit(pdev_set_t *set, int index, const pdev_sample_t *sample);
+
+// Latest sample, or NULL if the device has never been read
+const pdev_sample_t *pdev_latest(const pdev_set_t *set, int index);
+
+// Per-device stream, oldest first; returns the number copied
+int pdev_history(const pdev_set_t *set, int index, pdev_sample_t *out,
+                 int max);
+
+void pdev_close(pdev_set_t *set);
+
+#endif
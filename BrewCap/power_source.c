@@ -0,0 +1,339 @@
+//
+//  power_source.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "power_source.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef __APPLE__
+#include <CoreFoundation/CoreFoundation.h>
+#include <IOKit/ps/IOPSKeys.h>
+#include <IOKit/ps/IOPowerSources.h>
+#endif
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+enum { PSRC_SYSTEM = 0, PSRC_FAKE = 1 };
+
+struct psrc {
+  int kind;
+  psrc_callback_t cb;
+  void *ctx;
+  int online;
+  int fd;
+#ifdef __APPLE__
+  CFRunLoopSourceRef rls;
+#endif
+  // Fake source script
+  psrc_event_t *queue;
+  int queue_len;
+  int queue_cap;
+};
+
+static double now_seconds(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+}
+
+// Deliver a transition if it actually changes the state
+static int emit(psrc_t *src, double timestamp, int online) {
+  if (online == src->online)
+    return 0;
+  src->online = online;
+  psrc_event_t ev = {timestamp, online};
+  if (src->cb)
+    src->cb(&ev, src->ctx);
+  return 1;
+}
+
+// ============================================================
+// macOS: IOKit power-source notifications
+// IOPSCreateLimitedPowerNotification only fires when the providing power
+// source changes (AC <-> battery), not on every percent tick.
+// ============================================================
+
+#ifdef __APPLE__
+
+static int system_online(void) {
+  CFTypeRef info = IOPSCopyPowerSourcesInfo();
+  if (info == NULL)
+    return 0;
+  CFStringRef type = IOPSGetProvidingPowerSourceType(info);
+  int online = type != NULL && CFStringCompare(type, CFSTR(kIOPSACPowerValue),
+                                               0) == kCFCompareEqualTo;
+  CFRelease(info);
+  return online;
+}
+
+static void power_source_changed(void *context) {
+  psrc_t *src = (psrc_t *)context;
+  emit(src, now_seconds(), system_online());
+}
+
+static int system_start(psrc_t *src) {
+  src->online = system_online();
+  src->rls = IOPSCreateLimitedPowerNotification(power_source_changed, src);
+  if (src->rls == NULL) {
+    fprintf(stderr, "psrc: IOPSCreateLimitedPowerNotification failed\n");
+    return -1;
+  }
+  CFRunLoopAddSource(CFRunLoopGetMain(), src->rls, kCFRunLoopDefaultMode);
+  return 0;
+}
+
+static void system_stop(psrc_t *src) {
+  if (src->rls) {
+    CFRunLoopRemoveSource(CFRunLoopGetMain(), src->rls, kCFRunLoopDefaultMode);
+    CFRelease(src->rls);
+    src->rls = NULL;
+  }
+}
+
+static int system_dispatch(psrc_t *src) {
+  // Notifications arrive through the run loop; this only resyncs
+  return emit(src, now_seconds(), system_online());
+}
+
+#endif
+
+// ============================================================
+// Linux: power_supply uevents over NETLINK_KOBJECT_UEVENT
+// sysfs attributes do not raise inotify events, so the kernel's uevent
+// broadcast is the only push signal; on each power_supply uevent the
+// `online` attribute of every Mains/USB supply is re-read.
+// ============================================================
+
+#ifdef __linux__
+
+#ifndef PSRC_SYSFS_ROOT
+#define PSRC_SYSFS_ROOT "/sys/class/power_supply"
+#endif
+
+static int read_attr(const char *dev, const char *attr, char *buf,
+                     size_t size) {
+  char path[512];
+  snprintf(path, sizeof(path), PSRC_SYSFS_ROOT "/%s/%s", dev, attr);
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return -1;
+  size_t n = fread(buf, 1, size - 1, f);
+  fclose(f);
+  while (n > 0 && (buf[n - 1] == '\n' || buf[n - 1] == ' '))
+    n--;
+  buf[n] = '\0';
+  return 0;
+}
+
+static int system_online(void) {
+  DIR *dir = opendir(PSRC_SYSFS_ROOT);
+  if (dir == NULL)
+    return 0;
+  int online = 0;
+  struct dirent *de;
+  char buf[32];
+  while ((de = readdir(dir)) != NULL) {
+    if (de->d_name[0] == '.')
+      continue;
+    if (read_attr(de->d_name, "type", buf, sizeof(buf)) != 0)
+      continue;
+    if (strcmp(buf, "Mains") != 0 && strncmp(buf, "USB", 3) != 0)
+      continue;
+    if (read_attr(de->d_name, "online", buf, sizeof(buf)) == 0 &&
+        atoi(buf) > 0) {
+      online = 1;
+      break;
+    }
+  }
+  closedir(dir);
+  return online;
+}
+
+static int system_start(psrc_t *src) {
+  src->online = system_online();
+  src->fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                   NETLINK_KOBJECT_UEVENT);
+  if (src->fd < 0) {
+    fprintf(stderr, "psrc: netlink socket failed: %s\n", strerror(errno));
+    return -1;
+  }
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = 1; // kernel uevent broadcast group
+  if (bind(src->fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+    fprintf(stderr, "psrc: netlink bind failed: %s\n", strerror(errno));
+    close(src->fd);
+    src->fd = -1;
+    return -1;
+  }
+  // Kernel receive times, so a burst read late keeps its own time; without
+  // them dispatch falls back to the time of the read
+  int one = 1;
+  if (setsockopt(src->fd, SOL_SOCKET, SO_TIMESTAMP, &one, sizeof(one)) != 0)
+    fprintf(stderr, "psrc: SO_TIMESTAMP unavailable: %s\n", strerror(errno));
+  return 0;
+}
+
+static void system_stop(psrc_t *src) {
+  if (src->fd >= 0) {
+    close(src->fd);
+    src->fd = -1;
+  }
+}
+
+static int is_power_supply_uevent(const char *msg, size_t len) {
+  // "ACTION@DEVPATH\0KEY=VALUE\0KEY=VALUE\0..."
+  size_t i = strnlen(msg, len) + 1;
+  while (i < len) {
+    const char *field = msg + i;
+    size_t flen = strnlen(field, len - i);
+    if (flen == 22 && memcmp(field, "SUBSYSTEM=power_supply", 22) == 0)
+      return 1;
+    i += flen + 1;
+  }
+  return 0;
+}
+
+static int system_dispatch(psrc_t *src) {
+  if (src->fd < 0)
+    return 0;
+  char buf[4096];
+  char control[CMSG_SPACE(sizeof(struct timeval))];
+  int relevant = 0;
+  double stamp = 0;
+  for (;;) {
+    struct iovec iov = {buf, sizeof(buf) - 1};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n = recvmsg(src->fd, &msg, 0);
+    if (n <= 0)
+      break;
+    buf[n] = '\0';
+    if (!is_power_supply_uevent(buf, (size_t)n) || relevant)
+      continue;
+    // Timestamp the first uevent of the burst with the time the kernel
+    // queued it, not the time we got to it
+    relevant = 1;
+    stamp = now_seconds();
+    for (struct cmsghdr *c = CMSG_FIRSTHDR(&msg); c != NULL;
+         c = CMSG_NXTHDR(&msg, c)) {
+      if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMP) {
+        struct timeval tv;
+        memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+        stamp = (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+      }
+    }
+  }
+  if (!relevant)
+    return 0;
+  return emit(src, stamp, system_online());
+}
+
+#endif
+
+#if !defined(__APPLE__) && !defined(__linux__)
+static int system_start(psrc_t *src) {
+  (void)src;
+  fprintf(stderr, "psrc: no system power source on this platform\n");
+  return -1;
+}
+static void system_stop(psrc_t *src) { (void)src; }
+static int system_dispatch(psrc_t *src) {
+  (void)src;
+  return 0;
+}
+#endif
+
+// ============================================================
+// Public API
+// ============================================================
+
+static psrc_t *alloc_source(int kind, psrc_callback_t cb, void *ctx) {
+  psrc_t *src = calloc(1, sizeof(psrc_t));
+  if (src == NULL)
+    return NULL;
+  src->kind = kind;
+  src->cb = cb;
+  src->ctx = ctx;
+  src->fd = -1;
+  return src;
+}
+
+psrc_t *psrc_open_system(psrc_callback_t cb, void *ctx) {
+  psrc_t *src = alloc_source(PSRC_SYSTEM, cb, ctx);
+  if (src == NULL)
+    return NULL;
+  if (system_start(src) != 0) {
+    free(src);
+    return NULL;
+  }
+  return src;
+}
+
+psrc_t *psrc_open_fake(psrc_callback_t cb, void *ctx, int initial_online) {
+  psrc_t *src = alloc_source(PSRC_FAKE, cb, ctx);
+  if (src)
+    src->online = initial_online ? 1 : 0;
+  return src;
+}
+
+int psrc_fake_push(psrc_t *src, double timestamp, int online) {
+  if (src == NULL || src->kind != PSRC_FAKE)
+    return -1;
+  if (src->queue_len == src->queue_cap) {
+    int cap = src->queue_cap ? src->queue_cap * 2 : 16;
+    psrc_event_t *q = realloc(src->queue, (size_t)cap * sizeof(psrc_event_t));
+    if (q == NULL)
+      return -1;
+    src->queue = q;
+    src->queue_cap = cap;
+  }
+  src->queue[src->queue_len].timestamp = timestamp;
+  src->queue[src->queue_len].online = online ? 1 : 0;
+  src->queue_len++;
+  return 0;
+}
+
+int psrc_fd(const psrc_t *src) { return src ? src->fd : -1; }
+
+int psrc_dispatch(psrc_t *src) {
+  if (src == NULL)
+    return 0;
+  if (src->kind == PSRC_SYSTEM)
+    return system_dispatch(src);
+
+  int delivered = 0;
+  for (int i = 0; i < src->queue_len; i++)
+    delivered += emit(src, src->queue[i].timestamp, src->queue[i].online);
+  src->queue_len = 0;
+  return delivered;
+}
+
+int psrc_online(const psrc_t *src) { return src ? src->online : 0; }
+
+void psrc_close(psrc_t *src) {
+  if (src == NULL)
+    return;
+  if (src->kind == PSRC_SYSTEM)
+    system_stop(src);
+  free(src->queue);
+  free(src);
+}
@@ -0,0 +1,45 @@
+//
+//  power_source.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef power_source_h
+#define power_source_h
+
+#include <stdint.h>
+
+// A plug/unplug transition, timestamped when it was observed
+typedef struct {
+  double timestamp; // seconds since 1970
+  int online;       // 1 = external power connected
+} psrc_event_t;
+
+typedef void (*psrc_callback_t)(const psrc_event_t *event, void *ctx);
+
+typedef struct psrc psrc_t;
+
+// System source: IOKit power-source notifications on macOS (delivered on the
+// main run loop), kernel uevents for the power_supply subsystem on Linux
+// (poll psrc_fd() and call psrc_dispatch()).
+psrc_t *psrc_open_system(psrc_callback_t cb, void *ctx);
+
+// Scriptable fake: queue transitions with psrc_fake_push(), deliver them with
+// psrc_dispatch(). Pushes that do not change the state are dropped, exactly
+// like the system source.
+psrc_t *psrc_open_fake(psrc_callback_t cb, void *ctx, int initial_online);
+int psrc_fake_push(psrc_t *src, double timestamp, int online);
+
+// Pollable descriptor, or -1 when the source is run-loop driven (macOS, fake)
+int psrc_fd(const psrc_t *src);
+
+// Drain pending notifications; returns the number of transitions delivered
+int psrc_dispatch(psrc_t *src);
+
+// Last known state: 1 = on external power, 0 = on battery
+int psrc_online(const psrc_t *src);
+
+void psrc_close(psrc_t *src);
+
+#endif
@@ -0,0 +1,153 @@
+//
+//  rainflow.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "rainflow.h"
+#include <math.h>
+#include <string.h>
+
+static void emit(rfc_point_t a, rfc_point_t b, double count, rfc_cycle_t *out,
+                 int max, int *written) {
+  if (*written >= max)
+    return;
+  rfc_cycle_t *c = &out[(*written)++];
+  c->depth_pct = fabs((double)a.level - (double)b.level);
+  c->mean_pct = ((double)a.level + (double)b.level) / 2.0;
+  c->temp_c = ((double)a.temp_c + (double)b.temp_c) / 2.0;
+  c->count = count;
+}
+
+static double range(const rfc_counter_t *rf, int i) {
+  return fabs((double)rf->stack[i].level - (double)rf->stack[i - 1].level);
+}
+
+// Pushes a confirmed reversal and closes what the three-point rule allows
+static int add_reversal(rfc_counter_t *rf, rfc_point_t p, rfc_cycle_t *out,
+                        int max) {
+  int written = 0;
+  if (rf->n == RFC_STACK) {
+    emit(rf->stack[0], rf->stack[1], 0.5, out, max, &written);
+    memmove(rf->stack, rf->stack + 1, (RFC_STACK - 1) * sizeof(rfc_point_t));
+    rf->n--;
+  }
+  rf->stack[rf->n++] = p;
+  while (rf->n >= 3) {
+    int top = rf->n - 1;
+    if (range(rf, top) < range(rf, top - 1))
+      break;
+    if (rf->n == 3) {
+      // The range holds the starting point: half a cycle, and the start
+      // moves up
+      emit(rf->stack[0], rf->stack[1], 0.5, out, max, &written);
+      rf->stack[0] = rf->stack[1];
+      rf->stack[1] = rf->stack[2];
+      rf->n = 2;
+    } else {
+      emit(rf->stack[top - 2], rf->stack[top - 1], 1.0, out, max, &written);
+      rf->stack[top - 2] = rf->stack[top];
+      rf->n -= 2;
+    }
+  }
+  return written;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void rfc_init(rfc_counter_t *rf, double hysteresis) {
+  if (rf == NULL)
+    return;
+  memset(rf, 0, sizeof(*rf));
+  rf->hysteresis = (float)hysteresis;
+}
+
+int rfc_push(rfc_counter_t *rf, double level, double temp_c, rfc_cycle_t *out,
+             int max) {
+  if (rf == NULL)
+    return 0;
+  rfc_point_t p = {(float)level, (float)temp_c};
+  if (!rf->started) {
+    rf->stack[0] = p;
+    rf->n = 1;
+    rf->extreme = p;
+    rf->direction = 0;
+    rf->started = 1;
+    return 0;
+  }
+  if (rf->direction == 0) {
+    if (fabsf(p.level - rf->stack[0].level) >= rf->hysteresis) {
+      rf->direction = p.level > rf->stack[0].level ? 1 : -1;
+      rf->extreme = p;
+    }
+    return 0;
+  }
+  if ((rf->direction > 0 && p.level > rf->extreme.level) ||
+      (rf->direction < 0 && p.level < rf->extreme.level)) {
+    rf->extreme = p;
+    return 0;
+  }
+  if (fabsf(p.level - rf->extreme.level) < rf->hysteresis)
+    return 0;
+  int written = add_reversal(rf, rf->extreme, out, max);
+  rf->extreme = p;
+  rf->direction = -rf->direction;
+  return written;
+}
+
+int rfc_residue(const rfc_counter_t *rf, rfc_cycle_t *out, int max) {
+  if (rf == NULL || !rf->started)
+    return 0;
+  int written = 0;
+  for (int i = 1; i < rf->n; i++)
+    emit(rf->stack[i - 1], rf->stack[i], 0.5, out, max, &written);
+  if (rf->direction != 0)
+    emit(rf->stack[rf->n - 1], rf->extreme, 0.5, out, max, &written);
+  return written;
+}
+
+int rfc_bin(double depth_pct) {
+  int b = (int)(depth_pct / (100.0 / RFC_BINS));
+  return b < 0 ? 0 : b < RFC_BINS ? b : RFC_BINS - 1;
+}
+
+int rfc_bin_low(int bin) { return bin * (100 / RFC_BINS); }
+
+void rfc_history_add(rfc_history_t *h, int32_t day, const rfc_cycle_t *c,
+                     double wear_pct) {
+  if (h == NULL || c == NULL || day <= 0)
+    return;
+  rfc_day_t *d = &h->days[day % RFC_DAYS];
+  if (d->day != day) {
+    memset(d, 0, sizeof(*d));
+    d->day = day;
+  }
+  int b = rfc_bin(c->depth_pct);
+  d->cycles[b] += (float)c->count;
+  d->wear_pct[b] += (float)wear_pct;
+}
+
+int rfc_history_sum(const rfc_history_t *h, int32_t from_day, int32_t to_day,
+                    double cycles[RFC_BINS], double wear_pct[RFC_BINS]) {
+  for (int b = 0; b < RFC_BINS; b++) {
+    cycles[b] = 0;
+    wear_pct[b] = 0;
+  }
+  if (h == NULL)
+    return 0;
+  int days = 0;
+  for (int i = 0; i < RFC_DAYS; i++) {
+    const rfc_day_t *d = &h->days[i];
+    if (d->day <= 0 || d->day < from_day || d->day > to_day)
+      continue;
+    days++;
+    for (int b = 0; b < RFC_BINS; b++) {
+      cycles[b] += d->cycles[b];
+      wear_pct[b] += d->wear_pct[b];
+    }
+  }
+  return days;
+}
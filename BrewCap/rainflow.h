@@ -0,0 +1,88 @@
+//
+//  rainflow.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef rainflow_h
+#define rainflow_h
+
+#include <stdint.h>
+
+// Rainflow cycle counting over the charge level, as it streams in.
+//
+// The firmware's cycle count only adds up charge throughput, so ten 10%
+// top-ups look the same as one full cycle although they wear the battery
+// far less. Rainflow pairs the reversals of the level into cycles of a
+// depth instead: a 5% wiggle while holding at a limit is its own shallow
+// cycle and does not break the deep cycle it sits inside.
+//
+// Reversals are confirmed once the level moves `hysteresis` back from an
+// extreme, which keeps single-percent jitter out. Each reversal goes on a
+// stack and the three-point rule (ASTM E1049) closes cycles off its top, so
+// every reversal is pushed and popped once: O(1) amortized per sample. The
+// stack holds the unclosed residue, whose ranges shrink towards the top;
+// for a level between 0 and 100 that stays short, and past RFC_STACK the
+// oldest range is let go as a half cycle.
+
+#define RFC_STACK 64
+#define RFC_BINS 20 // 5% of depth each
+#define RFC_DAYS 60 // days of per-depth history
+
+typedef struct {
+  float level;
+  float temp_c;
+} rfc_point_t;
+
+typedef struct {
+  double depth_pct;
+  double mean_pct;
+  double temp_c; // mean over the two reversals
+  double count;  // 1 for a full cycle, 0.5 for a half
+} rfc_cycle_t;
+
+typedef struct {
+  rfc_point_t stack[RFC_STACK];
+  int32_t n;
+  float hysteresis;
+  // The extreme since the last reversal, not yet confirmed
+  int32_t direction; // 1 rising, -1 falling, 0 before the first move
+  rfc_point_t extreme;
+  int32_t started;
+} rfc_counter_t;
+
+void rfc_init(rfc_counter_t *rf, double hysteresis);
+
+// One sample. Writes the cycles it closed to out, up to max (RFC_STACK is
+// always enough), and returns how many were written.
+int rfc_push(rfc_counter_t *rf, double level, double temp_c, rfc_cycle_t *out,
+             int max);
+
+// What is still open, each range as a half cycle, including the run to the
+// unconfirmed extreme
+int rfc_residue(const rfc_counter_t *rf, rfc_cycle_t *out, int max);
+
+// Cycles and wear per depth bin for each of the last RFC_DAYS days, in a
+// ring indexed by day
+typedef struct {
+  int32_t day; // days since 1970, local
+  float cycles[RFC_BINS];
+  float wear_pct[RFC_BINS];
+} rfc_day_t;
+
+typedef struct {
+  rfc_day_t days[RFC_DAYS];
+} rfc_history_t;
+
+int rfc_bin(double depth_pct);
+int rfc_bin_low(int bin); // lower edge in percent
+
+void rfc_history_add(rfc_history_t *h, int32_t day, const rfc_cycle_t *c,
+                     double wear_pct);
+
+// Totals per bin over days [from_day, to_day]; returns the days with cycles
+int rfc_history_sum(const rfc_history_t *h, int32_t from_day, int32_t to_day,
+                    double cycles[RFC_BINS], double wear_pct[RFC_BINS]);
+
+#endif
@@ -0,0 +1,79 @@
+//
+//  retention.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "retention.h"
+#include <stdio.h>
+
+// A tier is only rewritten once it holds this fraction of its age limit in
+// excess, so trims happen in batches rather than one bucket per pass
+#define TRIM_SLACK_DIV 8
+
+#define DAY_MS 86400000LL
+
+static int64_t trim_tier(rollup_t *r, int tier, int64_t age_ms,
+                         int64_t now_ms, int64_t budget_bytes) {
+  if (age_ms <= 0)
+    return 0;
+  rollup_bucket_t oldest;
+  if (rollup_query(r, tier, INT64_MIN, INT64_MAX, &oldest, 1) != 1)
+    return 0;
+  if (oldest.start_ms >= now_ms - age_ms - age_ms / TRIM_SLACK_DIV)
+    return 0;
+  return rollup_trim(r, tier, now_ms - age_ms, budget_bytes);
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+ret_policy_t ret_default_policy(void) {
+  ret_policy_t p = {
+      .telemetry = {.raw_age_ms = 30 * DAY_MS,
+                    .downsample_ms = 5 * 60000,
+                    .max_age_ms = 0},
+      .minute_rollup_age_ms = 30 * DAY_MS,
+      .hour_rollup_age_ms = 730 * DAY_MS,
+      .event_age_ms = 365 * DAY_MS,
+  };
+  return p;
+}
+
+int64_t ret_run(const ret_policy_t *policy, ts_store_t *store, rollup_t *rollups,
+                elog_t *events, int64_t now_ms, int64_t budget_bytes) {
+  if (policy == NULL)
+    return -1;
+  int64_t spent = 0;
+
+  // In place in the mapped ring; no rewrite
+  if (events && policy->event_age_ms > 0)
+    elog_expire(events, (double)(now_ms - policy->event_age_ms) / 1000.0);
+
+  if (store) {
+    int64_t n = ts_compact(store, &policy->telemetry, now_ms, budget_bytes);
+    if (n < 0)
+      return -1;
+    spent += n;
+  }
+
+  // A trim spreads its copy over passes, so a tier much larger than the
+  // budget is still trimmed without a long stall
+  if (rollups) {
+    const int64_t ages[] = {policy->minute_rollup_age_ms,
+                            policy->hour_rollup_age_ms};
+    for (int tier = ROLLUP_1M; tier <= ROLLUP_1H && spent < budget_bytes;
+         tier++) {
+      int64_t n =
+          trim_tier(rollups, tier, ages[tier], now_ms, budget_bytes - spent);
+      if (n < 0) {
+        fprintf(stderr, "retention: cannot trim rollup tier %d\n", tier);
+        return -1;
+      }
+      spent += n;
+    }
+  }
+  return spent;
+}
@@ -0,0 +1,39 @@
+//
+//  retention.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef retention_h
+#define retention_h
+
+#include "event_log.h"
+#include "rollup.h"
+#include "telemetry_store.h"
+#include <stdint.h>
+
+// Age-based retention across the history stores. Raw telemetry is thinned
+// to averages as it ages, fine rollup tiers are trimmed once a coarser tier
+// covers the same span, and old events are dropped. Session records are
+// small and kept in full.
+
+typedef struct {
+  ts_retention_t telemetry;
+  int64_t minute_rollup_age_ms; // 0 keeps everything
+  int64_t hour_rollup_age_ms;
+  int64_t event_age_ms;
+} ret_policy_t;
+
+// 30 days of raw samples then 5 minute averages, 1m rollups for 30 days,
+// 1h rollups for two years, events for one year; 1d rollups and telemetry
+// averages are kept
+ret_policy_t ret_default_policy(void);
+
+// One retention pass, stopping after about budget_bytes of I/O so it can
+// run on a timer without a noticeable stall. Any store may be NULL.
+// Returns the bytes spent (0 when everything is within policy) or -1.
+int64_t ret_run(const ret_policy_t *policy, ts_store_t *store, rollup_t *rollups,
+                elog_t *events, int64_t now_ms, int64_t budget_bytes);
+
+#endif
@@ -0,0 +1,397 @@
+//
+//  rollup.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "rollup.h"
+#include "store_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// One file per tier: 16-byte header, then buckets in time order. The last
+// slot holds the open bucket, rewritten in place until it closes.
+#define ROLLUP_MAGIC 0x55524342u // "BCRU" little-endian
+#define ROLLUP_VERSION 1u
+#define ROLLUP_HEADER 16
+
+_Static_assert(sizeof(rollup_bucket_t) == 160, "rollup_bucket_t layout changed");
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t width_s;
+} rollup_header_t;
+
+typedef struct {
+  int fd;
+  char path[1024];
+  size_t count; // closed buckets
+  const uint8_t *map;
+  size_t map_len;
+  rollup_bucket_t open;
+  int has_open;
+  // A trim in progress: the surviving buckets are copied to a sibling file a
+  // budget at a time, and the copy replaces the file once it has caught up
+  int trim_fd;
+  size_t trim_next; // next closed bucket to copy
+  size_t trim_out;  // buckets copied so far
+} tier_t;
+
+struct rollup {
+  tier_t tiers[ROLLUP_TIERS];
+};
+
+static const int64_t k_widths[ROLLUP_TIERS] = {60000, 3600000, 86400000};
+static const char *const k_names[ROLLUP_TIERS] = {"1m", "1h", "1d"};
+
+int64_t rollup_tier_width(int tier) {
+  return tier >= 0 && tier < ROLLUP_TIERS ? k_widths[tier] : 0;
+}
+
+int rollup_pick_tier(int64_t resolution_ms) {
+  for (int t = ROLLUP_TIERS - 1; t > 0; t--)
+    if (k_widths[t] <= resolution_ms)
+      return t;
+  return ROLLUP_1M;
+}
+
+static void field_values(const pdev_sample_t *s, float *v) {
+  v[RF_LEVEL] = (float)s->level;
+  v[RF_AMPERAGE] = (float)s->amperage_ma;
+  v[RF_VOLTAGE] = (float)s->voltage_mv;
+  v[RF_TEMP] = (float)s->temp_cc;
+  v[RF_WATTS] = s->power_w;
+  v[RF_PLUGGED] = s->plugged ? 1.0f : 0.0f;
+  v[RF_CHARGING] = s->charging ? 1.0f : 0.0f;
+}
+
+static void bucket_start(rollup_bucket_t *b, int64_t start_ms,
+                         const float *v) {
+  memset(b, 0, sizeof(*b));
+  b->start_ms = start_ms;
+  b->count = 1;
+  for (int f = 0; f < ROLLUP_FIELDS; f++) {
+    b->sum[f] = v[f];
+    b->min[f] = b->max[f] = b->last[f] = v[f];
+  }
+}
+
+static void bucket_fold(rollup_bucket_t *b, const float *v) {
+  b->count++;
+  for (int f = 0; f < ROLLUP_FIELDS; f++) {
+    b->sum[f] += v[f];
+    if (v[f] < b->min[f])
+      b->min[f] = v[f];
+    if (v[f] > b->max[f])
+      b->max[f] = v[f];
+    b->last[f] = v[f];
+  }
+}
+
+static int write_slot(tier_t *t, size_t slot, const rollup_bucket_t *b) {
+  off_t off = (off_t)(ROLLUP_HEADER + slot * sizeof(rollup_bucket_t));
+  if (pwrite(t->fd, b, sizeof(*b), off) != (ssize_t)sizeof(*b)) {
+    fprintf(stderr, "rollup: write failed: %s\n", strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+static void tier_unmap(tier_t *t) {
+  if (t->map)
+    munmap((void *)t->map, t->map_len);
+  t->map = NULL;
+  t->map_len = 0;
+}
+
+// Maps the closed buckets; the open one is served from memory
+static int tier_remap(tier_t *t) {
+  tier_unmap(t);
+  if (t->count == 0)
+    return 0;
+  size_t len = ROLLUP_HEADER + t->count * sizeof(rollup_bucket_t);
+  void *m = mmap(NULL, len, PROT_READ, MAP_SHARED, t->fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr, "rollup: mmap failed: %s\n", strerror(errno));
+    return -1;
+  }
+  t->map = m;
+  t->map_len = len;
+  return 0;
+}
+
+static const rollup_bucket_t *closed_bucket(const tier_t *t, size_t i) {
+  return (const rollup_bucket_t *)(t->map + ROLLUP_HEADER) + i;
+}
+
+static void trim_path(const tier_t *t, char *out, size_t size) {
+  snprintf(out, size, "%s.trim", t->path);
+}
+
+static void trim_abort(tier_t *t) {
+  if (t->trim_fd < 0)
+    return;
+  char path[1040];
+  trim_path(t, path, sizeof(path));
+  close(t->trim_fd);
+  unlink(path);
+  t->trim_fd = -1;
+}
+
+// Appends the open bucket to the copy and puts the copy in place of the
+// tier's file; returns the bytes written or -1
+static int64_t trim_finish(tier_t *t) {
+  char path[1040];
+  trim_path(t, path, sizeof(path));
+  int64_t written = 0;
+  if (t->has_open) {
+    off_t off =
+        (off_t)(ROLLUP_HEADER + t->trim_out * sizeof(rollup_bucket_t));
+    if (pwrite(t->trim_fd, &t->open, sizeof(t->open), off) !=
+        (ssize_t)sizeof(t->open))
+      return -1;
+    written = sizeof(t->open);
+  }
+  if (store_sync(t->trim_fd) != 0 || rename(path, t->path) != 0)
+    return -1;
+  store_sync_dir(t->path);
+
+  // The copy's descriptor is the tier's file now
+  tier_unmap(t);
+  close(t->fd);
+  t->fd = t->trim_fd;
+  t->trim_fd = -1;
+  t->count = t->trim_out;
+  if (tier_remap(t) != 0)
+    return -1;
+  return written;
+}
+
+static int tier_open(tier_t *t, const char *dir, int tier) {
+  snprintf(t->path, sizeof(t->path), "%s/rollup-%s.bcr", dir, k_names[tier]);
+  const char *path = t->path;
+  t->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (t->fd < 0) {
+    fprintf(stderr, "rollup: cannot open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  struct stat st;
+  if (fstat(t->fd, &st) != 0)
+    return -1;
+  rollup_header_t hdr;
+  if (st.st_size < ROLLUP_HEADER) {
+    hdr = (rollup_header_t){ROLLUP_MAGIC, ROLLUP_VERSION,
+                            sizeof(rollup_bucket_t),
+                            (uint32_t)(k_widths[tier] / 1000)};
+    if (ftruncate(t->fd, 0) != 0 ||
+        pwrite(t->fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+      return -1;
+    st.st_size = ROLLUP_HEADER;
+  } else if (store_pread_all(t->fd, &hdr, sizeof(hdr), 0) != 0 ||
+             hdr.magic != ROLLUP_MAGIC ||
+             hdr.record_size != sizeof(rollup_bucket_t)) {
+    fprintf(stderr, "rollup: %s is not a rollup file\n", path);
+    return -1;
+  }
+
+  size_t n = ((size_t)st.st_size - ROLLUP_HEADER) / sizeof(rollup_bucket_t);
+  if (n > 0) {
+    // The last slot is the bucket that was open when we last stopped
+    if (store_pread_all(t->fd, &t->open, sizeof(t->open),
+                        (int64_t)(ROLLUP_HEADER +
+                                  (n - 1) * sizeof(rollup_bucket_t))) != 0)
+      return -1;
+    t->has_open = 1;
+    t->count = n - 1;
+  }
+  return tier_remap(t);
+}
+
+// First closed bucket starting at or after t_ms
+static size_t tier_lower_bound(const tier_t *t, int64_t t_ms) {
+  size_t lo = 0, hi = t->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (closed_bucket(t, mid)->start_ms < t_ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+static int tier_add(tier_t *t, int64_t width, int64_t t_ms, const float *v) {
+  int64_t start = t_ms - (t_ms % width);
+  if (t->has_open && start == t->open.start_ms) {
+    bucket_fold(&t->open, v);
+    return 0;
+  }
+  if (t->has_open) {
+    if (start < t->open.start_ms)
+      return -1; // clock went backwards
+    if (write_slot(t, t->count, &t->open) != 0)
+      return -1;
+    t->count++;
+  }
+  bucket_start(&t->open, start, v);
+  t->has_open = 1;
+  return 0;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+rollup_t *rollup_open(const char *dir) {
+  rollup_t *r = calloc(1, sizeof(rollup_t));
+  if (r == NULL)
+    return NULL;
+  for (int i = 0; i < ROLLUP_TIERS; i++)
+    r->tiers[i].fd = r->tiers[i].trim_fd = -1;
+  for (int i = 0; i < ROLLUP_TIERS; i++) {
+    if (tier_open(&r->tiers[i], dir, i) != 0) {
+      rollup_close(r);
+      return NULL;
+    }
+  }
+  return r;
+}
+
+int rollup_flush(rollup_t *r) {
+  if (r == NULL)
+    return -1;
+  int rc = 0;
+  for (int i = 0; i < ROLLUP_TIERS; i++) {
+    tier_t *t = &r->tiers[i];
+    if (t->fd < 0)
+      continue;
+    if (t->has_open && write_slot(t, t->count, &t->open) != 0)
+      rc = -1;
+    if (fsync(t->fd) != 0)
+      rc = -1;
+  }
+  return rc;
+}
+
+void rollup_close(rollup_t *r) {
+  if (r == NULL)
+    return;
+  rollup_flush(r);
+  for (int i = 0; i < ROLLUP_TIERS; i++) {
+    trim_abort(&r->tiers[i]); // started over at the next launch
+    tier_unmap(&r->tiers[i]);
+    if (r->tiers[i].fd >= 0)
+      close(r->tiers[i].fd);
+  }
+  free(r);
+}
+
+int rollup_add(rollup_t *r, const pdev_sample_t *s) {
+  if (r == NULL || s == NULL || s->t_ms < 0)
+    return -1;
+  float v[ROLLUP_FIELDS];
+  field_values(s, v);
+  int rc = 0;
+  for (int i = 0; i < ROLLUP_TIERS; i++)
+    if (tier_add(&r->tiers[i], k_widths[i], s->t_ms, v) != 0)
+      rc = -1;
+  return rc;
+}
+
+int rollup_query(rollup_t *r, int tier, int64_t from_ms, int64_t to_ms,
+                 rollup_bucket_t *out, size_t max) {
+  if (r == NULL || tier < 0 || tier >= ROLLUP_TIERS || (out == NULL && max))
+    return -1;
+  tier_t *t = &r->tiers[tier];
+  if (t->map_len < ROLLUP_HEADER + t->count * sizeof(rollup_bucket_t) &&
+      tier_remap(t) != 0)
+    return -1;
+
+  size_t lo = tier_lower_bound(t, from_ms);
+  size_t n = 0;
+  for (size_t i = lo; i < t->count && n < max; i++) {
+    const rollup_bucket_t *b = closed_bucket(t, i);
+    if (b->start_ms >= to_ms)
+      return (int)n;
+    out[n++] = *b;
+  }
+  if (t->has_open && n < max && t->open.start_ms >= from_ms &&
+      t->open.start_ms < to_ms)
+    out[n++] = t->open;
+  return (int)n;
+}
+
+int64_t rollup_trim(rollup_t *r, int tier, int64_t before_ms,
+                    int64_t budget_bytes) {
+  if (r == NULL || tier < 0 || tier >= ROLLUP_TIERS)
+    return -1;
+  tier_t *t = &r->tiers[tier];
+  if (t->map_len < ROLLUP_HEADER + t->count * sizeof(rollup_bucket_t) &&
+      tier_remap(t) != 0)
+    return -1;
+  int64_t written = 0;
+  if (t->trim_fd < 0) {
+    size_t drop = tier_lower_bound(t, before_ms);
+    if (drop == 0)
+      return 0;
+    char path[1040];
+    trim_path(t, path, sizeof(path));
+    t->trim_fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (t->trim_fd < 0) {
+      fprintf(stderr, "rollup: cannot create %s: %s\n", path,
+              strerror(errno));
+      return -1;
+    }
+    if (pwrite(t->trim_fd, t->map, ROLLUP_HEADER, 0) != ROLLUP_HEADER) {
+      trim_abort(t);
+      return -1;
+    }
+    t->trim_next = drop;
+    t->trim_out = 0;
+    written = ROLLUP_HEADER;
+  }
+
+  // Straight from the map; buckets closed since the last pass are at the
+  // end and are copied like the rest
+  size_t n = t->count - t->trim_next;
+  size_t per_pass = (size_t)(budget_bytes > 0 ? budget_bytes : 0) /
+                    sizeof(rollup_bucket_t);
+  if (per_pass == 0)
+    per_pass = 1;
+  if (n > per_pass)
+    n = per_pass;
+  if (n > 0) {
+    off_t off =
+        (off_t)(ROLLUP_HEADER + t->trim_out * sizeof(rollup_bucket_t));
+    ssize_t len = (ssize_t)(n * sizeof(rollup_bucket_t));
+    if (pwrite(t->trim_fd, closed_bucket(t, t->trim_next), (size_t)len,
+               off) != len) {
+      fprintf(stderr, "rollup: trim write failed: %s\n", strerror(errno));
+      trim_abort(t);
+      return -1;
+    }
+    t->trim_next += n;
+    t->trim_out += n;
+    written += len;
+    if (t->trim_next < t->count)
+      return written;
+  }
+
+  int64_t last = trim_finish(t);
+  if (last < 0) {
+    fprintf(stderr, "rollup: cannot replace %s: %s\n", t->path,
+            strerror(errno));
+    trim_abort(t);
+    return -1;
+  }
+  return written + last;
+}
@@ -0,0 +1,81 @@
+//
+//  rollup.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef rollup_h
+#define rollup_h
+
+#include "power_device.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Persisted 1 minute / 1 hour / 1 day aggregates of battery telemetry,
+// updated incrementally as each sample arrives. Long-range views read the
+// coarsest tier that still meets their resolution instead of raw samples.
+
+typedef enum {
+  ROLLUP_1M = 0,
+  ROLLUP_1H,
+  ROLLUP_1D,
+  ROLLUP_TIERS
+} rollup_tier_t;
+
+typedef enum {
+  RF_LEVEL = 0,
+  RF_AMPERAGE, // mA
+  RF_VOLTAGE,  // mV
+  RF_TEMP,     // centi-degrees C
+  RF_WATTS,
+  RF_PLUGGED, // 0/1, so the mean is the fraction of time plugged in
+  RF_CHARGING,
+  ROLLUP_FIELDS
+} rollup_field_t;
+
+// Buckets are aligned to multiples of the tier width since 1970 (UTC)
+typedef struct {
+  int64_t start_ms;
+  uint32_t count;
+  uint32_t reserved;
+  double sum[ROLLUP_FIELDS];
+  float min[ROLLUP_FIELDS];
+  float max[ROLLUP_FIELDS];
+  float last[ROLLUP_FIELDS];
+  uint32_t pad;
+} rollup_bucket_t;
+
+typedef struct rollup rollup_t;
+
+// Opens the tiers under dir (which must exist)
+rollup_t *rollup_open(const char *dir);
+void rollup_close(rollup_t *r); // persists the open buckets
+
+// O(tiers): folds the sample into the open bucket of every tier, writing a
+// bucket out when a sample lands past its end
+int rollup_add(rollup_t *r, const pdev_sample_t *sample);
+
+// Persists the open buckets without closing them
+int rollup_flush(rollup_t *r);
+
+int64_t rollup_tier_width(int tier); // ms
+
+// Coarsest tier whose bucket width is at most resolution_ms (1m if none)
+int rollup_pick_tier(int64_t resolution_ms);
+
+// Buckets with from_ms <= start_ms < to_ms, oldest first, including the open
+// one; returns the number copied (at most max) or -1
+int rollup_query(rollup_t *r, int tier, int64_t from_ms, int64_t to_ms,
+                 rollup_bucket_t *out, size_t max);
+
+// Drops closed buckets that start before before_ms. The buckets kept are
+// copied to a new file about budget_bytes per call (at least one bucket),
+// and the copy replaces the tier's file atomically once it has caught up;
+// before_ms is fixed by the call that starts a trim, and later calls carry
+// it on. Queries read the old file until then. Returns the bytes written (0
+// when there is nothing to drop) or -1.
+int64_t rollup_trim(rollup_t *r, int tier, int64_t before_ms,
+                    int64_t budget_bytes);
+
+#endif
@@ -0,0 +1,180 @@
+//
+//  session_log.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "session_log.h"
+#include "store_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout: 16-byte header, then slog_record_t back to back
+#define SLOG_MAGIC 0x4C534342u // "BCSL" little-endian
+#define SLOG_VERSION 1u
+#define SLOG_HEADER 16
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t reserved;
+} slog_header_t;
+
+struct slog {
+  int fd;
+  size_t count;
+  // Read-only view of the file, remapped lazily when reads pass its end
+  const uint8_t *map;
+  size_t map_len;
+};
+
+_Static_assert(sizeof(slog_record_t) == 32, "slog_record_t layout changed");
+
+static uint32_t record_crc(const slog_record_t *rec) {
+  return store_crc32(rec, offsetof(slog_record_t, crc));
+}
+
+static void unmap(slog_t *log) {
+  if (log->map)
+    munmap((void *)log->map, log->map_len);
+  log->map = NULL;
+  log->map_len = 0;
+}
+
+static int remap(slog_t *log) {
+  unmap(log);
+  size_t len = SLOG_HEADER + log->count * sizeof(slog_record_t);
+  void *m = mmap(NULL, len, PROT_READ, MAP_SHARED, log->fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr, "slog: mmap failed: %s\n", strerror(errno));
+    return -1;
+  }
+  log->map = m;
+  log->map_len = len;
+  return 0;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+slog_t *slog_open(const char *path) {
+  int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "slog: cannot open %s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return NULL;
+  }
+
+  slog_header_t hdr;
+  if (st.st_size < SLOG_HEADER) {
+    // New (or header-torn) file: start over with a fresh header
+    hdr = (slog_header_t){SLOG_MAGIC, SLOG_VERSION, sizeof(slog_record_t), 0};
+    if (ftruncate(fd, 0) != 0 ||
+        store_write_all(fd, &hdr, sizeof(hdr)) != 0) {
+      fprintf(stderr, "slog: cannot initialise %s\n", path);
+      close(fd);
+      return NULL;
+    }
+    st.st_size = SLOG_HEADER;
+  } else if (pread(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) ||
+             hdr.magic != SLOG_MAGIC ||
+             hdr.record_size != sizeof(slog_record_t)) {
+    fprintf(stderr, "slog: %s is not a session log\n", path);
+    close(fd);
+    return NULL;
+  }
+
+  slog_t *log = calloc(1, sizeof(slog_t));
+  if (log == NULL) {
+    close(fd);
+    return NULL;
+  }
+  log->fd = fd;
+  size_t body = (size_t)st.st_size - SLOG_HEADER;
+  log->count = body / sizeof(slog_record_t);
+  if (body % sizeof(slog_record_t) != 0) {
+    // Interrupted append: drop the partial record
+    ftruncate(fd, (off_t)(SLOG_HEADER + log->count * sizeof(slog_record_t)));
+  }
+  if (log->count > 0 && remap(log) != 0) {
+    slog_close(log);
+    return NULL;
+  }
+  return log;
+}
+
+void slog_close(slog_t *log) {
+  if (log == NULL)
+    return;
+  unmap(log);
+  close(log->fd);
+  free(log);
+}
+
+int slog_append_many(slog_t *log, const slog_record_t *recs, size_t n) {
+  if (log == NULL || (recs == NULL && n > 0))
+    return -1;
+  if (n == 0)
+    return 0;
+  slog_record_t *buf = malloc(n * sizeof(slog_record_t));
+  if (buf == NULL)
+    return -1;
+  for (size_t i = 0; i < n; i++) {
+    buf[i] = recs[i];
+    buf[i].crc = record_crc(&buf[i]);
+  }
+  // O_APPEND: one write lands at the end no matter how large the file is
+  int rc = store_write_all(log->fd, buf, n * sizeof(slog_record_t));
+  free(buf);
+  if (rc != 0 || fsync(log->fd) != 0) {
+    int err = errno;
+    // Cut back to the last whole record, or every later append would land
+    // misaligned behind the partial one
+    off_t whole = (off_t)(SLOG_HEADER + log->count * sizeof(slog_record_t));
+    if (ftruncate(log->fd, whole) != 0)
+      fprintf(stderr, "slog: cannot roll back append: %s\n", strerror(errno));
+    fprintf(stderr, "slog: append failed: %s\n", strerror(err));
+    return -1;
+  }
+  log->count += n;
+  return 0;
+}
+
+int slog_append(slog_t *log, const slog_record_t *rec) {
+  return slog_append_many(log, rec, 1);
+}
+
+size_t slog_count(const slog_t *log) { return log ? log->count : 0; }
+
+int slog_read(slog_t *log, size_t index, slog_record_t *out) {
+  if (log == NULL || out == NULL || index >= log->count)
+    return -1;
+  size_t off = SLOG_HEADER + index * sizeof(slog_record_t);
+  if (off + sizeof(slog_record_t) > log->map_len && remap(log) != 0)
+    return -1;
+  memcpy(out, log->map + off, sizeof(slog_record_t));
+  return out->crc == record_crc(out) ? 0 : -1;
+}
+
+int slog_clear(slog_t *log) {
+  if (log == NULL)
+    return -1;
+  unmap(log);
+  if (ftruncate(log->fd, SLOG_HEADER) != 0)
+    return -1;
+  log->count = 0;
+  return 0;
+}
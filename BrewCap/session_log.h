@@ -0,0 +1,47 @@
+//
+//  session_log.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef session_log_h
+#define session_log_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One finished charge session. Fixed size so appends are a single write and
+// record i lives at a computable offset in the mapped file.
+typedef struct {
+  int64_t start_ms; // ms since 1970
+  int64_t end_ms;
+  int16_t start_level;
+  int16_t end_level;
+  int32_t duration_min;
+  int32_t adapter_watts;
+  uint32_t crc; // CRC-32 of the preceding bytes
+} slog_record_t;
+
+typedef struct slog slog_t;
+
+// Opens (creating if needed) the log at path. A torn record at the tail from
+// an interrupted write is truncated away.
+slog_t *slog_open(const char *path);
+void slog_close(slog_t *log);
+
+// Appends are O(1) regardless of how much history the file holds
+int slog_append(slog_t *log, const slog_record_t *rec);
+// Appends several records with one write, e.g. for a one-time import
+int slog_append_many(slog_t *log, const slog_record_t *recs, size_t n);
+
+size_t slog_count(const slog_t *log);
+
+// Copies record index (0 = oldest) out of the mapping; -1 if the index is out
+// of range or the record fails its checksum
+int slog_read(slog_t *log, size_t index, slog_record_t *out);
+
+// Drops every record, keeping the file
+int slog_clear(slog_t *log);
+
+#endif
@@ -9,19 +9,34 @@
 #include <CoreFoundation/CoreFoundation.h>
 #include <IOKit/IOKitLib.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
 
 // ============================================================
 // Method 1: IORegistry property writes on AppleSmartBattery
 // This is the Apple Silicon-compatible approach.
 // ============================================================
 
+static bsim_t *g_sim = NULL;
+
 static io_service_t get_battery_service(void) {
   return IOServiceGetMatchingService(kIOMainPortDefault,
                                      IOServiceMatching("AppleSmartBattery"));
 }
 
 static int set_battery_property(const char *key, CFTypeRef value) {
+  if (g_sim) {
+    int64_t v = 0;
+    if (CFGetTypeID(value) == CFBooleanGetTypeID())
+      v = CFBooleanGetValue((CFBooleanRef)value);
+    else if (CFGetTypeID(value) != CFNumberGetTypeID() ||
+             !CFNumberGetValue((CFNumberRef)value, kCFNumberSInt64Type, &v))
+      return -1;
+    return bsim_set_property(g_sim, key, v);
+  }
+
   io_service_t service = get_battery_service();
   if (service == IO_OBJECT_NULL) {
     fprintf(stderr, "battery: AppleSmartBattery service not found\n");
@@ -97,8 +112,38 @@ static uint32_t four_char_code(const char *key) {
   return result;
 }
 
+#define SMC_RESULT_NOT_FOUND 0x84
+
+// The SMC protocol answered by the simulator
+static kern_return_t sim_call(const SMCParamStruct *in, SMCParamStruct *out) {
+  char key[5] = {(char)(in->key >> 24), (char)(in->key >> 16),
+                 (char)(in->key >> 8), (char)in->key, 0};
+  switch (in->data8) {
+  case SMC_CMD_READ_KEYINFO:
+    // Like the hardware: a missing key is a result code with no size
+    if (bsim_key_info(g_sim, key, &out->keyInfo.dataType,
+                      &out->keyInfo.dataSize) != 0)
+      out->result = SMC_RESULT_NOT_FOUND;
+    return KERN_SUCCESS;
+  case SMC_CMD_READ_BYTES: {
+    uint32_t size = 0;
+    if (bsim_read_key(g_sim, key, out->bytes, &size) != 0)
+      out->result = SMC_RESULT_NOT_FOUND;
+    return KERN_SUCCESS;
+  }
+  case SMC_CMD_WRITE_BYTES:
+    if (bsim_write_key(g_sim, key, in->bytes, in->keyInfo.dataSize) != 0)
+      return kIOReturnNotWritable;
+    return KERN_SUCCESS;
+  default:
+    return kIOReturnUnsupported;
+  }
+}
+
 static kern_return_t smc_call(SMCParamStruct *in_struct,
                               SMCParamStruct *out_struct) {
+  if (g_sim)
+    return sim_call(in_struct, out_struct);
   size_t in_size = sizeof(SMCParamStruct);
   size_t out_size = sizeof(SMCParamStruct);
   return IOConnectCallStructMethod(g_smc_conn, KERNEL_INDEX_SMC, in_struct,
@@ -125,7 +170,11 @@ static int smc_read_key_info(uint32_t key, SMCKeyInfoData *info) {
 // Public API
 // ============================================================
 
+void smc_attach_simulator(bsim_t *sim) { g_sim = sim; }
+
 int smc_open(void) {
+  if (g_sim)
+    return 0;
   io_service_t service = IOServiceGetMatchingService(
       kIOMainPortDefault, IOServiceMatching("AppleSMC"));
   if (service == IO_OBJECT_NULL) {
@@ -149,24 +198,21 @@ void smc_close(void) {
   }
 }
 
-int smc_read_key(const char *key, uint8_t *out_bytes, uint32_t *out_size) {
-  uint32_t k = four_char_code(key);
-  SMCKeyInfoData info;
-  if (smc_read_key_info(k, &info) != 0)
-    return -1;
-
+// Read with key info already known — one SMC call instead of two
+static int smc_read_bytes(uint32_t key, const SMCKeyInfoData *info,
+                          uint8_t *out_bytes, uint32_t *out_size) {
   SMCParamStruct in_s, out_s;
   memset(&in_s, 0, sizeof(in_s));
   memset(&out_s, 0, sizeof(out_s));
-  in_s.key = k;
-  in_s.keyInfo = info;
+  in_s.key = key;
+  in_s.keyInfo = *info;
   in_s.data8 = SMC_CMD_READ_BYTES;
 
   kern_return_t result = smc_call(&in_s, &out_s);
-  if (result != KERN_SUCCESS)
+  if (result != KERN_SUCCESS || out_s.result != 0)
     return -1;
 
-  uint32_t size = info.dataSize;
+  uint32_t size = info->dataSize;
   if (size > 32)
     size = 32;
   memcpy(out_bytes, out_s.bytes, size);
@@ -174,6 +220,14 @@ int smc_read_key(const char *key, uint8_t *out_bytes, uint32_t *out_size) {
   return 0;
 }
 
+int smc_read_key(const char *key, uint8_t *out_bytes, uint32_t *out_size) {
+  uint32_t k = four_char_code(key);
+  SMCKeyInfoData info;
+  if (smc_read_key_info(k, &info) != 0)
+    return -1;
+  return smc_read_bytes(k, &info, out_bytes, out_size);
+}
+
 int smc_write_key(const char *key, const uint8_t *bytes, uint32_t size) {
   uint32_t k = four_char_code(key);
   SMCKeyInfoData info;
@@ -203,34 +257,65 @@ int smc_write_key(const char *key, const uint8_t *bytes, uint32_t size) {
 // Charging Control — tries multiple methods
 // ============================================================
 
-int smc_disable_charging(void) {
+// IORegistry ChargeInhibit, with ChargeRate as a second try
+static int set_charge_inhibit(int inhibit) {
   int success = 0;
+  if (set_battery_property("ChargeInhibit",
+                           inhibit ? kCFBooleanTrue : kCFBooleanFalse) == 0) {
+    success = 1;
+  }
 
-  // Method 1: IORegistry — set ChargeInhibit on AppleSmartBattery
-  fprintf(stdout, "Trying IORegistry ChargeInhibit...\n");
-  if (set_battery_property("ChargeInhibit", kCFBooleanTrue) == 0) {
+  int32_t rate = inhibit ? 0 : -1;
+  CFNumberRef cfRate =
+      CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &rate);
+  if (set_battery_property("ChargeRate", cfRate) == 0) {
     success = 1;
   }
+  CFRelease(cfRate);
+
+  return success ? 0 : -1;
+}
+
+int smc_set_charging(smc_charge_method_t method, int enabled) {
+  switch (method) {
+  case SMC_CHARGE_CHTE: {
+    // Apple Silicon on macOS 26 (Tahoe)
+    uint8_t val[4] = {enabled ? 0x00 : 0x01, 0x00, 0x00, 0x00};
+    return smc_write_key("CHTE", val, 4);
+  }
+  case SMC_CHARGE_CH0B: {
+    // Intel Macs
+    uint8_t val = enabled ? 0x00 : 0x02;
+    return smc_write_key("CH0B", &val, 1);
+  }
+  case SMC_CHARGE_CH0I: {
+    uint8_t val = enabled ? 0x00 : 0x01;
+    return smc_write_key("CH0I", &val, 1);
+  }
+  case SMC_CHARGE_INHIBIT:
+    return set_charge_inhibit(!enabled);
+  default:
+    return -1;
+  }
+}
 
-  // Method 1b: Also try setting a charge rate of 0
-  int32_t zero = 0;
-  CFNumberRef cfZero =
-      CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &zero);
-  if (set_battery_property("ChargeRate", cfZero) == 0) {
+int smc_disable_charging(void) {
+  int success = 0;
+
+  // Method 1: IORegistry — set ChargeInhibit on AppleSmartBattery
+  fprintf(stdout, "Trying IORegistry ChargeInhibit...\n");
+  if (smc_set_charging(SMC_CHARGE_INHIBIT, 0) == 0) {
     success = 1;
   }
-  CFRelease(cfZero);
 
   // Method 2: SMC CH0B (works on Intel Macs)
   fprintf(stdout, "Trying SMC CH0B...\n");
-  uint8_t val = 0x02;
-  if (smc_write_key("CH0B", &val, 1) == 0) {
+  if (smc_set_charging(SMC_CHARGE_CH0B, 0) == 0) {
     success = 1;
   }
 
   // Method 3: SMC CH0I
-  uint8_t val_i = 0x01;
-  if (smc_write_key("CH0I", &val_i, 1) == 0) {
+  if (smc_set_charging(SMC_CHARGE_CH0I, 0) == 0) {
     success = 1;
   }
 
@@ -241,26 +326,16 @@ int smc_enable_charging(void) {
   int success = 0;
 
   // Method 1: IORegistry
-  if (set_battery_property("ChargeInhibit", kCFBooleanFalse) == 0) {
-    success = 1;
-  }
-
-  int32_t negOne = -1;
-  CFNumberRef cfNeg =
-      CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &negOne);
-  if (set_battery_property("ChargeRate", cfNeg) == 0) {
+  if (smc_set_charging(SMC_CHARGE_INHIBIT, 1) == 0) {
     success = 1;
   }
-  CFRelease(cfNeg);
 
   // Method 2: SMC
-  uint8_t val = 0x00;
-  if (smc_write_key("CH0B", &val, 1) == 0) {
+  if (smc_set_charging(SMC_CHARGE_CH0B, 1) == 0) {
     success = 1;
   }
 
-  uint8_t val_i = 0x00;
-  if (smc_write_key("CH0I", &val_i, 1) == 0) {
+  if (smc_set_charging(SMC_CHARGE_CH0I, 1) == 0) {
     success = 1;
   }
 
@@ -286,3 +361,267 @@ int smc_get_bclm(uint8_t *out_percentage) {
   uint32_t size = 0;
   return smc_read_key("BCLM", out_percentage, &size);
 }
+
+// ============================================================
+// Data type decoding
+// ============================================================
+
+#define SMC_TYPE(a, b, c, d)                                                   \
+  (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) |     \
+   (uint32_t)(d))
+
+static int hex_digit(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// Asks the hardware, not the compiler, so an x86_64 slice running under
+// Rosetta still decodes Apple Silicon keys correctly
+static int is_apple_silicon(void) {
+  static int cached = -1;
+  if (g_sim)
+    return 1; // the simulator speaks Apple Silicon types and byte order
+  if (cached < 0) {
+    int arm64 = 0;
+    size_t len = sizeof(arm64);
+    if (sysctlbyname("hw.optional.arm64", &arm64, &len, NULL, 0) != 0)
+      arm64 = 0;
+    cached = arm64 ? 1 : 0;
+  }
+  return cached;
+}
+
+// Integer keys are little-endian on Apple Silicon, big-endian on Intel
+static uint64_t load_uint(const uint8_t *b, uint32_t size) {
+  uint64_t v = 0;
+  if (is_apple_silicon()) {
+    for (uint32_t i = size; i > 0; i--)
+      v = (v << 8) | b[i - 1];
+  } else {
+    for (uint32_t i = 0; i < size; i++)
+      v = (v << 8) | b[i];
+  }
+  return v;
+}
+
+int smc_decode_value(uint32_t data_type, const uint8_t *bytes, uint32_t size,
+                     double *out) {
+  char t[4] = {(char)(data_type >> 24), (char)(data_type >> 16),
+               (char)(data_type >> 8), (char)data_type};
+
+  if (data_type == SMC_TYPE('f', 'l', 't', ' ') && size == 4) {
+    float f;
+    memcpy(&f, bytes, 4);
+    *out = f;
+    return 0;
+  }
+  if (data_type == SMC_TYPE('i', 'o', 'f', 't') && size == 8) {
+    int64_t v;
+    memcpy(&v, bytes, 8); // 48.16 fixed point, little-endian
+    *out = (double)v / 65536.0;
+    return 0;
+  }
+  // spXY / fpXY: 16-bit big-endian fixed point with Y fraction bits
+  if ((t[0] == 's' || t[0] == 'f') && t[1] == 'p' && size == 2) {
+    int frac = hex_digit(t[3]);
+    if (frac < 0)
+      return -1;
+    uint16_t raw = (uint16_t)((bytes[0] << 8) | bytes[1]);
+    double scale = (double)(1 << frac);
+    *out = t[0] == 's' ? (double)(int16_t)raw / scale : (double)raw / scale;
+    return 0;
+  }
+  if (t[0] == 'u' && t[1] == 'i' && size >= 1 && size <= 8) {
+    *out = (double)load_uint(bytes, size);
+    return 0;
+  }
+  if (t[0] == 's' && t[1] == 'i' && size >= 1 && size <= 8) {
+    uint64_t v = load_uint(bytes, size);
+    uint32_t bits = size * 8;
+    if (bits < 64 && (v >> (bits - 1)) & 1)
+      v |= ~0ULL << bits; // sign-extend
+    *out = (double)(int64_t)v;
+    return 0;
+  }
+  if (data_type == SMC_TYPE('f', 'l', 'a', 'g') && size == 1) {
+    *out = bytes[0];
+    return 0;
+  }
+  return -1;
+}
+
+// ============================================================
+// Sensor sweep
+// A catalog is resolved once per model: every candidate key is probed for
+// its key info a single time, the misses are dropped, and the result is
+// cached on disk keyed by hw.model. The sweep then issues one READ_BYTES per
+// surviving key over the already-open connection.
+// ============================================================
+
+#define SMC_CATALOG_MAX 48
+
+enum { ROLE_SYSTEM, ROLE_DC_IN, ROLE_BATTERY, ROLE_TEMP };
+
+typedef struct {
+  char key[5];
+  uint32_t code;
+  int role;
+  SMCKeyInfoData info;
+} catalog_entry_t;
+
+struct smc_catalog {
+  char model[64];
+  int count;
+  catalog_entry_t entries[SMC_CATALOG_MAX];
+};
+
+static const char *const k_power_keys[] = {"PSTR", "PDTR", "PPBR"};
+
+// Temperature families: TB = battery cells, Tp/TC = CPU, Tg/TG = GPU,
+// Ts = palm rest, TW = wireless module
+static const char *const k_temps_apple_silicon[] = {
+    "TB0T", "TB1T", "TB2T", "Tp01", "Tp05", "Tp09", "Tp0D", "Tp0b", "Tp0f",
+    "Tp0j", "Tp0n", "Tg05", "Tg0D", "Tg0f", "Ts0P", "Ts1P", "TW0P", NULL};
+
+static const char *const k_temps_intel[] = {
+    "TB0T", "TB1T", "TB2T", "TC0P", "TC0E", "TC0F", "TC1C", "TC2C",
+    "TG0P", "TG0D", "Ts0P", "Ts0S", "TW0P", "TM0P", "TH0P", NULL};
+
+static void model_identifier(char *out, size_t size) {
+  if (g_sim) {
+    snprintf(out, size, "simulator");
+    return;
+  }
+  size_t len = size;
+  if (sysctlbyname("hw.model", out, &len, NULL, 0) != 0)
+    snprintf(out, size, "unknown");
+}
+
+static void catalog_probe(smc_catalog_t *cat, const char *key, int role) {
+  if (cat->count >= SMC_CATALOG_MAX)
+    return;
+  uint32_t code = four_char_code(key);
+  SMCKeyInfoData info;
+  if (smc_read_key_info(code, &info) != 0 || info.dataSize == 0)
+    return;
+  catalog_entry_t *e = &cat->entries[cat->count++];
+  snprintf(e->key, sizeof(e->key), "%s", key);
+  e->code = code;
+  e->role = role;
+  e->info = info;
+}
+
+// Cache format: "model <hw.model>" then one "<key> <type> <size> <attr>
+// <role>" line per key that exists on that model
+static int catalog_load(smc_catalog_t *cat, const char *path) {
+  FILE *f = fopen(path, "r");
+  if (f == NULL)
+    return -1;
+  char model[64];
+  if (fscanf(f, "model %63s\n", model) != 1 || strcmp(model, cat->model) != 0) {
+    fclose(f);
+    return -1; // another model (migrated home folder) — probe again
+  }
+  char key[5];
+  unsigned type, size, attr;
+  int role;
+  while (cat->count < SMC_CATALOG_MAX &&
+         fscanf(f, "%4s %x %u %x %d\n", key, &type, &size, &attr, &role) == 5) {
+    catalog_entry_t *e = &cat->entries[cat->count++];
+    snprintf(e->key, sizeof(e->key), "%s", key);
+    e->code = four_char_code(key);
+    e->role = role;
+    e->info.dataType = type;
+    e->info.dataSize = size;
+    e->info.dataAttributes = (uint8_t)attr;
+  }
+  fclose(f);
+  return 0;
+}
+
+static void catalog_save(const smc_catalog_t *cat, const char *path) {
+  FILE *f = fopen(path, "w");
+  if (f == NULL)
+    return;
+  fprintf(f, "model %s\n", cat->model);
+  for (int i = 0; i < cat->count; i++) {
+    const catalog_entry_t *e = &cat->entries[i];
+    fprintf(f, "%s %x %u %x %d\n", e->key, e->info.dataType, e->info.dataSize,
+            e->info.dataAttributes, e->role);
+  }
+  fclose(f);
+}
+
+smc_catalog_t *smc_catalog_create(const char *cache_path) {
+  if (!g_smc_conn && !g_sim) {
+    fprintf(stderr, "smc: catalog needs an open connection\n");
+    return NULL;
+  }
+  smc_catalog_t *cat = calloc(1, sizeof(smc_catalog_t));
+  if (cat == NULL)
+    return NULL;
+  model_identifier(cat->model, sizeof(cat->model));
+  if (cache_path && catalog_load(cat, cache_path) == 0)
+    return cat;
+
+  catalog_probe(cat, k_power_keys[0], ROLE_SYSTEM);
+  catalog_probe(cat, k_power_keys[1], ROLE_DC_IN);
+  catalog_probe(cat, k_power_keys[2], ROLE_BATTERY);
+  const char *const *temps =
+      is_apple_silicon() ? k_temps_apple_silicon : k_temps_intel;
+  for (const char *const *k = temps; *k; k++)
+    catalog_probe(cat, *k, ROLE_TEMP);
+  if (cache_path)
+    catalog_save(cat, cache_path);
+  return cat;
+}
+
+int smc_catalog_size(const smc_catalog_t *cat) { return cat ? cat->count : 0; }
+
+void smc_catalog_free(smc_catalog_t *cat) { free(cat); }
+
+int smc_sensor_sweep(const smc_catalog_t *cat, smc_sensor_frame_t *out) {
+  memset(out, 0, sizeof(*out));
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  out->timestamp = (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+  if (cat == NULL || (!g_smc_conn && !g_sim))
+    return -1;
+
+  for (int i = 0; i < cat->count; i++) {
+    const catalog_entry_t *e = &cat->entries[i];
+    uint8_t bytes[32];
+    uint32_t size = 0;
+    double value;
+    if (smc_read_bytes(e->code, &e->info, bytes, &size) != 0 ||
+        smc_decode_value(e->info.dataType, bytes, size, &value) != 0)
+      continue;
+
+    switch (e->role) {
+    case ROLE_SYSTEM:
+      out->system_w = (float)value;
+      out->valid |= SMC_HAS_SYSTEM;
+      break;
+    case ROLE_DC_IN:
+      out->dc_in_w = (float)value;
+      out->valid |= SMC_HAS_DC_IN;
+      break;
+    case ROLE_BATTERY:
+      out->battery_w = (float)value;
+      out->valid |= SMC_HAS_BATTERY;
+      break;
+    default:
+      // Unpopulated sensors read as 0 or absurd values
+      if (value <= 0 || value > 130 || out->temp_count >= SMC_MAX_TEMPS)
+        break;
+      snprintf(out->temp_keys[out->temp_count],
+               sizeof(out->temp_keys[out->temp_count]), "%s", e->key);
+      out->temps_c[out->temp_count++] = (float)value;
+      break;
+    }
+  }
+  return 0;
+}
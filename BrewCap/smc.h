@@ -8,17 +8,34 @@
 #ifndef smc_h
 #define smc_h
 
+#include "battery_sim.h"
 #include <stdint.h>
 
 // Open/close connection to AppleSMC
 int smc_open(void);
 void smc_close(void);
 
+// Answer every key read and write, and the battery property writes, from a
+// simulated battery instead of AppleSMC and the IORegistry; NULL goes back
+// to the hardware. Attach before smc_open(). The caller keeps ownership.
+void smc_attach_simulator(bsim_t *sim);
+
 // Read/write SMC keys
 int smc_read_key(const char *key, uint8_t *out_bytes, uint32_t *out_size);
 int smc_write_key(const char *key, const uint8_t *bytes, uint32_t size);
 
-// Charging control
+// Charging control. smc_disable_charging/smc_enable_charging try every
+// method at once; smc_set_charging uses one, so a caller can find out which
+// of them actually stops the current on this machine.
+typedef enum {
+  SMC_CHARGE_CHTE = 0, // ui32 key, macOS 26 on Apple Silicon
+  SMC_CHARGE_CH0B,     // Intel
+  SMC_CHARGE_CH0I,
+  SMC_CHARGE_INHIBIT,  // IORegistry ChargeInhibit / ChargeRate on the battery
+  SMC_CHARGE_METHODS
+} smc_charge_method_t;
+
+int smc_set_charging(smc_charge_method_t method, int enabled);
 int smc_disable_charging(void);
 int smc_enable_charging(void);
 
@@ -26,4 +43,42 @@ int smc_enable_charging(void);
 int smc_set_bclm(uint8_t percentage);
 int smc_get_bclm(uint8_t *out_percentage);
 
+// Decode raw key bytes by SMC data type (flt, ioft, spXY, fpXY, ui*, si*)
+int smc_decode_value(uint32_t data_type, const uint8_t *bytes, uint32_t size,
+                     double *out);
+
+// ============================================================
+// Sensor sweep
+// ============================================================
+
+#define SMC_MAX_TEMPS 24
+
+enum {
+  SMC_HAS_SYSTEM = 1 << 0,  // PSTR: total system power
+  SMC_HAS_DC_IN = 1 << 1,   // PDTR: power delivered by the adapter
+  SMC_HAS_BATTERY = 1 << 2, // PPBR: battery rail
+};
+
+typedef struct {
+  double timestamp; // seconds since 1970
+  uint32_t valid;   // SMC_HAS_* bits
+  float system_w;
+  float dc_in_w;
+  float battery_w;
+  int temp_count;
+  char temp_keys[SMC_MAX_TEMPS][5];
+  float temps_c[SMC_MAX_TEMPS];
+} smc_sensor_frame_t;
+
+// Keys known to exist on this model, with their type and size cached so a
+// sweep costs one SMC call per key and never probes missing keys. The
+// catalog is persisted at cache_path (may be NULL) and reused while hw.model
+// matches. Requires smc_open().
+typedef struct smc_catalog smc_catalog_t;
+smc_catalog_t *smc_catalog_create(const char *cache_path);
+int smc_catalog_size(const smc_catalog_t *cat);
+void smc_catalog_free(smc_catalog_t *cat);
+
+int smc_sensor_sweep(const smc_catalog_t *cat, smc_sensor_frame_t *out);
+
 #endif
@@ -0,0 +1,47 @@
+//
+//  store_util.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef store_util_h
+#define store_util_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Shared plumbing for the on-disk history files
+
+uint32_t store_crc32(const void *data, size_t len);
+
+// Retry on EINTR and short transfers; 0 on success, -1 with errno set
+int store_write_all(int fd, const void *buf, size_t len);
+int store_pread_all(int fd, void *buf, size_t len, int64_t offset);
+
+// fsync only reaches the drive's cache on macOS; this asks the drive to
+// flush it too (F_FULLFSYNC) where the platform has it
+int store_sync(int fd);
+
+// Syncs the directory holding path, so a rename or create in it survives
+// power loss
+int store_sync_dir(const char *path);
+
+// Writes data to a temporary sibling, fully syncs it, renames it over path
+// and syncs the directory, so readers see either the old file or the
+// complete new one, and after a power loss too
+int store_write_atomic(const char *path, const void *data, size_t len);
+
+// LEB128 varints with zigzag for signed values
+size_t store_put_varint(uint8_t *out, uint64_t v); // writes at most 10 bytes
+int store_get_varint(const uint8_t *buf, size_t len, size_t *pos,
+                     uint64_t *out);
+
+static inline uint64_t store_zigzag(int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+static inline int64_t store_unzigzag(uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+#endif
@@ -0,0 +1,1267 @@
+//
+//  telemetry_store.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "telemetry_store.h"
+#include "float_codec.h"
+#include "store_util.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TS_MAGIC 0x53544342u // "BCTS" little-endian
+#define TS_VERSION 2u
+#define TS_V1_COLUMNS 6 // version 1 chunks predate the watts column
+#define TS_BATCH 512
+
+// Chunk file: header, then the column blobs at the offsets it lists. Only
+// the first ncols entries of cols are on disk.
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t count;
+  uint32_t ncols; // 0 in version 1 files
+  int64_t t_first;
+  int64_t t_last;
+  struct {
+    uint32_t offset;
+    uint32_t length;
+  } cols[TS_NCOLS];
+} chunk_header_t;
+
+typedef struct {
+  chunk_header_t hdr;
+  int64_t bytes;
+} chunk_meta_t;
+
+// index.tsi: header, then one entry per sealed chunk in chunk order. Entries
+// are fixed size so the file is mmapped and binary-searched in place.
+#define TS_INDEX_MAGIC 0x49544342u // "BCTI" little-endian
+#define TS_INDEX_VERSION 1u
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_size;
+  uint32_t reserved;
+} index_header_t;
+
+typedef struct {
+  double min;
+  double max;
+  double sum;
+} col_summary_t;
+
+typedef struct {
+  int64_t t_first;
+  int64_t t_last;
+  uint32_t count;
+  uint32_t reserved;
+  col_summary_t cols[TS_NCOLS]; // TS_COL_TIME unused
+} index_entry_t;
+
+// One encoded column. Tokens are varints: even = zigzag residual << 1,
+// odd = run of zero residuals << 1.
+typedef struct {
+  uint8_t *buf;
+  size_t len;
+  size_t cap;
+  uint64_t zeros; // pending zero run, not yet written
+} col_buf_t;
+
+// Encoder state for one chunk: the open chunk, or a chunk being rewritten by
+// compaction
+typedef struct {
+  col_buf_t col[TS_NCOLS]; // TS_COL_WATTS unused, see watts
+  fxor_encoder_t watts;
+  uint32_t count;
+  int64_t t_first;
+  int64_t t_last;
+  int64_t prev_delta;
+  int64_t prev[TS_NCOLS];
+  col_summary_t sum[TS_NCOLS];
+} chunk_enc_t;
+
+struct ts_store {
+  char dir[512];
+  chunk_meta_t *chunks; // sealed, ordered by t_first
+  size_t nchunks;
+  size_t chunks_cap;
+  chunk_enc_t open;
+  int64_t last_ms; // newest sample anywhere in the store
+  wal_t *wal;      // open chunk samples, until they are sealed
+  int replaying;
+  // Chunk index
+  int index_fd;
+  const uint8_t *index_map;
+  size_t index_map_len;
+  size_t index_count;
+  int64_t chunks_decoded;
+};
+
+// ============================================================
+// Column codec
+// ============================================================
+
+static int col_put_token(col_buf_t *c, uint64_t token) {
+  if (c->len + 10 > c->cap) {
+    size_t cap = c->cap ? c->cap * 2 : 1024;
+    uint8_t *b = realloc(c->buf, cap);
+    if (b == NULL)
+      return -1;
+    c->buf = b;
+    c->cap = cap;
+  }
+  c->len += store_put_varint(c->buf + c->len, token);
+  return 0;
+}
+
+static int col_flush_run(col_buf_t *c) {
+  if (c->zeros == 0)
+    return 0;
+  int rc = col_put_token(c, (c->zeros << 1) | 1);
+  c->zeros = 0;
+  return rc;
+}
+
+// Residuals are bounded well below 2^62 (ms deltas, mA, mV, ...)
+static int col_put(col_buf_t *c, int64_t residual) {
+  if (residual == 0) {
+    c->zeros++;
+    return 0;
+  }
+  if (col_flush_run(c) != 0)
+    return -1;
+  return col_put_token(c, store_zigzag(residual) << 1);
+}
+
+typedef struct {
+  const uint8_t *buf;
+  size_t len;
+  size_t pos;
+  uint64_t run;
+  uint64_t tail; // zero run still held by an open chunk's encoder
+} col_reader_t;
+
+static int col_next(col_reader_t *r, int64_t *out) {
+  if (r->run > 0) {
+    r->run--;
+    *out = 0;
+    return 0;
+  }
+  if (r->pos < r->len) {
+    uint64_t token;
+    if (store_get_varint(r->buf, r->len, &r->pos, &token) != 0)
+      return -1;
+    if (token & 1) {
+      r->run = (token >> 1) - 1;
+      *out = 0;
+    } else {
+      *out = store_unzigzag(token >> 1);
+    }
+    return 0;
+  }
+  if (r->tail > 0) {
+    r->tail--;
+    *out = 0;
+    return 0;
+  }
+  return -1;
+}
+
+static int64_t column_value(const pdev_sample_t *s, int col) {
+  switch (col) {
+  case TS_COL_LEVEL:
+    return s->level;
+  case TS_COL_AMPERAGE:
+    return s->amperage_ma;
+  case TS_COL_VOLTAGE:
+    return s->voltage_mv;
+  case TS_COL_TEMP:
+    return s->temp_cc;
+  case TS_COL_FLAGS:
+    return (s->plugged ? 1 : 0) | (s->charging ? 2 : 0);
+  default:
+    return s->t_ms;
+  }
+}
+
+static void set_column(pdev_sample_t *s, int col, int64_t v) {
+  switch (col) {
+  case TS_COL_LEVEL:
+    s->level = (int32_t)v;
+    break;
+  case TS_COL_AMPERAGE:
+    s->amperage_ma = (int32_t)v;
+    break;
+  case TS_COL_VOLTAGE:
+    s->voltage_mv = (int32_t)v;
+    break;
+  case TS_COL_TEMP:
+    s->temp_cc = (int32_t)v;
+    break;
+  case TS_COL_FLAGS:
+    s->plugged = (uint8_t)(v & 1);
+    s->charging = (uint8_t)((v >> 1) & 1);
+    break;
+  default:
+    s->t_ms = v;
+  }
+}
+
+static double sample_value(const pdev_sample_t *s, int col) {
+  return col == TS_COL_WATTS ? (double)s->power_w : (double)column_value(s, col);
+}
+
+static void summary_reset(col_summary_t *sum) {
+  for (int c = 0; c < TS_NCOLS; c++) {
+    sum[c].min = INFINITY;
+    sum[c].max = -INFINITY;
+    sum[c].sum = 0;
+  }
+}
+
+static void summary_add(col_summary_t *sum, const pdev_sample_t *s) {
+  for (int c = 1; c < TS_NCOLS; c++) {
+    double v = sample_value(s, c);
+    if (v < sum[c].min)
+      sum[c].min = v;
+    if (v > sum[c].max)
+      sum[c].max = v;
+    sum[c].sum += v;
+  }
+}
+
+// Decodes one chunk and hands the in-range samples to cb. Returns 1 if the
+// callback asked to stop, 0 when the chunk is exhausted, -1 on corruption.
+static int decode_chunk(col_reader_t *readers, fxor_decoder_t *watts,
+                        uint32_t mask, uint32_t count, int64_t t_first,
+                        int64_t from_ms, int64_t to_ms, ts_scan_cb cb,
+                        void *ctx, int64_t *visited) {
+  pdev_sample_t batch[TS_BATCH];
+  size_t n = 0;
+  int64_t t = t_first, delta = 0, vals[TS_NCOLS] = {0};
+  double w = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    int64_t dod;
+    if (col_next(&readers[TS_COL_TIME], &dod) != 0)
+      return -1;
+    delta += dod;
+    t += delta;
+    if ((mask & TS_COL(TS_COL_WATTS)) && fxor_next(watts, &w) != 0)
+      return -1;
+    for (int c = 1; c < TS_NCOLS; c++) {
+      if (!(mask & TS_COL(c)) || c == TS_COL_WATTS)
+        continue;
+      int64_t d;
+      if (col_next(&readers[c], &d) != 0)
+        return -1;
+      vals[c] += d;
+    }
+    if (t < from_ms)
+      continue;
+    if (t >= to_ms)
+      break;
+    pdev_sample_t *s = &batch[n++];
+    memset(s, 0, sizeof(*s));
+    s->t_ms = t;
+    s->valid = 1;
+    for (int c = 1; c < TS_NCOLS; c++)
+      if ((mask & TS_COL(c)) && c != TS_COL_WATTS)
+        set_column(s, c, vals[c]);
+    s->power_w = (float)w;
+    if (n == TS_BATCH) {
+      *visited += (int64_t)n;
+      if (cb && cb(batch, n, ctx))
+        return 1;
+      n = 0;
+    }
+  }
+  if (n > 0) {
+    *visited += (int64_t)n;
+    if (cb && cb(batch, n, ctx))
+      return 1;
+  }
+  return 0;
+}
+
+// ============================================================
+// Chunk files
+// ============================================================
+
+static void chunk_path(const ts_store_t *st, int64_t t_first, char *out,
+                       size_t size) {
+  snprintf(out, size, "%s/%016" PRId64 ".tsc", st->dir, t_first);
+}
+
+static int add_chunk(ts_store_t *st, const chunk_header_t *hdr,
+                     int64_t bytes) {
+  if (st->nchunks == st->chunks_cap) {
+    size_t cap = st->chunks_cap ? st->chunks_cap * 2 : 64;
+    chunk_meta_t *c = realloc(st->chunks, cap * sizeof(chunk_meta_t));
+    if (c == NULL)
+      return -1;
+    st->chunks = c;
+    st->chunks_cap = cap;
+  }
+  st->chunks[st->nchunks].hdr = *hdr;
+  st->chunks[st->nchunks].bytes = bytes;
+  st->nchunks++;
+  return 0;
+}
+
+static int compare_chunks(const void *a, const void *b) {
+  int64_t x = ((const chunk_meta_t *)a)->hdr.t_first;
+  int64_t y = ((const chunk_meta_t *)b)->hdr.t_first;
+  return (x > y) - (x < y);
+}
+
+static int read_header(int fd, chunk_header_t *hdr) {
+  memset(hdr, 0, sizeof(*hdr));
+  size_t fixed = offsetof(chunk_header_t, cols);
+  if (store_pread_all(fd, hdr, fixed, 0) != 0 || hdr->magic != TS_MAGIC)
+    return -1;
+  if (hdr->version == 1)
+    hdr->ncols = TS_V1_COLUMNS;
+  else if (hdr->version != TS_VERSION || hdr->ncols > TS_NCOLS)
+    return -1;
+  return store_pread_all(fd, hdr->cols, hdr->ncols * sizeof(hdr->cols[0]),
+                         (int64_t)fixed);
+}
+
+static void remove_chunks(ts_store_t *st, size_t at, size_t n) {
+  memmove(&st->chunks[at], &st->chunks[at + n],
+          (st->nchunks - at - n) * sizeof(chunk_meta_t));
+  st->nchunks -= n;
+}
+
+// A compaction merge renames the merged chunk into place before unlinking
+// its inputs; a crash in between leaves inputs whose samples the merged
+// chunk already holds
+static void drop_covered_chunks(ts_store_t *st) {
+  char path[1024];
+  for (size_t i = 1; i < st->nchunks;) {
+    if (st->chunks[i].hdr.t_first > st->chunks[i - 1].hdr.t_last) {
+      i++;
+      continue;
+    }
+    chunk_path(st, st->chunks[i].hdr.t_first, path, sizeof(path));
+    unlink(path);
+    remove_chunks(st, i, 1);
+  }
+}
+
+static int load_chunks(ts_store_t *st) {
+  DIR *dir = opendir(st->dir);
+  if (dir == NULL) {
+    fprintf(stderr, "ts: cannot open %s: %s\n", st->dir, strerror(errno));
+    return -1;
+  }
+  struct dirent *de;
+  char path[1024];
+  while ((de = readdir(dir)) != NULL) {
+    size_t len = strlen(de->d_name);
+    snprintf(path, sizeof(path), "%s/%s", st->dir, de->d_name);
+    if (len > 8 && strcmp(de->d_name + len - 8, ".tsc.tmp") == 0) {
+      unlink(path); // seal interrupted before its rename
+      continue;
+    }
+    if (len < 5 || strcmp(de->d_name + len - 4, ".tsc") != 0)
+      continue;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      continue;
+    chunk_header_t hdr;
+    off_t size = lseek(fd, 0, SEEK_END);
+    int ok = read_header(fd, &hdr) == 0;
+    close(fd);
+    if (!ok) {
+      fprintf(stderr, "ts: skipping unreadable chunk %s\n", de->d_name);
+      continue;
+    }
+    if (add_chunk(st, &hdr, (int64_t)size) != 0) {
+      closedir(dir);
+      return -1;
+    }
+  }
+  closedir(dir);
+  if (st->nchunks > 0) {
+    qsort(st->chunks, st->nchunks, sizeof(chunk_meta_t), compare_chunks);
+    drop_covered_chunks(st);
+    st->last_ms = st->chunks[st->nchunks - 1].hdr.t_last;
+  }
+  return 0;
+}
+
+// ============================================================
+// Chunk encoder
+// ============================================================
+
+static void enc_init(chunk_enc_t *e) {
+  memset(e, 0, sizeof(*e));
+  fxor_encoder_init(&e->watts);
+  summary_reset(e->sum);
+}
+
+static void enc_free(chunk_enc_t *e) {
+  for (int c = 0; c < TS_NCOLS; c++)
+    free(e->col[c].buf);
+  fxor_encoder_free(&e->watts);
+}
+
+// Empties the encoder, keeping its buffers
+static void enc_reset(chunk_enc_t *e) {
+  for (int c = 0; c < TS_NCOLS; c++) {
+    e->col[c].len = 0;
+    e->col[c].zeros = 0;
+    e->prev[c] = 0;
+  }
+  fxor_encoder_reset(&e->watts);
+  summary_reset(e->sum);
+  e->count = 0;
+  e->prev_delta = 0;
+}
+
+// Timestamps must increase; the caller checks
+static int enc_add(chunk_enc_t *e, const pdev_sample_t *s) {
+  if (e->count == 0) {
+    e->t_first = s->t_ms;
+    e->prev[TS_COL_TIME] = s->t_ms;
+  }
+  int64_t delta = s->t_ms - e->prev[TS_COL_TIME];
+  if (col_put(&e->col[TS_COL_TIME], delta - e->prev_delta) != 0)
+    return -1;
+  e->prev_delta = delta;
+  e->prev[TS_COL_TIME] = s->t_ms;
+  if (fxor_append(&e->watts, (double)s->power_w) != 0)
+    return -1;
+  for (int c = 1; c < TS_NCOLS; c++) {
+    if (c == TS_COL_WATTS)
+      continue;
+    int64_t v = column_value(s, c);
+    if (col_put(&e->col[c], v - e->prev[c]) != 0)
+      return -1;
+    e->prev[c] = v;
+  }
+  summary_add(e->sum, s);
+  e->count++;
+  e->t_last = s->t_ms;
+  return 0;
+}
+
+// Writes the encoded samples to path as a sealed chunk, atomically
+static int enc_write(chunk_enc_t *e, const char *path, chunk_header_t *hdr,
+                     int64_t *bytes) {
+  memset(hdr, 0, sizeof(*hdr));
+  hdr->magic = TS_MAGIC;
+  hdr->version = TS_VERSION;
+  hdr->count = e->count;
+  hdr->ncols = TS_NCOLS;
+  hdr->t_first = e->t_first;
+  hdr->t_last = e->t_last;
+
+  const uint8_t *blobs[TS_NCOLS];
+  size_t total = sizeof(*hdr);
+  for (int c = 0; c < TS_NCOLS; c++) {
+    size_t len;
+    if (c == TS_COL_WATTS) {
+      blobs[c] = e->watts.buf;
+      len = fxor_bytes(&e->watts);
+    } else {
+      if (col_flush_run(&e->col[c]) != 0)
+        return -1;
+      blobs[c] = e->col[c].buf;
+      len = e->col[c].len;
+    }
+    hdr->cols[c].offset = (uint32_t)total;
+    hdr->cols[c].length = (uint32_t)len;
+    total += len;
+  }
+  uint8_t *file = malloc(total);
+  if (file == NULL)
+    return -1;
+  memcpy(file, hdr, sizeof(*hdr));
+  for (int c = 0; c < TS_NCOLS; c++)
+    if (hdr->cols[c].length > 0)
+      memcpy(file + hdr->cols[c].offset, blobs[c], hdr->cols[c].length);
+  int rc = store_write_atomic(path, file, total);
+  free(file);
+  *bytes = (int64_t)total;
+  return rc;
+}
+
+static void enc_entry(const chunk_enc_t *e, index_entry_t *out) {
+  memset(out, 0, sizeof(*out));
+  out->t_first = e->t_first;
+  out->t_last = e->t_last;
+  out->count = e->count;
+  memcpy(out->cols, e->sum, sizeof(out->cols));
+}
+
+// ============================================================
+// Chunk index
+// ============================================================
+
+static void index_path(const ts_store_t *st, char *out, size_t size) {
+  snprintf(out, size, "%s/index.tsi", st->dir);
+}
+
+static void index_unmap(ts_store_t *st) {
+  if (st->index_map)
+    munmap((void *)st->index_map, st->index_map_len);
+  st->index_map = NULL;
+  st->index_map_len = 0;
+}
+
+static int index_remap(ts_store_t *st) {
+  index_unmap(st);
+  size_t len =
+      sizeof(index_header_t) + st->index_count * sizeof(index_entry_t);
+  void *m = mmap(NULL, len, PROT_READ, MAP_SHARED, st->index_fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr, "ts: index mmap failed: %s\n", strerror(errno));
+    return -1;
+  }
+  st->index_map = m;
+  st->index_map_len = len;
+  return 0;
+}
+
+// Entry i, or NULL when the index is unavailable
+static const index_entry_t *index_entry(ts_store_t *st, size_t i) {
+  if (st->index_fd < 0 || i >= st->index_count)
+    return NULL;
+  size_t end = sizeof(index_header_t) + (i + 1) * sizeof(index_entry_t);
+  if (end > st->index_map_len && index_remap(st) != 0)
+    return NULL;
+  return (const index_entry_t *)(st->index_map + sizeof(index_header_t)) + i;
+}
+
+static void index_close(ts_store_t *st) {
+  index_unmap(st);
+  if (st->index_fd >= 0)
+    close(st->index_fd);
+  st->index_fd = -1;
+  st->index_count = 0;
+}
+
+static int index_append(ts_store_t *st, const index_entry_t *e) {
+  if (st->index_fd < 0)
+    return -1;
+  if (store_write_all(st->index_fd, e, sizeof(*e)) != 0) {
+    fprintf(stderr, "ts: index append failed: %s\n", strerror(errno));
+    index_close(st); // rebuilt on next open
+    return -1;
+  }
+  st->index_count++;
+  return 0;
+}
+
+static int scan_sealed(ts_store_t *st, const chunk_meta_t *m, uint32_t mask,
+                       int64_t from_ms, int64_t to_ms, ts_scan_cb cb,
+                       void *ctx, int64_t *visited);
+
+static int summarise_cb(const pdev_sample_t *batch, size_t n, void *ctx) {
+  for (size_t i = 0; i < n; i++)
+    summary_add(ctx, &batch[i]);
+  return 0;
+}
+
+// Decodes every chunk once; only needed when the index is missing or stale
+static int index_rebuild(ts_store_t *st, const char *path) {
+  size_t len = sizeof(index_header_t) + st->nchunks * sizeof(index_entry_t);
+  uint8_t *file = calloc(1, len);
+  if (file == NULL)
+    return -1;
+  index_header_t *hdr = (index_header_t *)file;
+  hdr->magic = TS_INDEX_MAGIC;
+  hdr->version = TS_INDEX_VERSION;
+  hdr->entry_size = sizeof(index_entry_t);
+  index_entry_t *entries = (index_entry_t *)(file + sizeof(index_header_t));
+  for (size_t i = 0; i < st->nchunks; i++) {
+    const chunk_meta_t *m = &st->chunks[i];
+    index_entry_t *e = &entries[i];
+    e->t_first = m->hdr.t_first;
+    e->t_last = m->hdr.t_last;
+    e->count = m->hdr.count;
+    summary_reset(e->cols);
+    int64_t visited = 0;
+    if (scan_sealed(st, m, TS_ALL_COLUMNS, INT64_MIN, INT64_MAX, summarise_cb,
+                    e->cols, &visited) != 0) {
+      free(file);
+      return -1;
+    }
+  }
+  int rc = store_write_atomic(path, file, len);
+  free(file);
+  return rc;
+}
+
+static int index_valid(ts_store_t *st) {
+  struct stat sb;
+  index_header_t hdr;
+  if (fstat(st->index_fd, &sb) != 0 ||
+      store_pread_all(st->index_fd, &hdr, sizeof(hdr), 0) != 0 ||
+      hdr.magic != TS_INDEX_MAGIC || hdr.version != TS_INDEX_VERSION ||
+      hdr.entry_size != sizeof(index_entry_t) ||
+      (size_t)sb.st_size !=
+          sizeof(hdr) + st->nchunks * sizeof(index_entry_t))
+    return 0;
+  st->index_count = st->nchunks;
+  if (st->nchunks > 0 && index_remap(st) != 0)
+    return 0;
+  for (size_t i = 0; i < st->nchunks; i++) {
+    const index_entry_t *e = index_entry(st, i);
+    if (e == NULL || e->t_first != st->chunks[i].hdr.t_first ||
+        e->count != st->chunks[i].hdr.count)
+      return 0;
+  }
+  return 1;
+}
+
+static int index_open(ts_store_t *st) {
+  char path[1024];
+  index_path(st, path, sizeof(path));
+  for (int attempt = 0; attempt < 2; attempt++) {
+    st->index_fd = open(path, O_RDWR | O_APPEND | O_CLOEXEC);
+    if (st->index_fd >= 0 && index_valid(st))
+      return 0;
+    index_close(st);
+    if (attempt == 0 && index_rebuild(st, path) != 0)
+      break;
+  }
+  fprintf(stderr, "ts: chunk index unavailable, queries will decode\n");
+  return -1;
+}
+
+// Open chunk -> one sealed file, written atomically
+static int seal(ts_store_t *st) {
+  if (st->open.count == 0)
+    return 0;
+  char path[1024];
+  chunk_header_t hdr;
+  int64_t bytes;
+  chunk_path(st, st->open.t_first, path, sizeof(path));
+  if (enc_write(&st->open, path, &hdr, &bytes) != 0 ||
+      add_chunk(st, &hdr, bytes) != 0)
+    return -1;
+  index_entry_t e;
+  enc_entry(&st->open, &e);
+  index_append(st, &e);
+  enc_reset(&st->open);
+  // The chunk file and its directory entry are fully synced by
+  // store_write_atomic, so only now can its samples leave the log. While
+  // replaying, the log is still being read; stale entries are harmless since
+  // replay drops samples older than the newest sealed one.
+  if (!st->replaying)
+    wal_reset(st->wal);
+  return 0;
+}
+
+static int scan_open(ts_store_t *st, uint32_t mask, int64_t from_ms,
+                     int64_t to_ms, ts_scan_cb cb, void *ctx,
+                     int64_t *visited) {
+  const chunk_enc_t *e = &st->open;
+  col_reader_t readers[TS_NCOLS];
+  memset(readers, 0, sizeof(readers));
+  for (int c = 0; c < TS_NCOLS; c++) {
+    readers[c].buf = e->col[c].buf;
+    readers[c].len = e->col[c].len;
+    readers[c].tail = e->col[c].zeros;
+  }
+  fxor_decoder_t watts;
+  fxor_decoder_init(&watts, e->watts.buf, fxor_bytes(&e->watts), e->count);
+  return decode_chunk(readers, &watts, mask, e->count, e->t_first, from_ms,
+                      to_ms, cb, ctx, visited);
+}
+
+static int scan_sealed(ts_store_t *st, const chunk_meta_t *m, uint32_t mask,
+                       int64_t from_ms, int64_t to_ms, ts_scan_cb cb,
+                       void *ctx, int64_t *visited) {
+  char path[1024];
+  chunk_path(st, m->hdr.t_first, path, sizeof(path));
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "ts: cannot open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  // Columns newer than the chunk's format read as zero
+  mask &= (1u << m->hdr.ncols) - 1;
+  col_reader_t readers[TS_NCOLS];
+  uint8_t *bufs[TS_NCOLS] = {0};
+  memset(readers, 0, sizeof(readers));
+  int rc = 0;
+  for (int c = 0; c < TS_NCOLS && rc == 0; c++) {
+    if (!(mask & TS_COL(c)) || m->hdr.cols[c].length == 0)
+      continue;
+    // Only the requested columns are read from disk
+    bufs[c] = malloc(m->hdr.cols[c].length);
+    if (bufs[c] == NULL ||
+        store_pread_all(fd, bufs[c], m->hdr.cols[c].length,
+                        m->hdr.cols[c].offset) != 0) {
+      rc = -1;
+      break;
+    }
+    readers[c].buf = bufs[c];
+    readers[c].len = m->hdr.cols[c].length;
+  }
+  close(fd);
+  fxor_decoder_t watts;
+  fxor_decoder_init(&watts, bufs[TS_COL_WATTS], readers[TS_COL_WATTS].len,
+                    m->hdr.count);
+  if (rc == 0)
+    rc = decode_chunk(readers, &watts, mask, m->hdr.count, m->hdr.t_first,
+                      from_ms, to_ms, cb, ctx, visited);
+  for (int c = 0; c < TS_NCOLS; c++)
+    free(bufs[c]);
+  return rc;
+}
+
+// Adds a sample to the open chunk, sealing it first when it is full
+static int open_append(ts_store_t *st, const pdev_sample_t *s) {
+  if (s->t_ms <= st->last_ms)
+    return -1; // clock went backwards, or a duplicate tick
+  if (st->open.count > 0 &&
+      (st->open.count >= TS_CHUNK_SAMPLES ||
+       s->t_ms - st->open.t_first >= TS_CHUNK_SPAN_MS)) {
+    if (seal(st) != 0)
+      return -1;
+  }
+  if (enc_add(&st->open, s) != 0)
+    return -1;
+  st->last_ms = s->t_ms;
+  return 0;
+}
+
+// ============================================================
+// Write-ahead log
+// ============================================================
+
+// One open-chunk sample as logged
+typedef struct {
+  int64_t t_ms;
+  int32_t level;
+  int32_t amperage_ma;
+  int32_t voltage_mv;
+  int32_t temp_cc;
+  int32_t flags;
+  float power_w;
+} wal_sample_t;
+
+_Static_assert(sizeof(wal_sample_t) == 32, "wal_sample_t layout changed");
+
+static int replay_cb(const void *data, uint32_t len, void *ctx) {
+  wal_sample_t rec;
+  if (len != sizeof(rec))
+    return 0;
+  memcpy(&rec, data, sizeof(rec));
+  pdev_sample_t s;
+  memset(&s, 0, sizeof(s));
+  s.t_ms = rec.t_ms;
+  s.level = rec.level;
+  s.amperage_ma = rec.amperage_ma;
+  s.voltage_mv = rec.voltage_mv;
+  s.temp_cc = rec.temp_cc;
+  s.power_w = rec.power_w;
+  set_column(&s, TS_COL_FLAGS, rec.flags);
+  s.valid = 1;
+  open_append(ctx, &s); // samples already sealed are rejected as stale
+  return 0;
+}
+
+// ============================================================
+// Compaction
+// ============================================================
+
+// Replaces entries [at, at + n) with insert (if not NULL) and writes the
+// index out whole, atomically. The chunk list must already match.
+static int64_t index_replace(ts_store_t *st, size_t at, size_t n,
+                             const index_entry_t *insert) {
+  if (st->index_fd < 0)
+    return 0; // rebuilt on next open
+  size_t count = st->nchunks;
+  uint8_t *file = NULL;
+  if (st->index_count + (insert ? 1 : 0) != count + n ||
+      index_entry(st, st->index_count - 1) == NULL ||
+      (file = malloc(sizeof(index_header_t) +
+                     count * sizeof(index_entry_t))) == NULL) {
+    index_close(st); // out of step; rebuilt on next open
+    return 0;
+  }
+  size_t len = sizeof(index_header_t) + count * sizeof(index_entry_t);
+  const index_entry_t *old =
+      (const index_entry_t *)(st->index_map + sizeof(index_header_t));
+  memcpy(file, st->index_map, sizeof(index_header_t));
+  index_entry_t *out = (index_entry_t *)(file + sizeof(index_header_t));
+  size_t k = 0;
+  for (size_t i = 0; i < at; i++)
+    out[k++] = old[i];
+  if (insert)
+    out[k++] = *insert;
+  for (size_t i = at + n; k < count; i++)
+    out[k++] = old[i];
+
+  char path[1024];
+  index_path(st, path, sizeof(path));
+  int rc = store_write_atomic(path, file, len);
+  free(file);
+  index_close(st);
+  if (rc != 0 || index_open(st) != 0)
+    return -1;
+  return (int64_t)len;
+}
+
+typedef struct {
+  chunk_enc_t *enc;
+  int64_t width; // averaging bucket; 0 copies samples unchanged
+  int64_t bucket;
+  int64_t n;
+  double acc[TS_NCOLS];
+  pdev_sample_t first;
+  pdev_sample_t last;
+  int err;
+} rewrite_ctx_t;
+
+// One sample per bucket, stamped with the bucket's first timestamp so the
+// chunk keeps its name and order. Flags come from the bucket's last sample.
+static void rewrite_emit(rewrite_ctx_t *r) {
+  if (r->n == 0)
+    return;
+  pdev_sample_t s = r->last;
+  s.t_ms = r->first.t_ms;
+  for (int c = 1; c < TS_NCOLS; c++) {
+    if (c == TS_COL_FLAGS)
+      continue;
+    double mean = r->acc[c] / (double)r->n;
+    if (c == TS_COL_WATTS)
+      s.power_w = (float)mean;
+    else
+      set_column(&s, c, llround(mean));
+  }
+  if (enc_add(r->enc, &s) != 0)
+    r->err = 1;
+  r->n = 0;
+  memset(r->acc, 0, sizeof(r->acc));
+}
+
+static int rewrite_cb(const pdev_sample_t *batch, size_t n, void *ctx) {
+  rewrite_ctx_t *r = ctx;
+  for (size_t i = 0; i < n && !r->err; i++) {
+    const pdev_sample_t *s = &batch[i];
+    if (r->width == 0) {
+      if (enc_add(r->enc, s) != 0)
+        r->err = 1;
+      continue;
+    }
+    int64_t bucket = s->t_ms - (s->t_ms % r->width + r->width) % r->width;
+    if (r->n > 0 && bucket != r->bucket)
+      rewrite_emit(r);
+    if (r->n == 0) {
+      r->bucket = bucket;
+      r->first = *s;
+    }
+    for (int c = 1; c < TS_NCOLS; c++)
+      r->acc[c] += sample_value(s, c);
+    r->last = *s;
+    r->n++;
+  }
+  return r->err;
+}
+
+// A chunk that cannot be read would fail every later pass at the same place
+// and stall retention for good. Move it aside as .tsc.bad, which is never
+// loaded again but kept for inspection, and drop it from the list and index.
+static int64_t quarantine_chunk(ts_store_t *st, size_t i) {
+  char path[1024], bad[1040];
+  chunk_path(st, st->chunks[i].hdr.t_first, path, sizeof(path));
+  snprintf(bad, sizeof(bad), "%s.bad", path);
+  fprintf(stderr, "ts: moving unreadable chunk %s aside\n", path);
+  if (rename(path, bad) != 0 && errno != ENOENT)
+    fprintf(stderr, "ts: cannot rename %s: %s\n", path, strerror(errno));
+  remove_chunks(st, i, 1);
+  int64_t index_bytes = index_replace(st, i, 1, NULL);
+  return 4096 + (index_bytes > 0 ? index_bytes : 0);
+}
+
+// Rewrites sealed chunks [at, at + n) as one chunk, averaging into width
+// buckets if width > 0. Returns the bytes read and written, or -1.
+static int64_t rewrite_chunks(ts_store_t *st, size_t at, size_t n,
+                              int64_t width) {
+  chunk_enc_t enc;
+  enc_init(&enc);
+  rewrite_ctx_t r;
+  memset(&r, 0, sizeof(r));
+  r.enc = &enc;
+  r.width = width;
+  int64_t cost = 0, visited = 0;
+  for (size_t i = at; i < at + n && !r.err; i++) {
+    cost += st->chunks[i].bytes;
+    int rc = scan_sealed(st, &st->chunks[i], TS_ALL_COLUMNS, INT64_MIN,
+                         INT64_MAX, rewrite_cb, &r, &visited);
+    if (rc < 0) {
+      // The chunk, not the rewrite, failed: nothing has been replaced yet
+      enc_free(&enc);
+      return cost + quarantine_chunk(st, i);
+    }
+    if (rc > 0)
+      r.err = 1;
+  }
+  rewrite_emit(&r);
+
+  char path[1024];
+  chunk_header_t hdr;
+  int64_t bytes = 0;
+  chunk_path(st, st->chunks[at].hdr.t_first, path, sizeof(path));
+  if (r.err || enc.count == 0 || enc.t_first != st->chunks[at].hdr.t_first ||
+      enc_write(&enc, path, &hdr, &bytes) != 0) {
+    enc_free(&enc);
+    return -1;
+  }
+  // The merged chunk is in place; its inputs are now redundant
+  for (size_t i = at + 1; i < at + n; i++) {
+    chunk_path(st, st->chunks[i].hdr.t_first, path, sizeof(path));
+    unlink(path);
+  }
+  st->chunks[at].hdr = hdr;
+  st->chunks[at].bytes = bytes;
+  remove_chunks(st, at + 1, n - 1);
+
+  index_entry_t e;
+  enc_entry(&enc, &e);
+  enc_free(&enc);
+  int64_t index_bytes = index_replace(st, at, n, &e);
+  return cost + bytes + (index_bytes > 0 ? index_bytes : 0);
+}
+
+// Deletes the oldest chunks that ended before cutoff
+static int64_t expire_chunks(ts_store_t *st, int64_t cutoff) {
+  size_t n = 0;
+  char path[1024];
+  while (n < st->nchunks && st->chunks[n].hdr.t_last < cutoff) {
+    chunk_path(st, st->chunks[n].hdr.t_first, path, sizeof(path));
+    unlink(path);
+    n++;
+  }
+  if (n == 0)
+    return 0;
+  remove_chunks(st, 0, n);
+  int64_t index_bytes = index_replace(st, 0, n, NULL);
+  return (int64_t)n * 4096 + (index_bytes > 0 ? index_bytes : 0);
+}
+
+// A chunk still holding raw samples has clearly more than one per bucket;
+// an averaged one has at most one per bucket touched
+static int needs_downsample(const chunk_meta_t *m, int64_t width) {
+  int64_t span = m->hdr.t_last - m->hdr.t_first;
+  return (int64_t)m->hdr.count > span / width + 2;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+ts_store_t *ts_open(const char *dir) {
+  ts_store_t *st = calloc(1, sizeof(ts_store_t));
+  if (st == NULL)
+    return NULL;
+  snprintf(st->dir, sizeof(st->dir), "%s", dir);
+  enc_init(&st->open);
+  st->last_ms = INT64_MIN;
+  st->index_fd = -1;
+  if (load_chunks(st) != 0) {
+    ts_close(st);
+    return NULL;
+  }
+  index_open(st); // queries fall back to decoding without it
+
+  char path[1024];
+  snprintf(path, sizeof(path), "%s/open.wal", st->dir);
+  st->wal = wal_open(path, WAL_POLICY_BALANCED);
+  if (st->wal == NULL) {
+    ts_close(st);
+    return NULL;
+  }
+  st->replaying = 1;
+  int64_t n = wal_replay(st->wal, replay_cb, st);
+  st->replaying = 0;
+  if (n > 0)
+    fprintf(stderr, "ts: recovered %u unsealed samples\n", st->open.count);
+  return st;
+}
+
+void ts_close(ts_store_t *store) {
+  if (store == NULL)
+    return;
+  if (store->wal)
+    seal(store);
+  wal_close(store->wal);
+  enc_free(&store->open);
+  index_close(store);
+  free(store->chunks);
+  free(store);
+}
+
+int ts_append(ts_store_t *st, const pdev_sample_t *s) {
+  if (st == NULL || s == NULL || open_append(st, s) != 0)
+    return -1;
+  wal_sample_t rec = {.t_ms = s->t_ms,
+                      .level = s->level,
+                      .amperage_ma = s->amperage_ma,
+                      .voltage_mv = s->voltage_mv,
+                      .temp_cc = s->temp_cc,
+                      .flags = (int32_t)column_value(s, TS_COL_FLAGS),
+                      .power_w = s->power_w};
+  // Already in the open chunk; a failed log write only weakens durability
+  wal_append(st->wal, &rec, sizeof(rec));
+  return 0;
+}
+
+int ts_flush(ts_store_t *store) { return store ? seal(store) : -1; }
+
+void ts_set_durability(ts_store_t *store, wal_policy_t policy) {
+  if (store)
+    wal_set_policy(store->wal, policy);
+}
+
+int ts_sync(ts_store_t *store) { return store ? wal_sync(store->wal) : -1; }
+
+int64_t ts_compact(ts_store_t *st, const ts_retention_t *policy,
+                   int64_t now_ms, int64_t budget_bytes) {
+  if (st == NULL || policy == NULL)
+    return -1;
+  int64_t spent = 0;
+  while (spent < budget_bytes) {
+    int64_t cost = 0;
+    // 1. Expired chunks
+    if (policy->max_age_ms > 0 && st->nchunks > 0 &&
+        st->chunks[0].hdr.t_last < now_ms - policy->max_age_ms) {
+      cost = expire_chunks(st, now_ms - policy->max_age_ms);
+      goto next;
+    }
+    // 2. Raw samples past their age, oldest chunk first
+    if (policy->raw_age_ms > 0 && policy->downsample_ms > 0) {
+      for (size_t i = 0; i < st->nchunks; i++) {
+        if (st->chunks[i].hdr.t_last >= now_ms - policy->raw_age_ms)
+          break;
+        if (needs_downsample(&st->chunks[i], policy->downsample_ms)) {
+          cost = rewrite_chunks(st, i, 1, policy->downsample_ms);
+          goto next;
+        }
+      }
+    }
+    // 3. Runs of small chunks that fit in one
+    for (size_t i = 0; i + 1 < st->nchunks; i++) {
+      uint64_t total = st->chunks[i].hdr.count;
+      size_t n = 1;
+      while (i + n < st->nchunks &&
+             total + st->chunks[i + n].hdr.count <= TS_CHUNK_SAMPLES)
+        total += st->chunks[i + n++].hdr.count;
+      if (n > 1) {
+        cost = rewrite_chunks(st, i, n, 0);
+        goto next;
+      }
+    }
+    break; // nothing left to do
+  next:
+    if (cost < 0)
+      return -1;
+    spent += cost > 0 ? cost : 1;
+  }
+  return spent;
+}
+
+int64_t ts_scan(ts_store_t *st, int64_t from_ms, int64_t to_ms,
+                uint32_t columns, ts_scan_cb cb, void *ctx) {
+  if (st == NULL)
+    return -1;
+  uint32_t mask = (columns & TS_ALL_COLUMNS) | TS_COL(TS_COL_TIME);
+  int64_t visited = 0;
+  for (size_t i = 0; i < st->nchunks; i++) {
+    const chunk_meta_t *m = &st->chunks[i];
+    if (m->hdr.t_first >= to_ms)
+      return visited;
+    if (m->hdr.t_last < from_ms)
+      continue;
+    int rc = scan_sealed(st, m, mask, from_ms, to_ms, cb, ctx, &visited);
+    if (rc < 0)
+      return -1;
+    if (rc > 0)
+      return visited;
+  }
+  if (st->open.count == 0 || st->open.t_first >= to_ms ||
+      st->open.t_last < from_ms)
+    return visited;
+  if (scan_open(st, mask, from_ms, to_ms, cb, ctx, &visited) < 0)
+    return -1;
+  return visited;
+}
+
+// ============================================================
+// Aggregates
+// ============================================================
+
+typedef struct {
+  int64_t from_ms;
+  int64_t bucket_ms;
+  size_t n;
+  int column;
+  ts_aggregate_t *out;
+} bucket_ctx_t;
+
+static void agg_merge(ts_aggregate_t *a, int64_t count,
+                      const col_summary_t *s) {
+  if (count == 0)
+    return;
+  if (s->min < a->min)
+    a->min = s->min;
+  if (s->max > a->max)
+    a->max = s->max;
+  a->sum += s->sum;
+  a->count += count;
+}
+
+static int bucket_cb(const pdev_sample_t *batch, size_t n, void *ctx) {
+  bucket_ctx_t *b = ctx;
+  for (size_t i = 0; i < n; i++) {
+    size_t k = (size_t)((batch[i].t_ms - b->from_ms) / b->bucket_ms);
+    if (k >= b->n)
+      continue;
+    double v = sample_value(&batch[i], b->column);
+    col_summary_t one = {v, v, v};
+    agg_merge(&b->out[k], 1, &one);
+  }
+  return 0;
+}
+
+// True when [t_first, t_last] sits inside one bucket of the query
+static int within_bucket(const bucket_ctx_t *b, int64_t t_first,
+                         int64_t t_last, int64_t to_ms) {
+  return t_first >= b->from_ms && t_last < to_ms &&
+         (t_first - b->from_ms) / b->bucket_ms ==
+             (t_last - b->from_ms) / b->bucket_ms;
+}
+
+int ts_aggregate_buckets(ts_store_t *st, int64_t from_ms, int64_t to_ms,
+                         int64_t bucket_ms, int column, ts_aggregate_t *out,
+                         size_t max_buckets) {
+  if (st == NULL || out == NULL || column <= TS_COL_TIME ||
+      column >= TS_NCOLS || bucket_ms <= 0 || to_ms <= from_ms ||
+      max_buckets == 0)
+    return -1;
+  uint64_t span = (uint64_t)to_ms - (uint64_t)from_ms;
+  uint64_t nb = (span + (uint64_t)bucket_ms - 1) / (uint64_t)bucket_ms;
+  if (nb > max_buckets) {
+    nb = max_buckets;
+    to_ms = from_ms + (int64_t)nb * bucket_ms;
+  }
+  bucket_ctx_t b = {from_ms, bucket_ms, (size_t)nb, column, out};
+  for (size_t k = 0; k < b.n; k++)
+    out[k] = (ts_aggregate_t){0, INFINITY, -INFINITY, 0};
+  uint32_t mask = TS_COL(TS_COL_TIME) | TS_COL(column);
+  int64_t visited = 0;
+
+  // First chunk whose t_last reaches from_ms
+  size_t lo = 0, hi = st->nchunks;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    const index_entry_t *e = index_entry(st, mid);
+    int64_t t_last = e ? e->t_last : st->chunks[mid].hdr.t_last;
+    if (t_last < from_ms)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (size_t i = lo; i < st->nchunks; i++) {
+    const chunk_meta_t *m = &st->chunks[i];
+    if (m->hdr.t_first >= to_ms)
+      break;
+    const index_entry_t *e = index_entry(st, i);
+    if (e && within_bucket(&b, e->t_first, e->t_last, to_ms)) {
+      size_t k = (size_t)((e->t_first - from_ms) / bucket_ms);
+      agg_merge(&out[k], e->count, &e->cols[column]);
+      continue;
+    }
+    st->chunks_decoded++;
+    if (scan_sealed(st, m, mask, from_ms, to_ms, bucket_cb, &b, &visited) < 0)
+      return -1;
+  }
+  if (st->open.count > 0 && st->open.t_first < to_ms &&
+      st->open.t_last >= from_ms) {
+    if (within_bucket(&b, st->open.t_first, st->open.t_last, to_ms)) {
+      size_t k = (size_t)((st->open.t_first - from_ms) / bucket_ms);
+      agg_merge(&out[k], st->open.count, &st->open.sum[column]);
+    } else if (scan_open(st, mask, from_ms, to_ms, bucket_cb, &b, &visited) <
+               0) {
+      return -1;
+    }
+  }
+  for (size_t k = 0; k < b.n; k++)
+    if (out[k].count == 0)
+      out[k].min = out[k].max = 0;
+  return (int)b.n;
+}
+
+int ts_aggregate(ts_store_t *st, int64_t from_ms, int64_t to_ms, int column,
+                 ts_aggregate_t *out) {
+  if (st == NULL || out == NULL)
+    return -1;
+  ts_stats_t stats;
+  ts_stats(st, &stats);
+  *out = (ts_aggregate_t){0, 0, 0, 0};
+  if (stats.samples == 0)
+    return 0;
+  // Clamp sentinels like INT64_MIN/MAX to the stored range
+  if (from_ms < stats.first_ms)
+    from_ms = stats.first_ms;
+  if (to_ms > stats.last_ms + 1)
+    to_ms = stats.last_ms + 1;
+  if (to_ms <= from_ms)
+    return 0;
+  return ts_aggregate_buckets(st, from_ms, to_ms, to_ms - from_ms, column, out,
+                              1) < 0
+             ? -1
+             : 0;
+}
+
+void ts_stats(const ts_store_t *st, ts_stats_t *out) {
+  if (out == NULL)
+    return;
+  memset(out, 0, sizeof(*out));
+  if (st == NULL)
+    return;
+  out->chunks = st->nchunks;
+  out->chunks_decoded = st->chunks_decoded;
+  out->first_ms = INT64_MAX;
+  out->last_ms = INT64_MIN;
+  for (size_t i = 0; i < st->nchunks; i++) {
+    out->samples += st->chunks[i].hdr.count;
+    out->bytes += st->chunks[i].bytes;
+  }
+  if (st->nchunks > 0) {
+    out->first_ms = st->chunks[0].hdr.t_first;
+    out->last_ms = st->chunks[st->nchunks - 1].hdr.t_last;
+  }
+  if (st->open.count > 0) {
+    out->samples += st->open.count;
+    for (int c = 0; c < TS_NCOLS; c++)
+      out->bytes +=
+          (int64_t)st->open.col[c].len + (st->open.col[c].zeros ? 2 : 0);
+    out->bytes += (int64_t)fxor_bytes(&st->open.watts);
+    if (st->open.t_first < out->first_ms)
+      out->first_ms = st->open.t_first;
+    out->last_ms = st->open.t_last;
+  }
+  if (out->samples == 0)
+    out->first_ms = out->last_ms = 0;
+}
@@ -0,0 +1,118 @@
+//
+//  telemetry_store.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef telemetry_store_h
+#define telemetry_store_h
+
+#include "power_device.h"
+#include "wal.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-tick battery telemetry, stored column by column in time-ordered chunk
+// files. Timestamps are delta-of-delta encoded and the integer columns are
+// delta encoded; values are zigzag varints and runs of zero residuals
+// collapse into a single token, so a steady 1 Hz stream costs a few bytes
+// per sample. Watts go through the XOR float codec (float_codec.h).
+//
+// The open chunk lives in memory until it is sealed; its samples are also
+// written to open.wal (wal.h) and replayed from there after a crash.
+
+typedef enum {
+  TS_COL_TIME = 0, // always decoded: range filtering needs it
+  TS_COL_LEVEL,
+  TS_COL_AMPERAGE,
+  TS_COL_VOLTAGE,
+  TS_COL_TEMP,
+  TS_COL_FLAGS, // plugged | charging << 1
+  TS_COL_WATTS, // float32 precision, XOR-compressed
+  TS_NCOLS
+} ts_column_t;
+
+#define TS_COL(c) (1u << (c))
+#define TS_ALL_COLUMNS ((1u << TS_NCOLS) - 1)
+
+#define TS_CHUNK_SAMPLES 8192             // seal after this many samples
+#define TS_CHUNK_SPAN_MS (6 * 3600 * 1000) // ... or this much wall time
+
+typedef struct ts_store ts_store_t;
+
+// Opens the store rooted at dir (which must exist), recovering the open
+// chunk from its write-ahead log. Durability starts at WAL_POLICY_BALANCED.
+ts_store_t *ts_open(const char *dir);
+void ts_close(ts_store_t *store); // seals the open chunk
+
+// How long appended samples may sit in the OS cache before an fsync
+void ts_set_durability(ts_store_t *store, wal_policy_t policy);
+// Makes every appended sample durable now, e.g. before the system sleeps
+int ts_sync(ts_store_t *store);
+
+// Only t_ms, level, amperage_ma, voltage_mv, temp_cc, power_w, plugged and
+// charging are stored. Timestamps must increase; older samples are rejected.
+int ts_append(ts_store_t *store, const pdev_sample_t *sample);
+
+// Writes the open chunk out as a sealed chunk file
+int ts_flush(ts_store_t *store);
+
+// Batches of decoded samples, oldest first. Columns outside the mask are
+// left zero. Return nonzero to stop the scan.
+typedef int (*ts_scan_cb)(const pdev_sample_t *batch, size_t n, void *ctx);
+
+// Visits samples with from_ms <= t_ms < to_ms, reading only the requested
+// columns from disk; returns the number of samples visited or -1
+int64_t ts_scan(ts_store_t *store, int64_t from_ms, int64_t to_ms,
+                uint32_t columns, ts_scan_cb cb, void *ctx);
+
+// Summary of one column over a time range. Sealed chunks lying entirely
+// inside the range (or inside one bucket) are answered from the mmapped
+// chunk index without being decoded; only chunks straddling an edge are read.
+typedef struct {
+  int64_t count;
+  double min;
+  double max;
+  double sum; // mean = sum / count
+} ts_aggregate_t;
+
+int ts_aggregate(ts_store_t *store, int64_t from_ms, int64_t to_ms, int column,
+                 ts_aggregate_t *out);
+
+// Consecutive bucket_ms-wide buckets starting at from_ms (a real timestamp,
+// not a sentinel); returns the number of buckets filled or -1
+int ts_aggregate_buckets(ts_store_t *store, int64_t from_ms, int64_t to_ms,
+                         int64_t bucket_ms, int column, ts_aggregate_t *out,
+                         size_t max_buckets);
+
+// Retention. Chunks made only of samples older than raw_age_ms are rewritten
+// with one averaged sample per downsample_ms bucket; their index summaries
+// then describe the averages. Chunks that ended more than max_age_ms ago
+// are deleted (0 keeps everything). Runs of small adjacent chunks, such as
+// those sealed at low sampling rates, are merged into one.
+typedef struct {
+  int64_t raw_age_ms;
+  int64_t downsample_ms;
+  int64_t max_age_ms;
+} ts_retention_t;
+
+// Does compaction work until about budget_bytes have been read and written,
+// then returns, so it can be run in small steps between samples. Every
+// rewrite is atomic, index.tsi included. Returns the bytes spent (0 when
+// there is nothing left to do) or -1.
+int64_t ts_compact(ts_store_t *store, const ts_retention_t *policy,
+                   int64_t now_ms, int64_t budget_bytes);
+
+typedef struct {
+  size_t chunks; // sealed chunk files
+  int64_t samples;
+  int64_t bytes; // encoded column bytes, sealed and open
+  int64_t first_ms;
+  int64_t last_ms;
+  int64_t chunks_decoded; // by aggregate queries since open
+} ts_stats_t;
+
+void ts_stats(const ts_store_t *store, ts_stats_t *out);
+
+#endif
@@ -0,0 +1,128 @@
+//
+//  thermal_model.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "thermal_model.h"
+#include <math.h>
+#include <string.h>
+
+// Slopes are taken over at least a minute, which is enough to see through
+// the sensor's 0.1 degree steps at a 10 s poll; longer gaps mean sleep
+#define THM_MIN_STEP_MS 60000
+#define THM_MAX_GAP_MS 300000
+
+#define THM_FORGET 0.995     // per update: about 200 minutes of memory
+#define THM_COV_INIT 10.0
+#define THM_COV_MAX 1e4      // trace cap against windup while idle
+#define THM_READY_UPDATES 20 // minutes of data
+
+static void regressors(double temp, double i2, double w, double *phi) {
+  phi[0] = 1.0;
+  phi[1] = temp;
+  phi[2] = i2;
+  phi[3] = w;
+}
+
+// Recursive least squares with exponential forgetting
+static void rls_update(thm_model_t *m, const double *phi, double y) {
+  double pphi[THM_PARAMS];
+  double denom = THM_FORGET;
+  for (int i = 0; i < THM_PARAMS; i++) {
+    pphi[i] = 0;
+    for (int j = 0; j < THM_PARAMS; j++)
+      pphi[i] += m->cov[i][j] * phi[j];
+    denom += phi[i] * pphi[i];
+  }
+  double err = y;
+  for (int i = 0; i < THM_PARAMS; i++)
+    err -= m->theta[i] * phi[i];
+  double trace = 0;
+  for (int i = 0; i < THM_PARAMS; i++) {
+    double k = pphi[i] / denom;
+    m->theta[i] += k * err;
+    for (int j = 0; j < THM_PARAMS; j++)
+      m->cov[i][j] = (m->cov[i][j] - k * pphi[j]) / THM_FORGET;
+    trace += m->cov[i][i];
+  }
+  if (trace > THM_COV_MAX) {
+    double scale = THM_COV_MAX / trace;
+    for (int i = 0; i < THM_PARAMS; i++)
+      for (int j = 0; j < THM_PARAMS; j++)
+        m->cov[i][j] *= scale;
+  }
+}
+
+static double current_sq(int32_t amperage_ma) {
+  double a = amperage_ma / 1000.0;
+  return a * a;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void thm_init(thm_model_t *m) {
+  memset(m, 0, sizeof(*m));
+  // Prior: 25 degree room, 20 minute time constant, no heating terms
+  m->theta[0] = 25.0 / 20.0;
+  m->theta[1] = -1.0 / 20.0;
+  for (int i = 0; i < THM_PARAMS; i++)
+    m->cov[i][i] = THM_COV_INIT;
+}
+
+void thm_update(thm_model_t *m, const pdev_sample_t *s) {
+  if (m == NULL || s == NULL || !s->valid || s->temp_cc == 0)
+    return;
+  double temp = s->temp_cc / 100.0;
+  double i2 = current_sq(s->amperage_ma);
+  m->temp = temp;
+  if (!m->have_last || s->t_ms - m->last_ms > THM_MAX_GAP_MS ||
+      s->t_ms < m->last_ms) {
+    m->last_ms = s->t_ms;
+    m->last_temp = temp;
+    m->last_i2 = i2;
+    m->last_w = s->power_w;
+    m->have_last = 1;
+    return;
+  }
+  if (s->t_ms - m->last_ms < THM_MIN_STEP_MS)
+    return;
+
+  // Inputs at the start of the step explain the slope over it
+  double minutes = (double)(s->t_ms - m->last_ms) / 60000.0;
+  double phi[THM_PARAMS];
+  regressors(m->last_temp, m->last_i2, m->last_w, phi);
+  rls_update(m, phi, (temp - m->last_temp) / minutes);
+  m->updates++;
+
+  m->last_ms = s->t_ms;
+  m->last_temp = temp;
+  m->last_i2 = i2;
+  m->last_w = s->power_w;
+}
+
+int thm_ready(const thm_model_t *m) {
+  // b must pull towards equilibrium with a time constant under ~16 hours
+  return m && m->updates >= THM_READY_UPDATES && m->theta[1] < -1e-3;
+}
+
+int32_t thm_forecast(const thm_model_t *m, int64_t horizon_s,
+                     int32_t amperage_ma, float watts) {
+  if (m == NULL || !m->have_last)
+    return 0;
+  if (!thm_ready(m) || horizon_s <= 0)
+    return (int32_t)lround(m->temp * 100.0);
+  // Exact solution of the linear ODE with the inputs held constant
+  const double *th = m->theta;
+  double drive = th[0] + th[2] * current_sq(amperage_ma) + th[3] * watts;
+  double eq = -drive / th[1];
+  double t = eq + (m->temp - eq) * exp(th[1] * (double)horizon_s / 60.0);
+  if (t < -20.0)
+    t = -20.0;
+  if (t > 100.0)
+    t = 100.0;
+  return (int32_t)lround(t * 100.0);
+}
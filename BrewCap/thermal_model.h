@@ -0,0 +1,54 @@
+//
+//  thermal_model.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef thermal_model_h
+#define thermal_model_h
+
+#include "power_device.h"
+#include <stdint.h>
+
+// First-order RC model of battery temperature, fitted online:
+//
+//   dT/dt = a + b*T + c*I^2 + d*P
+//
+// b = -1/tau pulls T towards ambient, I^2 is Joule heating from the battery
+// current and P is the system draw warming the chassis. The coefficients
+// come from recursive least squares with exponential forgetting, so the fit
+// follows the room and the workload. An update or a forecast is a few dozen
+// floating-point operations.
+
+#define THM_PARAMS 4
+
+typedef struct {
+  double theta[THM_PARAMS]; // a, b, c, d; time in minutes, T in degrees C
+  double cov[THM_PARAMS][THM_PARAMS];
+  int64_t updates; // slopes the fit has learned from
+  double temp;     // latest reading, degrees C; forecasts start here
+  // Start of the slope being measured
+  int64_t last_ms;
+  double last_temp; // degrees C
+  double last_i2;   // A^2
+  double last_w;
+  int have_last;
+} thm_model_t;
+
+void thm_init(thm_model_t *m);
+
+// Folds in one sample. Gaps longer than a few minutes (sleep) restart the
+// slope estimate instead of teaching the fit a bogus rate.
+void thm_update(thm_model_t *m, const pdev_sample_t *sample);
+
+// Enough samples, and a fit that actually relaxes towards an equilibrium
+int thm_ready(const thm_model_t *m);
+
+// Temperature horizon_s from the last sample, in centi-degrees C, if the
+// battery current and system draw stay at amperage_ma and watts. Returns
+// the last temperature when the model is not ready.
+int32_t thm_forecast(const thm_model_t *m, int64_t horizon_s,
+                     int32_t amperage_ma, float watts);
+
+#endif
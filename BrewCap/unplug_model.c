@@ -0,0 +1,138 @@
+//
+//  unplug_model.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "unplug_model.h"
+#include <math.h>
+#include <string.h>
+
+#define HOUR_MS 3600000LL
+#define WEEK_MS (168 * HOUR_MS)
+#define UPM_RESCALE 1e12 // weight at which the bins are brought back to 1
+#define UPM_STEP_MS (15 * 60000LL)
+
+static double tau_h(void) { return UPM_HALF_LIFE_H / M_LN2; }
+
+// 1970-01-01 was a Thursday; bin 0 is Monday 00:00
+static int bin_of(int64_t t_ms) {
+  int64_t h = (t_ms / HOUR_MS + 72) % 168;
+  return (int)(h < 0 ? h + 168 : h);
+}
+
+static double weight(const upm_model_t *m, int64_t t_ms) {
+  return exp((double)(t_ms - m->epoch_ms) / HOUR_MS / tau_h());
+}
+
+// Weight for an event at t_ms, moving the epoch up when weights get large
+static double event_weight(upm_model_t *m, int64_t t_ms) {
+  if (!m->have_epoch) {
+    m->epoch_ms = t_ms;
+    m->have_epoch = 1;
+  }
+  double w = weight(m, t_ms);
+  if (w > UPM_RESCALE) {
+    for (int b = 0; b < UPM_BINS; b++) {
+      m->unplugs[b] /= w;
+      m->exposure[b] /= w;
+    }
+    m->total /= w;
+    m->epoch_ms = t_ms;
+    w = 1.0;
+  }
+  return w;
+}
+
+static void add_unplug(upm_model_t *m, int64_t t_ms) {
+  double w = event_weight(m, t_ms);
+  m->unplugs[bin_of(t_ms)] += w;
+  m->total += w;
+}
+
+static void add_exposure(upm_model_t *m, int64_t t_ms, int64_t dt_ms) {
+  m->exposure[bin_of(t_ms)] += event_weight(m, t_ms) * (double)dt_ms / HOUR_MS;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void upm_init(upm_model_t *m) {
+  if (m == NULL)
+    return;
+  memset(m, 0, sizeof(*m));
+  m->version = UPM_MODEL_VERSION;
+}
+
+void upm_session(upm_model_t *m, int64_t start_ms, int64_t end_ms) {
+  if (m == NULL || end_ms <= start_ms)
+    return;
+  // A machine left on AC for weeks says nothing more than two weeks does
+  if (end_ms - start_ms > 2 * WEEK_MS)
+    start_ms = end_ms - 2 * WEEK_MS;
+  int64_t t = start_ms;
+  while (t < end_ms) {
+    int64_t next = (t / HOUR_MS + 1) * HOUR_MS;
+    if (next > end_ms)
+      next = end_ms;
+    add_exposure(m, t, next - t);
+    t = next;
+  }
+  add_unplug(m, end_ms);
+}
+
+void upm_sample(upm_model_t *m, int64_t t_ms, int plugged) {
+  if (m == NULL)
+    return;
+  if (m->have_last && m->plugged) {
+    int64_t dt = t_ms - m->last_ms;
+    if (dt > 0 && dt <= UPM_MAX_GAP_MS)
+      add_exposure(m, m->last_ms, dt);
+    if (!plugged)
+      add_unplug(m, t_ms);
+  }
+  m->last_ms = t_ms;
+  m->plugged = plugged != 0;
+  m->have_last = 1;
+}
+
+double upm_hazard(const upm_model_t *m, int64_t t_ms) {
+  if (m == NULL || !m->have_epoch)
+    return 0;
+  int b = bin_of(t_ms);
+  double w = weight(m, t_ms);
+  return (m->unplugs[b] / w) / (m->exposure[b] / w + UPM_PRIOR_HOURS);
+}
+
+double upm_probability(const upm_model_t *m, int64_t t_ms, int64_t window_ms) {
+  if (m == NULL || !m->have_epoch || window_ms <= 0 ||
+      m->total / weight(m, t_ms) < UPM_MIN_UNPLUGS)
+    return 0;
+  // Integrated hazard over the window, one hour bin at a time
+  double lambda = 0;
+  int64_t t = t_ms, end = t_ms + window_ms;
+  while (t < end) {
+    int64_t next = (t / HOUR_MS + 1) * HOUR_MS;
+    if (next > end)
+      next = end;
+    lambda += upm_hazard(m, t) * (double)(next - t) / HOUR_MS;
+    t = next;
+  }
+  return 1.0 - exp(-lambda);
+}
+
+int64_t upm_likely_unplug(const upm_model_t *m, int64_t t_ms,
+                          int64_t horizon_ms) {
+  if (m == NULL || !m->have_epoch ||
+      m->total / weight(m, t_ms) < UPM_MIN_UNPLUGS)
+    return 0;
+  double lambda = 0;
+  for (int64_t t = t_ms; t < t_ms + horizon_ms; t += UPM_STEP_MS) {
+    lambda += upm_hazard(m, t) * (double)UPM_STEP_MS / HOUR_MS;
+    if (lambda >= M_LN2) // 1 - exp(-lambda) >= 0.5
+      return t + UPM_STEP_MS;
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+//
+//  unplug_model.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef unplug_model_h
+#define unplug_model_h
+
+#include <stdint.h>
+
+// When the charger tends to be unplugged, as an unplug rate per hour of the
+// week: decayed unplugs in each of the 168 hours over the decayed time spent
+// plugged in during that hour. Sailing Mode uses it to top up just before a
+// likely unplug instead of holding at the limit through it.
+//
+// Decay is exponential with UPM_HALF_LIFE_H. Rather than shrinking every bin
+// as time passes, new events are weighted up by exp(t / tau) against a
+// moving epoch, so an event or a sample is O(1); the bins are rescaled only
+// when the weights grow large, about once every few years of use.
+//
+// Times are local (ms since 1970 plus the UTC offset) so hours of the week
+// follow the user's clock.
+
+#define UPM_BINS 168
+#define UPM_HALF_LIFE_H (28 * 24)
+#define UPM_MAX_GAP_MS 3600000 // longer gaps in a plugged stream: asleep, unknown
+#define UPM_MIN_UNPLUGS 3.0    // decayed unplugs before anything is predicted
+#define UPM_PRIOR_HOURS 0.25   // exposure with no unplugs added to every bin
+#define UPM_MODEL_VERSION 1    // changes with the layout of upm_model_t
+
+typedef struct {
+  int32_t version;           // UPM_MODEL_VERSION, checked on restore
+  double unplugs[UPM_BINS];  // weighted counts
+  double exposure[UPM_BINS]; // weighted plugged-in hours
+  double total;              // weighted unplugs over all bins
+  int64_t epoch_ms;          // weights are exp((t - epoch) / tau)
+  int have_epoch;
+  // Sample stream
+  int64_t last_ms;
+  int plugged;
+  int have_last;
+} upm_model_t;
+
+void upm_init(upm_model_t *m);
+
+// One plugged-in period from history; O(its length in hours)
+void upm_session(upm_model_t *m, int64_t start_ms, int64_t end_ms);
+
+// One sample of the live stream; an unplug is the plugged -> unplugged edge
+void upm_sample(upm_model_t *m, int64_t t_ms, int plugged);
+
+// Unplugs per plugged-in hour in the hour of the week holding t_ms
+double upm_hazard(const upm_model_t *m, int64_t t_ms);
+
+// Chance of an unplug within window_ms of t_ms, if plugged in at t_ms; 0
+// until UPM_MIN_UNPLUGS have been seen
+double upm_probability(const upm_model_t *m, int64_t t_ms, int64_t window_ms);
+
+// The time by which an unplug becomes more likely than not, searching up to
+// horizon_ms ahead in 15 minute steps; 0 if it does not within the horizon
+int64_t upm_likely_unplug(const upm_model_t *m, int64_t t_ms,
+                          int64_t horizon_ms);
+
+#endif
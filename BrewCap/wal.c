@@ -0,0 +1,210 @@
+//
+//  wal.c
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#include "wal.h"
+#include "store_util.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// File layout: 16-byte header, then frames of
+//   uint32 len | payload[len] | uint32 crc  (CRC-32 of len and payload)
+#define WAL_MAGIC 0x4C574342u // "BCWL" little-endian
+#define WAL_VERSION 1u
+#define WAL_HEADER 16
+#define WAL_FRAME_OVERHEAD 8
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t max_record;
+  uint32_t reserved;
+} wal_header_t;
+
+struct wal {
+  int fd;
+  wal_policy_t policy;
+  int64_t size;            // bytes in the file, header included
+  uint32_t unsynced;       // bytes written since the last sync
+  int64_t oldest_unsynced; // monotonic ms of the first of them
+  int64_t records;
+  int64_t syncs;
+};
+
+static int64_t monotonic_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int write_header(int fd) {
+  wal_header_t hdr = {WAL_MAGIC, WAL_VERSION, WAL_MAX_RECORD, 0};
+  if (ftruncate(fd, 0) != 0 ||
+      pwrite(fd, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr))
+    return -1;
+  return 0;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+wal_t *wal_open(const char *path, wal_policy_t policy) {
+  int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "wal: cannot open %s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return NULL;
+  }
+  wal_header_t hdr;
+  if (st.st_size < WAL_HEADER) {
+    if (write_header(fd) != 0 || store_sync(fd) != 0) {
+      fprintf(stderr, "wal: cannot initialise %s\n", path);
+      close(fd);
+      return NULL;
+    }
+    st.st_size = WAL_HEADER;
+  } else if (store_pread_all(fd, &hdr, sizeof(hdr), 0) != 0 ||
+             hdr.magic != WAL_MAGIC || hdr.max_record != WAL_MAX_RECORD) {
+    fprintf(stderr, "wal: %s is not a write-ahead log\n", path);
+    close(fd);
+    return NULL;
+  }
+
+  wal_t *wal = calloc(1, sizeof(wal_t));
+  if (wal == NULL) {
+    close(fd);
+    return NULL;
+  }
+  wal->fd = fd;
+  wal->policy = policy;
+  wal->size = st.st_size;
+  return wal;
+}
+
+void wal_close(wal_t *wal) {
+  if (wal == NULL)
+    return;
+  wal_sync(wal);
+  close(wal->fd);
+  free(wal);
+}
+
+void wal_set_policy(wal_t *wal, wal_policy_t policy) {
+  if (wal == NULL)
+    return;
+  wal->policy = policy;
+  // A tighter budget applies to what is already pending
+  if (wal->unsynced > 0 &&
+      (wal->unsynced >= policy.max_bytes ||
+       monotonic_ms() - wal->oldest_unsynced >= policy.max_delay_ms))
+    wal_sync(wal);
+}
+
+int wal_append(wal_t *wal, const void *data, uint32_t len) {
+  if (wal == NULL || (data == NULL && len > 0) || len > WAL_MAX_RECORD)
+    return -1;
+  uint8_t frame[WAL_MAX_RECORD + WAL_FRAME_OVERHEAD];
+  memcpy(frame, &len, 4);
+  memcpy(frame + 4, data, len);
+  uint32_t crc = store_crc32(frame, 4 + (size_t)len);
+  memcpy(frame + 4 + len, &crc, 4);
+
+  // One write per frame: a crash can tear only the last one
+  size_t n = len + WAL_FRAME_OVERHEAD;
+  if (store_write_all(wal->fd, frame, n) != 0) {
+    fprintf(stderr, "wal: append failed: %s\n", strerror(errno));
+    return -1;
+  }
+  int64_t now = monotonic_ms();
+  if (wal->unsynced == 0)
+    wal->oldest_unsynced = now;
+  wal->unsynced += (uint32_t)n;
+  wal->size += (int64_t)n;
+  wal->records++;
+
+  if (wal->unsynced >= wal->policy.max_bytes ||
+      now - wal->oldest_unsynced >= wal->policy.max_delay_ms)
+    return wal_sync(wal);
+  return 0;
+}
+
+int wal_sync(wal_t *wal) {
+  if (wal == NULL)
+    return -1;
+  if (wal->unsynced == 0)
+    return 0;
+  if (store_sync(wal->fd) != 0) {
+    fprintf(stderr, "wal: sync failed: %s\n", strerror(errno));
+    return -1;
+  }
+  wal->unsynced = 0;
+  wal->syncs++;
+  return 0;
+}
+
+int64_t wal_replay(wal_t *wal, wal_replay_cb cb, void *ctx) {
+  if (wal == NULL)
+    return -1;
+  uint8_t frame[WAL_MAX_RECORD + WAL_FRAME_OVERHEAD];
+  int64_t off = WAL_HEADER, n = 0;
+  int stop = 0;
+  while (!stop && off + WAL_FRAME_OVERHEAD <= wal->size) {
+    uint32_t len, crc;
+    if (store_pread_all(wal->fd, &len, 4, off) != 0 || len > WAL_MAX_RECORD ||
+        off + len + WAL_FRAME_OVERHEAD > wal->size ||
+        store_pread_all(wal->fd, frame, 4 + (size_t)len + 4, off) != 0)
+      break;
+    memcpy(&crc, frame + 4 + len, 4);
+    if (crc != store_crc32(frame, 4 + (size_t)len))
+      break;
+    if (cb)
+      stop = cb(frame + 4, len, ctx);
+    off += len + WAL_FRAME_OVERHEAD;
+    n++;
+  }
+  if (!stop && off < wal->size) {
+    fprintf(stderr, "wal: dropping %lld bytes of torn tail\n",
+            (long long)(wal->size - off));
+    if (ftruncate(wal->fd, (off_t)off) != 0)
+      return -1;
+    wal->size = off;
+  }
+  return n;
+}
+
+int wal_reset(wal_t *wal) {
+  if (wal == NULL)
+    return -1;
+  if (write_header(wal->fd) != 0 || store_sync(wal->fd) != 0) {
+    fprintf(stderr, "wal: reset failed: %s\n", strerror(errno));
+    return -1;
+  }
+  wal->size = WAL_HEADER;
+  wal->unsynced = 0;
+  return 0;
+}
+
+void wal_stats(const wal_t *wal, wal_stats_t *out) {
+  if (out == NULL)
+    return;
+  memset(out, 0, sizeof(*out));
+  if (wal == NULL)
+    return;
+  out->records = wal->records;
+  out->syncs = wal->syncs;
+  out->unsynced_bytes = wal->unsynced;
+}
@@ -0,0 +1,62 @@
+//
+//  wal.h
+//  BrewCap
+//
+//  Copyright (c) 2026 NorthStars Industries. All rights reserved.
+//
+
+#ifndef wal_h
+#define wal_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Write-ahead log for history that is built up in memory before it reaches
+// its final file. Every record is written to the log as it arrives, so an
+// app crash loses nothing; the fsync that makes it survive power loss is
+// group-committed once the unsynced records exceed a time or size budget.
+// Records are checksummed and recovery stops at the last intact one.
+
+// The durability knob. Zero in both fields syncs every record.
+typedef struct {
+  uint32_t max_delay_ms; // oldest unsynced record may wait this long
+  uint32_t max_bytes;    // ... or this many bytes may pile up
+} wal_policy_t;
+
+#define WAL_POLICY_STRICT ((wal_policy_t){0, 0})
+#define WAL_POLICY_BALANCED ((wal_policy_t){5 * 60 * 1000, 4096})
+#define WAL_POLICY_LAZY ((wal_policy_t){60 * 60 * 1000, 64 * 1024})
+
+#define WAL_MAX_RECORD 4096
+
+typedef struct wal wal_t;
+
+// Opens (creating if needed) the log at path
+wal_t *wal_open(const char *path, wal_policy_t policy);
+void wal_close(wal_t *wal); // syncs first
+
+void wal_set_policy(wal_t *wal, wal_policy_t policy);
+
+// Writes one record and syncs if the policy's budget is spent
+int wal_append(wal_t *wal, const void *data, uint32_t len);
+
+// Forces an fsync of everything appended so far
+int wal_sync(wal_t *wal);
+
+// Calls cb for each intact record, oldest first, and truncates anything after
+// the last one (a torn or corrupt tail). Returns the record count or -1.
+typedef int (*wal_replay_cb)(const void *data, uint32_t len, void *ctx);
+int64_t wal_replay(wal_t *wal, wal_replay_cb cb, void *ctx);
+
+// Empties the log once its records are safely in their final file
+int wal_reset(wal_t *wal);
+
+typedef struct {
+  int64_t records; // appended since open
+  int64_t syncs;
+  uint32_t unsynced_bytes;
+} wal_stats_t;
+
+void wal_stats(const wal_t *wal, wal_stats_t *out);
+
+#endif